@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cmath>
+
+#include "adaptiveQuality.h"
+#include "findCoins.h"
+
+
+const QualityLevel qualityLevels[numberOfQualityLevels] = {
+        {"full",     maxSourceDimension, 0, MatcherType::packed,       1, 0, 30.0, 0.50},
+        {"fastBlur", maxSourceDimension, 1, MatcherType::coarseToFine, 1, 0, 10.0, 0.20},
+        {"reduced",  1800,               1, MatcherType::coarseToFine, 2, 4, 10.0, 0.08},
+        {"draft",    1280,               2, MatcherType::coarseToFine, 3, 2, 7.0,  0.04},
+        {"minimal",  960,                2, MatcherType::coarseToFine, 6, 2, 7.0,  0.02}
+};
+
+// Weight of the newest measurement in the averaged speed factors
+const double costSmoothing{0.3};
+
+// Levels are picked so their estimate fills at most this share of the time available
+const double estimateMargin{0.9};
+
+
+/* settingsForLevel
+ * Precondition: 0 <= level < numberOfQualityLevels.
+ * Postcondition: Returns settings with the pyramid and matcher effort of level, or unchanged for level 0.
+ */
+DetectionSettings settingsForLevel(const DetectionSettings &settings, int level) {
+    DetectionSettings levelSettings = settings;
+    if (level == 0) {
+        return levelSettings;
+    }
+    const QualityLevel &quality = qualityLevels[level];
+    levelSettings.pyramidLevels = std::max(settings.pyramidLevels, quality.pyramidLevels);
+    levelSettings.matcher = quality.matcher;
+    levelSettings.angleStep = quality.angleStep;
+    levelSettings.templatesRefined = quality.templatesRefined;
+    levelSettings.compareMatchers = false;
+    levelSettings.compareDetection = false;
+    return levelSettings;
+}
+
+
+/* workingSizeFor
+ * Precondition: 0 <= level < numberOfQualityLevels.
+ * Postcondition: Returns imageSize scaled down to the working dimension of level, as resizeSourceImage would.
+ */
+cv::Size workingSizeFor(const cv::Size &imageSize, int level) {
+    int maxDim = qualityLevels[level].workingDimension;
+    if (imageSize.width <= maxDim && imageSize.height <= maxDim) {
+        return imageSize;
+    }
+    double ratio = (double) maxDim / std::max(imageSize.width, imageSize.height);
+    return cv::Size((int) std::round(imageSize.width * ratio), (int) std::round(imageSize.height * ratio));
+}
+
+
+/* QualityController
+ * Precondition: budgetMs > 0 and numThreads > 0.
+ * Postcondition: The controller expects every level to cost what qualityLevels says.
+ */
+QualityController::QualityController(double budgetMs, int numThreads)
+        : budgetMs(budgetMs), numThreads(std::max(1, numThreads)) {
+}
+
+
+/* chooseDetectionLevel
+ * Precondition: None
+ * Postcondition: Returns the best level expected to find the candidates of imageSize in detectionShare of the budget.
+ */
+int QualityController::chooseDetectionLevel(const cv::Size &imageSize) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int level = 0; level < numberOfQualityLevels; level++) {
+        cv::Size workingSize = workingSizeFor(imageSize, level);
+        double expectedMs = qualityLevels[level].detectCost * detectSpeed * workingSize.area() / 1e6;
+        if (expectedMs <= budgetMs * detectionShare) {
+            return level;
+        }
+    }
+    return numberOfQualityLevels - 1;
+}
+
+
+/* chooseClassificationLevel
+ * Precondition: candidatesLeft > 0.
+ * Postcondition: Returns the best level from minimumLevel on expected to classify candidatesLeft in msLeft.
+ */
+int QualityController::chooseClassificationLevel(int candidatesLeft, double msLeft, int minimumLevel) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int level = minimumLevel; level < numberOfQualityLevels; level++) {
+        // The candidates are spread over the workers
+        double expectedMs = qualityLevels[level].classifyCost * classifySpeed * candidatesLeft / numThreads;
+        if (expectedMs <= msLeft * estimateMargin) {
+            return level;
+        }
+    }
+    return numberOfQualityLevels - 1;
+}
+
+
+/* recordDetection
+ * Precondition: Steps 1 and 2 ran at level on an image of workingSize and took ms.
+ * Postcondition: detectSpeed moves toward the measured over the expected cost.
+ */
+void QualityController::recordDetection(int level, const cv::Size &workingSize, double ms) {
+    double expectedMs = qualityLevels[level].detectCost * workingSize.area() / 1e6;
+    if (expectedMs <= 0.0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    detectSpeed += costSmoothing * (ms / expectedMs - detectSpeed);
+}
+
+
+/* recordClassification
+ * Precondition: numCandidates > 0 candidates were classified at level in ms.
+ * Postcondition: classifySpeed moves toward the measured over the expected cost. Time lost to other images sharing
+ *                the workers counts as cost, so a busy pool steps the levels down.
+ */
+void QualityController::recordClassification(int level, int numCandidates, double ms) {
+    double expectedMs = qualityLevels[level].classifyCost * numCandidates / numThreads;
+    std::lock_guard<std::mutex> lock(mutex);
+    classifySpeed += costSmoothing * (ms / expectedMs - classifySpeed);
+}
+
+
+double QualityController::budget() const {
+    return budgetMs;
+}
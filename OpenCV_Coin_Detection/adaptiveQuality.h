@@ -0,0 +1,138 @@
+//==============================================================================
+// Adaptive Quality
+//------------------------------------------------------------------------------
+// Keeps CoinDetector::detect within a time budget per image (--time-budget)
+// by trading detection quality for time. The quality levels, best first:
+//
+//      level  name      working size  pyramid  matcher         angles  refined
+//      0      full      2500          settings settings        every   all
+//      1      fastBlur  2500          1        coarse-to-fine  every   all
+//      2      reduced   1800          1        coarse-to-fine  2nd     4
+//      3      draft     1280          2        coarse-to-fine  3rd     2
+//      4      minimal   960           2        coarse-to-fine  6th     2
+//
+// Level 0 is exactly what detect does without a budget. The others search
+// the image downscaled to a smaller working size, find its contours on a
+// pyramid level, and match only every angleStep-th template rotation and the
+// templatesRefined best templates by coarse score.
+//
+// A QualityController estimates what each level costs on this machine and
+// picks the levels for an image: Steps 1 and 2 get the best level expected
+// to take at most detectionShare of the budget, and then the candidates are
+// classified a few at a time, each group at the best level that leaves time
+// for the candidates still waiting. So an image with few coins keeps full
+// quality, while one with hundreds of candidates, or one that arrives while
+// the workers are busy, steps down. The estimates are corrected after every
+// step from the times actually measured.
+//
+// The budget is a target, not a hard limit: a step that has started is never
+// interrupted, so an image whose fastest level still costs more than its
+// budget runs over. tests/testTimeBudget measures how well the budget is 
+// kept on synthetic scenes with many coins.
+//==============================================================================
+
+#ifndef ADAPTIVE_QUALITY_H
+#define ADAPTIVE_QUALITY_H
+
+#include <mutex>
+#include <string>
+
+#include "opencv2/core.hpp"
+
+#include "detectionSettings.h"
+#include "templateBank.h"
+#include "workerPool.h"
+
+
+struct QualityLevel {
+    const char *name;
+    int workingDimension;       // images are searched downscaled to at most this many pixels on a side
+    int pyramidLevels;          // DetectionSettings of the same names
+    MatcherType matcher;
+    int angleStep;
+    int templatesRefined;
+    double detectCost;          // expected ms per working megapixel of Steps 1 and 2, on a typical core
+    double classifyCost;        // expected ms per candidate of Steps 3 to 6, on a typical core
+};
+
+const int numberOfQualityLevels{5};
+
+// Indexed by level, best quality first. Level 0's matcher settings are unused, it keeps the detector's own
+extern const QualityLevel qualityLevels[numberOfQualityLevels];
+
+// Steps 1 and 2 may use up to this share of the budget, the rest is left for classifying the candidates
+const double detectionShare{0.4};
+
+
+/*----------------------------- settingsForLevel -------------------------------
+ * Precondition:  0 <= level < numberOfQualityLevels.
+ * Postcondition: Returns settings unchanged for level 0, otherwise settings
+ *                with the pyramid, matcher, angleStep and templatesRefined of
+ *                the level.
+ */
+DetectionSettings settingsForLevel(const DetectionSettings &settings, int level);
+
+
+/*-------------------------------- workingSizeFor ------------------------------
+ * Precondition:  0 <= level < numberOfQualityLevels.
+ * Postcondition: Returns the size resizeSourceImage gives imageSize when the
+ *                image is searched at level.
+ */
+cv::Size workingSizeFor(const cv::Size &imageSize, int level);
+
+
+class QualityController {
+public:
+
+    /*----------------------------- QualityController --------------------------
+     * Precondition:  budgetMs > 0 and numThreads > 0.
+     * Postcondition: Creates a controller for a budget of budgetMs per image
+     *                whose candidates are classified on numThreads threads,
+     *                starting from the costs of qualityLevels.
+     */
+    QualityController(double budgetMs, int numThreads);
+
+    /*---------------------------- chooseDetectionLevel ------------------------
+     * Precondition:  None
+     * Postcondition: Returns the best level whose Steps 1 and 2 are expected
+     *                to take at most detectionShare of the budget on an image
+     *                of imageSize, or the fastest level if none is.
+     */
+    int chooseDetectionLevel(const cv::Size &imageSize) const;
+
+    /*------------------------- chooseClassificationLevel ----------------------
+     * Precondition:  candidatesLeft > 0.
+     * Postcondition: Returns the best level expected to classify
+     *                candidatesLeft candidates in msLeft milliseconds, or the
+     *                fastest level if none is. Never better than minimumLevel.
+     */
+    int chooseClassificationLevel(int candidatesLeft, double msLeft, int minimumLevel) const;
+
+    /*------------------------------ recordDetection ---------------------------
+     * Precondition:  Steps 1 and 2 ran at level on an image of workingSize.
+     * Postcondition: The detection cost estimates are corrected by the ms
+     *                they took.
+     */
+    void recordDetection(int level, const cv::Size &workingSize, double ms);
+
+    /*---------------------------- recordClassification ------------------------
+     * Precondition:  numCandidates > 0 candidates were classified at level.
+     * Postcondition: The classification cost estimates are corrected by the
+     *                ms they took.
+     */
+    void recordClassification(int level, int numCandidates, double ms);
+
+    double budget() const;
+
+private:
+    mutable std::mutex mutex;
+    const double budgetMs;
+    const int numThreads;
+
+    // Measured cost over the cost qualityLevels expects, averaged over the recent images. One factor for all the
+    // levels, so the estimates of levels that have not run yet follow the ones that have.
+    double detectSpeed{1.0};
+    double classifySpeed{1.0};
+};
+
+#endif
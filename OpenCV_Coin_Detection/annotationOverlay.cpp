@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include "annotationOverlay.h"
+#include "detectionRecord.h"
+#include "findCoins.h"
+#include "imageDecoder.h"
+#include "imagePipeline.h"
+#include "stageTrace.h"
+#include "templateBank.h"
+
+
+/* templateName
+ * Precondition: templateIndex is a CoinTemplate.
+ * Postcondition: Returns the file name of the template without its extension, e.g. "pennyHeads".
+ */
+static std::string templateName(int templateIndex) {
+    return std::filesystem::path(templateFileNames[templateIndex]).stem().string();
+}
+
+
+/* xmlText
+ * Precondition: None
+ * Postcondition: Returns text with the characters XML reserves replaced by entities.
+ */
+static std::string xmlText(const std::string &text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            default: escaped += c;
+        }
+    }
+    return escaped;
+}
+
+
+/* scaleDetections
+ * Precondition: detections were found in an image of fromSize.
+ * Postcondition: The bounding rectangles and ellipses of detections are in the coordinates of an image of toSize.
+ */
+static void scaleDetections(std::vector<CoinDetection> &detections, const cv::Size &fromSize,
+                            const cv::Size &toSize) {
+    if (fromSize == toSize || fromSize.area() == 0) {
+        return;
+    }
+
+    // Pixel centre to pixel centre, as the detector scales candidates back to the image it was given
+    double scaleX = (double) toSize.width / fromSize.width;
+    double scaleY = (double) toSize.height / fromSize.height;
+    for (CoinDetection &candidate : detections) {
+        const cv::Rect &fromRect = candidate.boundingRect;
+        int left = (int) std::floor(fromRect.x * scaleX);
+        int top = (int) std::floor(fromRect.y * scaleY);
+        int right = (int) std::ceil((fromRect.x + fromRect.width) * scaleX);
+        int bottom = (int) std::ceil((fromRect.y + fromRect.height) * scaleY);
+        candidate.boundingRect = cv::Rect(left, top, right - left, bottom - top) &
+                                 cv::Rect(0, 0, toSize.width, toSize.height);
+
+        cv::RotatedRect &ellipse = candidate.ellipse;
+        ellipse.center = cv::Point2f((float) ((ellipse.center.x + 0.5) * scaleX - 0.5),
+                                     (float) ((ellipse.center.y + 0.5) * scaleY - 0.5));
+        ellipse.size = cv::Size2f((float) (ellipse.size.width * scaleX), (float) (ellipse.size.height * scaleY));
+    }
+}
+
+
+/* overlayPathFor
+ * Precondition: format is not none.
+ * Postcondition: Returns imagePath with its extension replaced by ".overlay.svg" or ".overlay.json".
+ */
+std::string overlayPathFor(const std::string &imagePath, OverlayFormat format) {
+    std::filesystem::path overlayPath(imagePath);
+    overlayPath.replace_extension(format == OverlayFormat::svg ? ".overlay.svg" : ".overlay.json");
+    return overlayPath.string();
+}
+
+
+/* previewFileName
+ * Precondition: None
+ * Postcondition: Returns the stem of imageName followed by "_preview.jpg".
+ */
+std::string previewFileName(const std::string &imageName) {
+    return std::filesystem::path(imageName).stem().string() + "_preview.jpg";
+}
+
+
+/* writeSvg
+ * Precondition: detections were found in imageName after it was resized to imageSize.
+ * Postcondition: Writes to file the shapes and labels annotateCoins draws, over imageName stretched to imageSize.
+ */
+static void writeSvg(std::ostream &file, const std::string &imageName, const cv::Size &imageSize,
+                     const std::vector<CoinDetection> &detections) {
+    file << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\""
+         << " width=\"" << imageSize.width << "\" height=\"" << imageSize.height << "\""
+         << " viewBox=\"0 0 " << imageSize.width << " " << imageSize.height << "\">\n";
+
+    // The image is referenced, not embedded, so the overlay stays a few kilobytes
+    file << "  <image xlink:href=\"" << xmlText(imageName) << "\" x=\"0\" y=\"0\" width=\"" << imageSize.width
+         << "\" height=\"" << imageSize.height << "\" preserveAspectRatio=\"none\"/>\n";
+
+    // Red ellipses around every candidate. A RotatedRect angle turns clockwise in image coordinates, as SVG does.
+    file << "  <g fill=\"none\" stroke=\"#ff0000\" stroke-width=\"3\">\n";
+    for (const CoinDetection &candidate : detections) {
+        const cv::RotatedRect &ellipse = candidate.ellipse;
+        file << "    <ellipse cx=\"" << ellipse.center.x << "\" cy=\"" << ellipse.center.y
+             << "\" rx=\"" << ellipse.size.width / 2 << "\" ry=\"" << ellipse.size.height / 2
+             << "\" transform=\"rotate(" << ellipse.angle << " " << ellipse.center.x << " " << ellipse.center.y
+             << ")\"/>\n";
+    }
+    file << "  </g>\n";
+
+    // Green rectangles around the coins
+    file << "  <g fill=\"none\" stroke=\"#00ff00\" stroke-width=\"2\">\n";
+    for (const CoinDetection &candidate : detections) {
+        if (candidate.isCoin) {
+            const cv::Rect &rect = candidate.boundingRect;
+            file << "    <rect x=\"" << rect.x << "\" y=\"" << rect.y << "\" width=\"" << rect.width
+                 << "\" height=\"" << rect.height << "\"/>\n";
+        }
+    }
+    file << "  </g>\n";
+
+    // White labels outlined in black below each coin
+    file << "  <g font-family=\"sans-serif\" font-size=\"30\" fill=\"#ffffff\" stroke=\"#000000\""
+         << " stroke-width=\"4\" paint-order=\"stroke\">\n";
+    for (const CoinDetection &candidate : detections) {
+        if (candidate.isCoin) {
+            const cv::Rect &rect = candidate.boundingRect;
+            int bottom = rect.y + rect.height;
+            file << "    <text x=\"" << rect.x << "\" y=\"" << bottom + 30 << "\">"
+                 << xmlText(coinNames[candidate.templateIndex]) << "</text>\n"
+                 << "    <text x=\"" << rect.x << "\" y=\"" << bottom + 60 << "\">" << candidate.matchPercent
+                 << "% Match</text>\n";
+        }
+    }
+    file << "  </g>\n";
+
+    file << "  <text x=\"30\" y=\"60\" font-family=\"sans-serif\" font-size=\"60\" fill=\"#00ff64\""
+         << " stroke=\"#000000\" stroke-width=\"6\" paint-order=\"stroke\">Total Value of Collection: $"
+         << std::fixed << std::setprecision(2) << valueOfCoins(detections) << "</text>\n";
+    file.unsetf(std::ios::floatfield);
+    file << "</svg>\n";
+}
+
+
+/* writeJson
+ * Precondition: detections were found in imageName after it was resized to imageSize.
+ * Postcondition: Writes to file every candidate of detections in the format readOverlay reads.
+ */
+static void writeJson(std::ostream &file, const std::string &imageName, const cv::Size &imageSize,
+                      const std::vector<CoinDetection> &detections) {
+    file << "{\"image\":" << jsonString(imageName) << ",\"width\":" << imageSize.width
+         << ",\"height\":" << imageSize.height << ",\"totalValue\":" << valueOfCoins(detections)
+         << ",\"candidates\":[";
+    for (size_t i = 0; i < detections.size(); i++) {
+        const CoinDetection &candidate = detections[i];
+        const cv::RotatedRect &ellipse = candidate.ellipse;
+        const cv::Rect &rect = candidate.boundingRect;
+        file << (i > 0 ? ",\n  " : "\n  ")
+             << "{\"ellipse\":{\"x\":" << ellipse.center.x << ",\"y\":" << ellipse.center.y
+             << ",\"width\":" << ellipse.size.width << ",\"height\":" << ellipse.size.height
+             << ",\"angle\":" << ellipse.angle << "},"
+             << "\"boundingRect\":{\"x\":" << rect.x << ",\"y\":" << rect.y << ",\"width\":" << rect.width
+             << ",\"height\":" << rect.height << "},"
+             << "\"isCoin\":" << (candidate.isCoin ? 1 : 0);
+        if (candidate.isCoin) {
+            file << ",\"template\":" << jsonString(templateName(candidate.templateIndex))
+                 << ",\"matchPercent\":" << candidate.matchPercent
+                 << ",\"rotationDegrees\":" << candidate.rotationDegrees;
+        }
+        file << "}";
+    }
+    file << "\n]}\n";
+}
+
+
+/* writeOverlay
+ * Precondition: detections were found in the image at imagePath after it was resized to imageSize. format is
+ *               not none.
+ * Postcondition: Writes the overlay next to the image. Returns false if the file cannot be written.
+ */
+bool writeOverlay(const std::string &imagePath, OverlayFormat format, const cv::Size &imageSize,
+                  const std::vector<CoinDetection> &detections) {
+    std::string overlayPath = overlayPathFor(imagePath, format);
+    std::ofstream file(overlayPath);
+    if (!file.is_open()) {
+        std::cout << "Could not write " << overlayPath << std::endl;
+        return false;
+    }
+
+    // The overlay sits beside the image, so the image is referenced by its file name alone
+    std::string imageName = std::filesystem::path(imagePath).filename().string();
+    if (format == OverlayFormat::svg) {
+        writeSvg(file, imageName, imageSize, detections);
+    } else {
+        writeJson(file, imageName, imageSize, detections);
+    }
+    return file.good();
+}
+
+
+/* readOverlay
+ * Precondition: None
+ * Postcondition: Reads a JSON overlay into imageSize and detections. Returns false if it cannot be read.
+ */
+bool readOverlay(const std::string &path, cv::Size &imageSize, std::vector<CoinDetection> &detections) {
+    cv::FileStorage file(path, cv::FileStorage::READ);
+    if (!file.isOpened()) {
+        std::cout << "Could not read " << path << std::endl;
+        return false;
+    }
+
+    imageSize = cv::Size((int) file["width"], (int) file["height"]);
+    if (imageSize.area() <= 0) {
+        std::cout << path << " has no image size" << std::endl;
+        return false;
+    }
+
+    detections.clear();
+    cv::FileNode candidates = file["candidates"];
+    for (int i = 0; i < (int) candidates.size(); i++) {
+        cv::FileNode node = candidates[i];
+        CoinDetection candidate;
+        candidate.contourIndex = i;
+
+        cv::FileNode ellipse = node["ellipse"];
+        candidate.ellipse = cv::RotatedRect(cv::Point2f((float) (double) ellipse["x"], (float) (double) ellipse["y"]),
+                                            cv::Size2f((float) (double) ellipse["width"],
+                                                       (float) (double) ellipse["height"]),
+                                            (float) (double) ellipse["angle"]);
+        cv::FileNode rect = node["boundingRect"];
+        candidate.boundingRect = cv::Rect((int) rect["x"], (int) rect["y"], (int) rect["width"], (int) rect["height"]);
+
+        candidate.isCoin = (int) node["isCoin"] != 0;
+        if (candidate.isCoin) {
+            std::string name = (std::string) node["template"];
+            candidate.templateIndex = -1;
+            for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+                if (templateName(currentCoin) == name) {
+                    candidate.templateIndex = currentCoin;
+                }
+            }
+            if (candidate.templateIndex < 0) {
+                std::cout << path << " names an unknown template " << name << std::endl;
+                return false;
+            }
+            candidate.matchPercent = (double) node["matchPercent"];
+            candidate.rotationDegrees = (int) node["rotationDegrees"];
+        }
+        detections.push_back(candidate);
+    }
+    return true;
+}
+
+
+/* renderAnnotated
+ * Precondition: detections were found in source after it was resized to detectedSize.
+ * Postcondition: Returns a copy of source at maxDimension, or at detectedSize if maxDimension is 0, annotated.
+ */
+cv::Mat renderAnnotated(const cv::Mat &source, const cv::Size &detectedSize,
+                        const std::vector<CoinDetection> &detections, int maxDimension) {
+    cv::Size outputSize = detectedSize;
+    int largest = std::max(detectedSize.width, detectedSize.height);
+    if (maxDimension > 0 && largest > maxDimension) {
+        double ratio = (double) maxDimension / largest;
+        outputSize = cv::Size(std::max(1, (int) std::round(detectedSize.width * ratio)),
+                              std::max(1, (int) std::round(detectedSize.height * ratio)));
+    }
+
+    // Only the preview is drawn on, never an image at the working size
+    cv::Mat output;
+    if (source.size() == outputSize) {
+        output = source.clone();
+    } else {
+        cv::resize(source, output, outputSize, 0, 0, cv::INTER_AREA);
+    }
+
+    std::vector<CoinDetection> scaled = detections;
+    scaleDetections(scaled, detectedSize, outputSize);
+    annotateCoins(scaled, output);
+    return output;
+}
+
+
+/* writeCoinThumbnails
+ * Precondition: detections were found in source after it was resized to detectedSize. directory ends in a
+ *               separator.
+ * Postcondition: Writes a thumbnail of every coin to directory and returns the number written.
+ */
+int writeCoinThumbnails(const cv::Mat &source, const cv::Size &detectedSize,
+                        const std::vector<CoinDetection> &detections, const std::string &directory,
+                        const std::string &imageName, int size) {
+    std::vector<CoinDetection> scaled = detections;
+    scaleDetections(scaled, detectedSize, source.size());
+
+    std::string stem = std::filesystem::path(imageName).stem().string();
+    int coinNumber = 0;
+    int written = 0;
+    for (const CoinDetection &candidate : scaled) {
+        if (!candidate.isCoin) {
+            continue;
+        }
+        coinNumber++;
+
+        cv::Rect crop = candidate.boundingRect & cv::Rect(0, 0, source.cols, source.rows);
+        if (crop.area() == 0) {
+            continue;
+        }
+        cv::Mat thumbnail = source(crop);
+        int largest = std::max(crop.width, crop.height);
+        if (largest > size) {
+            double ratio = (double) size / largest;
+            cv::resize(thumbnail, thumbnail, cv::Size(std::max(1, (int) std::round(crop.width * ratio)),
+                                                      std::max(1, (int) std::round(crop.height * ratio))),
+                       0, 0, cv::INTER_AREA);
+        }
+
+        std::string fileName = stem + "_coin" + std::to_string(coinNumber) + "_" +
+                               templateName(candidate.templateIndex) + ".jpg";
+        if (cv::imwrite(directory + fileName, thumbnail)) {
+            written++;
+        }
+    }
+    return written;
+}
+
+
+/* renderOverlays
+ * Precondition: inputPath is an input image or a directory of them. outputDirectory ends in a separator.
+ * Postcondition: Every input image with a JSON overlay has been rendered to outputDirectory. Returns the number
+ *                of images rendered.
+ */
+int renderOverlays(const std::string &inputPath, const std::string &outputDirectory, int previewSize,
+                   int thumbnailSize) {
+    std::vector<std::string> imagePaths;
+    if (std::filesystem::is_directory(inputPath)) {
+        for (const auto &entry : std::filesystem::directory_iterator(inputPath)) {
+            if (!entry.is_directory() && isInputImage(entry.path().string())) {
+                imagePaths.push_back(entry.path().string());
+            }
+        }
+    } else {
+        imagePaths.push_back(inputPath);
+    }
+
+    int rendered = 0;
+    for (const std::string &imagePath : imagePaths) {
+        std::string overlayPath = overlayPathFor(imagePath, OverlayFormat::json);
+        if (!std::filesystem::exists(overlayPath)) {
+            continue;
+        }
+
+        cv::Size detectedSize;
+        std::vector<CoinDetection> detections;
+        if (!readOverlay(overlayPath, detectedSize, detections)) {
+            continue;
+        }
+
+        // A preview alone needs only a reduced decode; thumbnails are cropped from the working size
+        int largest = std::max(detectedSize.width, detectedSize.height);
+        int decodeSize = previewSize > 0 && thumbnailSize == 0 ? std::min(previewSize, largest) : largest;
+        cv::Mat source;
+        {
+            TRACE_STAGE(decodeTimer, TraceStage::decode);
+            source = decodeImage(imagePath, decodeSize);
+        }
+        if (source.empty()) {
+            std::cout << "Could not read " << imagePath << std::endl;
+            continue;
+        }
+
+        std::string imageName = std::filesystem::path(imagePath).filename().string();
+        cv::Mat output = renderAnnotated(source, detectedSize, detections, previewSize);
+        {
+            TRACE_STAGE(encodeTimer, TraceStage::encode);
+            cv::imwrite(outputDirectory + (previewSize > 0 ? previewFileName(imageName) : outputFileName(imageName)),
+                        output);
+            if (thumbnailSize > 0) {
+                writeCoinThumbnails(source, detectedSize, detections, outputDirectory, imageName, thumbnailSize);
+            }
+        }
+        rendered++;
+    }
+    return rendered;
+}
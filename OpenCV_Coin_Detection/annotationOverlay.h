@@ -0,0 +1,117 @@
+//==============================================================================
+// Annotation Overlay
+//------------------------------------------------------------------------------
+// Step 7 as data instead of pixels. Rather than cloning every image at its
+// working size and drawing the annotations into it, --overlay writes the
+// shapes annotateCoins would draw to a small file next to the input image:
+//
+//      Test Images/coins.jpg
+//      Test Images/coins.overlay.svg       (or coins.overlay.json)
+//
+// The SVG shows the original image under the ellipses, rectangles and labels
+// in any browser, which rasterizes it at whatever size it is viewed. The JSON
+// holds every candidate in the coordinates of the image's working size:
+//
+//      {"image":"coins.jpg","width":2500,"height":1875,"totalValue":0.36,
+//       "candidates":[{"ellipse":{...},"boundingRect":{...},"isCoin":1,
+//                      "template":"pennyHeads","matchPercent":52.1,
+//                      "rotationDegrees":45}]}
+//
+// and is read back by renderOverlays (--render-overlays), which draws the
+// annotated image only when it is asked for: at full working size, as a
+// downscaled preview, or as a thumbnail of every coin. The detection
+// pipeline can also write previews and thumbnails directly; both are far
+// smaller than the annotated working size image they replace.
+//==============================================================================
+
+#ifndef ANNOTATION_OVERLAY_H
+#define ANNOTATION_OVERLAY_H
+
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "coinDetection.h"
+
+
+enum class OverlayFormat {
+    none,
+    svg,
+    json
+};
+
+
+/*-------------------------------- overlayPathFor ------------------------------
+ * Precondition:  format is not none.
+ * Postcondition: Returns imagePath with its extension replaced by
+ *                ".overlay.svg" or ".overlay.json".
+ */
+std::string overlayPathFor(const std::string &imagePath, OverlayFormat format);
+
+
+/*------------------------------- previewFileName ------------------------------
+ * Precondition:  None
+ * Postcondition: Returns the stem of imageName followed by "_preview.jpg".
+ */
+std::string previewFileName(const std::string &imageName);
+
+
+/*--------------------------------- writeOverlay -------------------------------
+ * Precondition:  detections were found in the image at imagePath after it
+ *                was resized to imageSize. format is not none.
+ * Postcondition: Writes the annotations of detections to
+ *                overlayPathFor(imagePath, format). Returns false if the file
+ *                cannot be written.
+ */
+bool writeOverlay(const std::string &imagePath, OverlayFormat format, const cv::Size &imageSize,
+                  const std::vector<CoinDetection> &detections);
+
+
+/*--------------------------------- readOverlay --------------------------------
+ * Precondition:  None
+ * Postcondition: Reads a JSON overlay written by writeOverlay from path into
+ *                imageSize and detections, with the fields annotateCoins uses
+ *                filled in. Returns false if it cannot be read.
+ */
+bool readOverlay(const std::string &path, cv::Size &imageSize, std::vector<CoinDetection> &detections);
+
+
+/*------------------------------- renderAnnotated ------------------------------
+ * Precondition:  detections were found in source after it was resized to
+ *                detectedSize.
+ * Postcondition: Returns source, resized to maxDimension pixels on its larger
+ *                side if maxDimension is above 0 or else to detectedSize,
+ *                annotated by annotateCoins. source is not modified.
+ */
+cv::Mat renderAnnotated(const cv::Mat &source, const cv::Size &detectedSize,
+                        const std::vector<CoinDetection> &detections, int maxDimension);
+
+
+/*------------------------------ writeCoinThumbnails ---------------------------
+ * Precondition:  detections were found in source after it was resized to
+ *                detectedSize. directory ends in a separator.
+ * Postcondition: Writes the bounding rectangle of every coin, cropped from
+ *                source and resized to at most size pixels on a side, to
+ *                directory as <stem of imageName>_coin<N>_<template>.jpg.
+ *                Returns the number written.
+ */
+int writeCoinThumbnails(const cv::Mat &source, const cv::Size &detectedSize,
+                        const std::vector<CoinDetection> &detections, const std::string &directory,
+                        const std::string &imageName, int size);
+
+
+/*-------------------------------- renderOverlays ------------------------------
+ * Precondition:  inputPath is an input image or a directory of them.
+ *                outputDirectory ends in a separator.
+ * Postcondition: For every input image with a JSON overlay next to it, writes
+ *                the annotated image to outputDirectory, as <name>_output at
+ *                its working size if previewSize is 0 or else as a
+ *                <name>_preview.jpg of previewSize pixels, and a thumbnail of
+ *                every coin if thumbnailSize is above 0. Returns the number
+ *                of images rendered.
+ */
+int renderOverlays(const std::string &inputPath, const std::string &outputDirectory, int previewSize,
+                   int thumbnailSize);
+
+#endif
@@ -0,0 +1,132 @@
+#include <algorithm>
+
+#include "opencv2/imgproc.hpp"
+
+#include "batchedClassifier.h"
+#include "detectionScratch.h"
+#include "findCoins.h"
+#include "imageUtilities.h"
+#include "stageTrace.h"
+#include "templateMatcher.h"
+
+
+/* BatchedClassifier
+ * Precondition: templateBank has been loaded and outlives the classifier.
+ * Postcondition: templateMatrix holds every rotation of every template at the canonical scale, one per row.
+ */
+BatchedClassifier::BatchedClassifier(const TemplateBank &templateBank, const DetectionSettings &settings)
+        : templateBank(templateBank), settings(settings), canonicalScale(&templateBank.nearestScale(batchPatchSize)) {
+
+    const int size = canonicalScale->size;
+    const int rotationCount = templateBank.numRotations();
+    templateMatrix.create(numberOfTemplates * rotationCount, size * size, CV_32FC1);
+
+    cv::Mat rotatedTemplate;
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        for (int countIndex = 0; countIndex < rotationCount; countIndex++) {
+            canonicalScale->rotations[currentCoin][countIndex].unpack(rotatedTemplate);
+            cv::Mat templateRow = templateMatrix.row(currentCoin * rotationCount + countIndex).reshape(1, size);
+            rotatedTemplate.convertTo(templateRow, CV_32F, 1.0 / 255.0);
+        }
+    }
+}
+
+
+/* classify
+ * Precondition: Each item's candidate was found in its sourceImg and has not been classified yet.
+ * Postcondition: Every candidate is classified, settings.batchSize patches per matrix product.
+ */
+void BatchedClassifier::classify(WorkerPool &workerPool, const std::vector<Item> &items) const {
+    const int size = canonicalScale->size;
+    const int rotationCount = templateBank.numRotations();
+    const int batchSize = std::max(settings.batchSize, 1);
+
+    // Allocated per call rather than in the thread's scratch: a worker waiting on the tasks below may run another
+    // image's classify on the same thread
+    cv::Mat patches;
+    cv::Mat scores;
+    std::vector<TemplateMatch> packedMatches;
+
+    for (size_t first = 0; first < items.size(); first += batchSize) {
+        const int count = (int) std::min(items.size() - first, (size_t) batchSize);
+        patches.create(count, size * size, CV_32FC1);
+        if (settings.compareMatchers) {
+            packedMatches.assign((size_t) count * numberOfTemplates, TemplateMatch());
+        }
+
+        /*------------------- Steps 3 and 4.1: one canonical patch per row -------------------*/
+        workerPool.parallelFor(count, [&](int row) {
+            const Item &item = items[first + row];
+            DetectionScratch &scratch = DetectionScratch::forThisThread();
+
+            cv::Mat patch = extractCandidatePatch(*item.sourceImg, *item.candidate);
+            TRACE_STAGE(preparationTimer, TraceStage::templatePreparation);
+            cv::Mat resizedPatch = scratch.view(scratch.resizedBuffer, size, size, CV_8UC3);
+            cv::resize(patch, resizedPatch, resizedPatch.size(), 0, 0, cv::INTER_AREA);
+
+            PatchEdges &patchEdges = scratch.patchEdges;
+            patchEdges.edges = scratch.view(scratch.edgesBuffer, size, size, CV_8UC1);
+            createEdgeImage(resizedPatch, patchEdges.edges);
+
+            cv::Mat patchRow = patches.row(row).reshape(1, size);
+            patchEdges.edges.convertTo(patchRow, CV_32F, 1.0 / 255.0);
+
+            // The packed matcher on the same canonical edges must count exactly what the product does
+            if (settings.compareMatchers) {
+                scratch.pack(patchEdges.packed, patchEdges.edges);
+                matchTemplates(templateBank, *canonicalScale, MatcherType::packed, patchEdges,
+                               &packedMatches[(size_t) row * numberOfTemplates], 1, 0,
+                               item.candidate->plausibleTemplates);
+            }
+        });
+
+        /*---------------- Step 4.3: every template x rotation of every patch ----------------*/
+        TRACE_STAGE(sweepTimer, TraceStage::rotationSweep);
+        cv::gemm(patches, templateMatrix, 1.0, cv::noArray(), 0.0, scores, cv::GEMM_2_T);
+        TRACE_COUNT(TraceCounter::templateAngleEvaluations, (long long) count * numberOfTemplates * rotationCount);
+
+        /*-------------------------------- Steps 5 and 6 -------------------------------------*/
+        for (int row = 0; row < count; row++) {
+            CoinDetection &candidate = *items[first + row].candidate;
+            const float *rowScores = scores.ptr<float>(row);
+
+            TemplateMatch templateMatches[numberOfTemplates];
+            for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+                // The product scores every template, but the ones the size prior ruled out cannot win
+                if (!(candidate.plausibleTemplates & (1u << currentCoin))) {
+                    templateMatches[currentCoin].exact = false;
+                    continue;
+                }
+                const float *templateScores = rowScores + currentCoin * rotationCount;
+                const double numTemplateEdges = canonicalScale->numEdges[currentCoin];
+                for (int countIndex = 0; countIndex < rotationCount; countIndex++) {
+                    double rotationMatchPercent = (templateScores[countIndex] / numTemplateEdges) * 100.0;
+                    if (rotationMatchPercent > templateMatches[currentCoin].percent) {
+                        templateMatches[currentCoin].percent = rotationMatchPercent;
+                        templateMatches[currentCoin].degrees = countIndex * templateBank.degreeIncrement();
+                    }
+                }
+            }
+            candidate.matcherEvaluations = numberOfTemplates * rotationCount;
+            if (settings.compareMatchers) {
+                candidate.matcherReport = describeMatcherDifferences(
+                        templateMatches, &packedMatches[(size_t) row * numberOfTemplates], 0);
+            }
+            chooseBestTemplate(templateMatches, candidate);
+        }
+    }
+}
+
+
+/* scale
+ * Precondition: None
+ * Postcondition: Returns the canonical template scale.
+ */
+const TemplateBank::Scale &BatchedClassifier::scale() const {
+    return *canonicalScale;
+}
+
+
+std::string BatchedClassifier::name() const {
+    return "batched template matching (" + std::to_string(std::max(settings.batchSize, 1)) + " per product)";
+}
@@ -0,0 +1,84 @@
+//==============================================================================
+// BatchedClassifier
+//------------------------------------------------------------------------------
+// MatcherType::batched: classifies many patches at once, possibly from many 
+// images, as one dense matrix product instead of one patch and one template 
+// at a time.
+//
+// Every patch is resized to one canonical size (the template scale nearest 
+// batchPatchSize) and its edge image flattened into a row of 0s and 1s. The 
+// rotations of every template at that scale are flattened the same way, once,
+// into the rows of the template matrix. The edge pixels a template rotation 
+// shares with a patch are the dot product of their rows, so 
+//
+//      scores = patches (batch x pixels) * templates^T (pixels x 8 * rotations)
+//
+// counts every template x rotation of every patch in a single cv::gemm call,
+// which runs on OpenCV's optimized GEMM (backed by BLAS when OpenCV was built
+// with one). The counts are exact in single precision. Steps 5 and 6 of 
+// findCoins then pick the best rotation and template of each row and apply 
+// coinMatchThreshold as usual.
+//
+// Patches are matched at the canonical size instead of the scale nearest 
+// their own size, so results can differ slightly from the packed matcher on 
+// very small or large coins. A patch classified on its own (the stream mode 
+// and tiled scans) is matched like MatcherType::packed.
+//==============================================================================
+
+#ifndef BATCHED_CLASSIFIER_H
+#define BATCHED_CLASSIFIER_H
+
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "candidateClassifier.h"
+#include "detectionSettings.h"
+#include "templateBank.h"
+#include "workerPool.h"
+
+
+// Patches are compared at the template scale nearest this size
+const int batchPatchSize{64};
+
+
+class BatchedClassifier : public CandidateClassifier {
+public:
+
+    /*----------------------------- BatchedClassifier --------------------------
+     * Precondition:  templateBank has been loaded and outlives the classifier.
+     * Postcondition: Every rotation of every template at the canonical scale
+     *                is flattened into the template matrix. Candidates will be
+     *                classified with settings.
+     */
+    BatchedClassifier(const TemplateBank &templateBank, const DetectionSettings &settings);
+
+    /*---------------------------------- classify ------------------------------
+     * Precondition:  See CandidateClassifier::classify.
+     * Postcondition: Steps 3 to 6 of findCoins for every item, 
+     *                settings.batchSize candidates per matrix product. The 
+     *                patches of each batch are extracted as tasks of 
+     *                workerPool. With settings.compareMatchers each patch is 
+     *                also matched with the packed matcher at the canonical 
+     *                scale and differences are reported in its matcherReport.
+     */
+    void classify(WorkerPool &workerPool, const std::vector<Item> &items) const override;
+
+    std::string name() const override;
+
+    /*----------------------------------- scale --------------------------------
+     * Precondition:  None
+     * Postcondition: Returns the template scale every patch is resized to.
+     */
+    const TemplateBank::Scale &scale() const;
+
+private:
+    const TemplateBank &templateBank;
+    DetectionSettings settings;
+    const TemplateBank::Scale *canonicalScale;
+    cv::Mat templateMatrix;     // CV_32FC1, row t * numRotations + k is rotation k of template t, 1 on edges
+};
+
+
+#endif
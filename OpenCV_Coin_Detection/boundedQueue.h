@@ -0,0 +1,86 @@
+//==============================================================================
+// BoundedQueue
+//------------------------------------------------------------------------------
+// A first in, first out queue shared between threads that holds at most 
+// capacity items. push blocks while the queue is full, which holds back the 
+// stage producing items until the next stage catches up. pop blocks while the
+// queue is empty. Once close() is called, push fails and pop drains what is 
+// left and then fails.
+//==============================================================================
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+
+template<typename T>
+class BoundedQueue {
+public:
+
+    /*------------------------------- BoundedQueue -----------------------------
+     * Precondition:  capacity is greater than 0.
+     * Postcondition: Creates an empty, open queue.
+     */
+    explicit BoundedQueue(size_t capacity) : maxItems(capacity), closed(false) {}
+
+    /*----------------------------------- push ---------------------------------
+     * Precondition:  None
+     * Postcondition: Waits until there is room, then adds item and returns 
+     *                true. Returns false without adding item if the queue is 
+     *                closed.
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return closed || items.size() < maxItems; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /*------------------------------------ pop ---------------------------------
+     * Precondition:  None
+     * Postcondition: Waits until an item is available, removes the oldest into
+     *                item and returns true. Returns false once the queue is 
+     *                closed and empty.
+     */
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    /*----------------------------------- close --------------------------------
+     * Precondition:  None
+     * Postcondition: No more items can be pushed and every waiting thread is 
+     *                woken.
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+private:
+    const size_t maxItems;
+    bool closed;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+};
+
+#endif
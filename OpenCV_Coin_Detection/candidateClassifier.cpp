@@ -0,0 +1,39 @@
+#include "candidateClassifier.h"
+#include "findCoins.h"
+
+
+/* TemplateMatchClassifier
+ * Precondition: templateBank has been loaded and outlives the classifier.
+ * Postcondition: Creates a classifier running classifyCandidate with settings.
+ */
+TemplateMatchClassifier::TemplateMatchClassifier(const TemplateBank &templateBank, const DetectionSettings &settings)
+        : templateBank(templateBank), settings(settings) {}
+
+
+/* classify
+ * Precondition: Each item's candidate was found in its sourceImg and has not been classified yet.
+ * Postcondition: Every candidate is classified as its own task.
+ */
+void TemplateMatchClassifier::classify(WorkerPool &workerPool, const std::vector<Item> &items) const {
+
+    // Steps 3 to 6 only read sourceImg and the template bank, so each candidate is classified as its own task
+    workerPool.parallelFor((int) items.size(), [&](int itemIndex) {
+        classifyCandidate(templateBank, settings, *items[itemIndex].sourceImg, *items[itemIndex].candidate);
+    });
+}
+
+
+std::string TemplateMatchClassifier::name() const {
+    switch (settings.matcher) {
+        case MatcherType::reference:
+            return "template matching (reference)";
+        case MatcherType::polar:
+            return "template matching (polar)";
+        case MatcherType::coarseToFine:
+            return "template matching (coarse-to-fine)";
+        case MatcherType::chamfer:
+            return "template matching (chamfer)";
+        default:
+            return "template matching (packed)";
+    }
+}
@@ -0,0 +1,86 @@
+//==============================================================================
+// CandidateClassifier
+//------------------------------------------------------------------------------
+// Steps 3 to 6 of findCoins behind one interface, so CoinDetector can decide
+// which coin a candidate is in more than one way. A classifier is given 
+// candidates found by Step 2, each with the image it was found in, and fills
+// in their templateIndex, matchPercent, rotationDegrees and isCoin.
+//
+// The implementations are:
+//      TemplateMatchClassifier  edge template matching with the matcher 
+//                               DetectionSettings selects (below)
+//      BatchedClassifier        edge template matching as one matrix product
+//                               per batch (batchedClassifier.h)
+//      FeatureClassifier        rotation invariant features scored by a 
+//                               trained network (featureClassifier.h)
+//
+// Classifiers are immutable once built, so one can be shared by every thread.
+//==============================================================================
+
+#ifndef CANDIDATE_CLASSIFIER_H
+#define CANDIDATE_CLASSIFIER_H
+
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "coinDetection.h"
+#include "detectionSettings.h"
+#include "templateBank.h"
+#include "workerPool.h"
+
+
+class CandidateClassifier {
+public:
+
+    // A candidate to classify and the image it was found in
+    struct Item {
+        const cv::Mat *sourceImg;
+        CoinDetection *candidate;
+    };
+
+    virtual ~CandidateClassifier() = default;
+
+    /*---------------------------------- classify ------------------------------
+     * Precondition:  Each item's candidate was found in its sourceImg by Step 2
+     *                of findCoins and has not been classified yet. No two 
+     *                items share a candidate. May be called from a task of 
+     *                workerPool.
+     * Postcondition: Every candidate is classified, using tasks of workerPool.
+     */
+    virtual void classify(WorkerPool &workerPool, const std::vector<Item> &items) const = 0;
+
+    /*------------------------------------ name --------------------------------
+     * Precondition:  None
+     * Postcondition: Returns a short description for reports.
+     */
+    virtual std::string name() const = 0;
+};
+
+
+class TemplateMatchClassifier : public CandidateClassifier {
+public:
+
+    /*-------------------------- TemplateMatchClassifier -----------------------
+     * Precondition:  templateBank has been loaded and outlives the classifier.
+     * Postcondition: Candidates will be classified by classifyCandidate with 
+     *                settings.
+     */
+    TemplateMatchClassifier(const TemplateBank &templateBank, const DetectionSettings &settings);
+
+    /*---------------------------------- classify ------------------------------
+     * Precondition:  See CandidateClassifier::classify.
+     * Postcondition: classifyCandidate has run on every candidate, each as its
+     *                own task.
+     */
+    void classify(WorkerPool &workerPool, const std::vector<Item> &items) const override;
+
+    std::string name() const override;
+
+private:
+    const TemplateBank &templateBank;
+    DetectionSettings settings;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include <algorithm>
+
+#include "opencv2/imgproc.hpp"
+
+#include "chamferMatcher.h"
+
+
+/* appendEdgePoints
+ * Precondition: edgeImage is a single channel 8-bit image of at most chamferStride rows and columns.
+ * Postcondition: The offset of every pixel of edgeImage above 0 is appended to points.
+ */
+void appendEdgePoints(const cv::Mat &edgeImage, std::vector<uint16_t> &points) {
+    for (int r = 0; r < edgeImage.rows; r++) {
+        const uchar *row = edgeImage.ptr<uchar>(r);
+        for (int c = 0; c < edgeImage.cols; c++) {
+            if (row[c] > 0) {
+                points.push_back((uint16_t) (r * chamferStride + c));
+            }
+        }
+    }
+}
+
+
+/* createChamferWeights
+ * Precondition: edgeImage is a CV_8UC1 edge image, inverted has its size and type, and weights is CV_8UC1 with
+ *               edgeImage.rows rows and chamferStride columns.
+ * Postcondition: The first edgeImage.cols columns of weights hold the chamfer weight of each pixel.
+ */
+void createChamferWeights(const cv::Mat &edgeImage, cv::Mat &inverted, cv::Mat &weights) {
+
+    // distanceTransform measures the distance to the nearest zero pixel, so the edges become the zeros
+    cv::bitwise_not(edgeImage, inverted);
+
+    // Written in place into the view, the city block distance fits in a byte and saturates at 255
+    cv::Mat distances = weights.colRange(0, edgeImage.cols);
+    cv::distanceTransform(inverted, distances, cv::DIST_L1, cv::DIST_MASK_3, CV_8U);
+
+    // Saturating subtraction leaves 0 for every pixel beyond the tolerance
+    cv::subtract(cv::Scalar(chamferTolerance + 1), distances, distances);
+}
+
+
+/* matchTemplateChamfer
+ * Precondition: scale belongs to templateBank, patchWeights was made by createChamferWeights from a scale.size
+ *               x scale.size edge image, with a row step of chamferStride bytes.
+ * Postcondition: Returns the rotation of template templateIndex with the highest chamfer score, over every
+ *                angleStep-th rotation, and that score as a percentage of the template's edges at full weight.
+ */
+TemplateMatch matchTemplateChamfer(const TemplateBank &templateBank, const TemplateBank::Scale &scale,
+                                   int templateIndex, const cv::Mat &patchWeights, int angleStep) {
+    CV_Assert(patchWeights.step == (size_t) chamferStride);
+    const uchar *weights = patchWeights.data;
+    const uint16_t *points = scale.edgePoints[templateIndex].ptr<uint16_t>();
+    const int *starts = scale.edgePointStarts[templateIndex].ptr<int>();
+    const int rotationCount = scale.edgePointStarts[templateIndex].rows - 1;
+
+    int bestWeightSum = -1;
+    int bestIndex = 0;
+    for (int countIndex = 0; countIndex < rotationCount; countIndex += angleStep) {
+        // Only the template's edge points are visited, one weight lookup each
+        int weightSum = 0;
+        for (int point = starts[countIndex]; point < starts[countIndex + 1]; point++) {
+            weightSum += weights[points[point]];
+        }
+        if (weightSum > bestWeightSum) {
+            bestWeightSum = weightSum;
+            bestIndex = countIndex;
+        }
+    }
+
+    // Normalized like the exact count, so every template edge on a patch edge would score 100
+    TemplateMatch bestMatch;
+    bestMatch.percent = (double) bestWeightSum / ((chamferTolerance + 1) * std::max(1, scale.numEdges[templateIndex]))
+                        * 100.0;
+    bestMatch.degrees = bestIndex * templateBank.degreeIncrement();
+    return bestMatch;
+}
@@ -0,0 +1,92 @@
+//==============================================================================
+// Chamfer Matcher
+//------------------------------------------------------------------------------
+// MatcherType::chamfer. The other matchers count the template edge pixels
+// that land exactly on a patch edge, which means scanning every pixel of
+// every rotated template, and a coin drawn one pixel off its template loses
+// those edges entirely. The chamfer matcher takes one distance transform of
+// the patch edges instead, turned into a weight for every pixel:
+//
+//      weight = chamferTolerance + 1 - distance to the nearest patch edge
+//
+// (0 beyond chamferTolerance pixels), and keeps every rotation of every
+// template as a list of its edge pixels (TemplateBank::Scale::edgePoints).
+// Scoring a rotation only visits those points and sums their weights, so a
+// template edge on a patch edge counts in full and one a pixel away still
+// counts in part.
+//
+// The percentage reported is the best sum over the template's edge count at
+// full weight, the normalized chamfer score. Every exact match scores full 
+// weight and near misses add to it, so the score is never below the exact 
+// percentage at the same rotation and is not on the scale coinMatchThreshold
+// was set on. A candidate is a coin above chamferMatchThreshold instead 
+// (see coinThreshold in templateMatcher.h).
+//
+// Each edge point is stored as the 16-bit offset y * chamferStride + x, and
+// the weight image of a patch is chamferStride bytes per row, so a point is
+// a single lookup whatever the size of the patch.
+//==============================================================================
+
+#ifndef CHAMFER_MATCHER_H
+#define CHAMFER_MATCHER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "templateBank.h"
+#include "templateMatcher.h"
+
+
+// Template edges further than this many pixels (city block) from a patch edge count nothing
+const int chamferTolerance{1};
+
+// Bytes per row of a chamfer weight image, and the largest template size with edge points
+const int chamferStride{256};
+
+// A patch is a coin if the best template's chamfer score is above this. It took the same decision as the exact
+// count at coinMatchThreshold on all 74 candidates of the test images from 64 to 66, against 72 at 60 or 68.
+const double chamferMatchThreshold{65.0};
+
+
+/*------------------------------ appendEdgePoints ------------------------------
+ * Precondition:  edgeImage is a single channel 8-bit image of at most
+ *                chamferStride rows and columns.
+ * Postcondition: The offset y * chamferStride + x of every pixel of edgeImage
+ *                greater than 0, the pixels PackedEdgeImage::pack sets, is
+ *                appended to points in row order.
+ */
+void appendEdgePoints(const cv::Mat &edgeImage, std::vector<uint16_t> &points);
+
+
+/*---------------------------- createChamferWeights ----------------------------
+ * Precondition:  edgeImage is a CV_8UC1 edge image of 0 and 255 of at most
+ *                chamferStride rows and columns. inverted has the size and
+ *                type of edgeImage, and weights is CV_8UC1 with
+ *                edgeImage.rows rows and chamferStride columns. Neither needs
+ *                to be continuous beyond its rows.
+ * Postcondition: The first edgeImage.cols columns of weights hold
+ *                chamferTolerance + 1 minus the city block distance of each
+ *                pixel to the nearest edge of edgeImage, or 0 if it is
+ *                further. inverted is overwritten.
+ */
+void createChamferWeights(const cv::Mat &edgeImage, cv::Mat &inverted, cv::Mat &weights);
+
+
+/*---------------------------- matchTemplateChamfer ----------------------------
+ * Precondition:  scale belongs to templateBank, its size is at most
+ *                chamferStride, and patchWeights was made by
+ *                createChamferWeights from a scale.size x scale.size patch
+ *                edge image with a row step of chamferStride bytes. 
+ *                angleStep > 0.
+ * Postcondition: Returns the rotation with the highest chamfer score over
+ *                every angleStep-th rotation of template templateIndex, and
+ *                that score: the sum of the weights under the template's 
+ *                edge points as a percentage of the template's edge count 
+ *                at full weight.
+ */
+TemplateMatch matchTemplateChamfer(const TemplateBank &templateBank, const TemplateBank::Scale &scale,
+                                   int templateIndex, const cv::Mat &patchWeights, int angleStep = 1);
+
+#endif
@@ -0,0 +1,47 @@
+//==============================================================================
+// Classifier Tools
+//------------------------------------------------------------------------------
+// Modes of the command line program for working on the candidate 
+// classifiers: --compare-classifiers times one classifier against another,
+// and --export-crops writes labelled candidate patches for 
+// trainFeatureClassifier. They are built into the program, not into the 
+// CoinDetector library.
+//==============================================================================
+
+#ifndef CLASSIFIER_TOOLS_H
+#define CLASSIFIER_TOOLS_H
+
+#include <string>
+
+#include "candidateClassifier.h"
+#include "detectionSettings.h"
+#include "templateBank.h"
+#include "workerPool.h"
+
+
+/*------------------------------ compareClassifiers ----------------------------
+ * Precondition:  inputPath is an input image or a directory of them.
+ * Postcondition: Finds the candidates of every input image with settings, 
+ *                classifies all of them with baseline and with candidate (once
+ *                to warm up, then timed), and prints the candidates per second
+ *                and time per candidate of each and how many coin decisions 
+ *                differ. Returns false if no candidates were found.
+ */
+bool compareClassifiers(WorkerPool &workerPool, const DetectionSettings &settings, const std::string &inputPath,
+                        const CandidateClassifier &baseline, const CandidateClassifier &candidate);
+
+
+/*----------------------------- exportCandidateCrops ---------------------------
+ * Precondition:  inputPath is an input image or a directory of them. 
+ *                templateBank has been loaded.
+ * Postcondition: Every candidate of every input image is classified by 
+ *                template matching and its patch written as a PNG to 
+ *                cropDirectory/<cropLabelName(label)>/, ready to be checked 
+ *                by hand and used by trainFeatureClassifier. Returns false if
+ *                a directory or crop cannot be written.
+ */
+bool exportCandidateCrops(WorkerPool &workerPool, const TemplateBank &templateBank,
+                          const DetectionSettings &settings, const std::string &inputPath,
+                          const std::string &cropDirectory);
+
+#endif
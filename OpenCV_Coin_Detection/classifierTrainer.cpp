@@ -0,0 +1,52 @@
+//==============================================================================
+// Classifier Trainer
+//------------------------------------------------------------------------------
+// Offline tool that trains the FeatureClassifier (see featureClassifier.h) 
+// and saves the model the detector loads with --classifier=features. The 
+// samples are the 8 template images, rotated and relit, plus any labelled 
+// crops: one directory per label named after the template without its 
+// extension ("pennyHeads", ..., "quarterTails") or "notCoin", holding 
+// .jpg, .jpeg or .png crops of a single candidate each. Run the detector 
+// with --export-crops to write such crops, labelled by template matching, and
+// move the ones it got wrong before training.
+//
+// Usage: ClassifierTrainer [cropDirectory] [modelFile] [templateDirectory]
+//
+// cropDirectory defaults to "Training Crops/", templateDirectory to 
+// "Template Images/" and modelFile to the model the detector looks for in 
+// the template directory.
+//==============================================================================
+
+#include <iostream>
+#include <string>
+
+#include "featureClassifier.h"
+
+
+/* withSeparator
+ * Precondition: None
+ * Postcondition: Returns directory ending in a path separator.
+ */
+static std::string withSeparator(std::string directory) {
+    if (!directory.empty() && directory.back() != '/' && directory.back() != '\\') {
+        directory += '/';
+    }
+    return directory;
+}
+
+
+/*------------------------------------ main ------------------------------------
+ * Precondition:  The template directory holds the 8 images named in 
+ *                templateFileNames.
+ * Postcondition: The feature classifier is trained and written to the model
+ *                file. Returns -1 if the templates cannot be read or the 
+ *                model cannot be written.
+ */
+int main(int argc, char *argv[]) {
+
+    const std::string cropDirectory = withSeparator(argc > 1 ? argv[1] : "Training Crops/");
+    const std::string templateDirectory = withSeparator(argc > 3 ? argv[3] : "Template Images/");
+    const std::string modelFile = argc > 2 ? argv[2] : templateDirectory + featureModelFileName;
+
+    return trainFeatureClassifier(templateDirectory, cropDirectory, modelFile) ? 0 : -1;
+}
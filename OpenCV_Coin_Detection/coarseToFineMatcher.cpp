@@ -0,0 +1,158 @@
+#include <algorithm>
+
+#include "coarseToFineMatcher.h"
+
+
+/* countWithBound
+ * Precondition: templateEdges is rotation rotationIndex of template templateIndex in scale, and patchEdges has 
+ *               the same size.
+ * Postcondition: Returns the number of matching edges, or -1 as soon as the count cannot exceed neededCount.
+ */
+static int countWithBound(const TemplateBank::Scale &scale, int templateIndex, int rotationIndex,
+                          const PackedEdgeImage &patchEdges, double neededCount) {
+    const PackedEdgeImage &templateEdges = scale.rotations[templateIndex][rotationIndex];
+    const int *remaining = scale.remainingEdges[templateIndex].ptr<int>(rotationIndex);
+
+    int matchCount = 0;
+    for (int block = 0; block < scale.numRowBlocks; block++) {
+        // Even if every template edge left matched, the count would not be high enough
+        if (matchCount + remaining[block] <= neededCount) {
+            return -1;
+        }
+        int firstRow = block * PackedEdgeImage::rowBlock;
+        matchCount += countMatchingEdges(templateEdges, patchEdges, firstRow,
+                                         std::min(firstRow + PackedEdgeImage::rowBlock, scale.size));
+    }
+    return matchCount;
+}
+
+
+/* matchCoarseToFine
+ * Precondition: scale belongs to templateBank. patch.packed and patch.coarse hold the patch edge image.
+ * Postcondition: matches[t] holds the best match found for template t at a multiple of angleStep rotations, or
+ *                an empty inexact match if it was not in templateMask or among the templatesRefined best. Returns the
+ *                full size counts started.
+ */
+int matchCoarseToFine(const TemplateBank &templateBank, const TemplateBank::Scale &scale, const PatchEdges &patch,
+                      TemplateMatch matches[numberOfTemplates], int angleStep, int templatesRefined,
+                      unsigned int templateMask) {
+
+    const int rotationCount = templateBank.numRotations();
+    const int coarseStep = coarseRotationStride * angleStep;
+    const int numRefined = templatesRefined > 0 ? std::min(templatesRefined, numberOfTemplates) : numberOfTemplates;
+
+    /*------------------- Pass 1: coarse angles, downsampled -------------------*/
+    // Best coarse rotations of each template, highest score first. Fixed size, so a search allocates nothing
+    struct CoarseScore {
+        double percent;
+        int rotationIndex;
+    };
+    CoarseScore coarseScores[numberOfTemplates][refinedCoarseRotations];
+    int numCoarseScores[numberOfTemplates] = {0};
+    double bestCoarse[numberOfTemplates];
+
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        CoarseScore *scores = coarseScores[currentCoin];
+        int &kept = numCoarseScores[currentCoin];
+        bestCoarse[currentCoin] = -1.0;
+        if (!(templateMask & (1u << currentCoin))) {
+            continue;
+        }
+        for (int rotationIndex = 0; rotationIndex < rotationCount; rotationIndex += coarseStep) {
+            int matchCount = countMatchingEdges(scale.coarseRotations[currentCoin][rotationIndex], patch.coarse);
+            double percent = (double) matchCount / std::max(1, scale.coarseNumEdges[currentCoin]) * 100.0;
+
+            // Insert into the kept scores, dropping the lowest once they are full
+            int position = kept;
+            while (position > 0 && scores[position - 1].percent < percent) {
+                position--;
+            }
+            if (position >= refinedCoarseRotations) {
+                continue;
+            }
+            kept = std::min(kept + 1, refinedCoarseRotations);
+            for (int moved = kept - 1; moved > position; moved--) {
+                scores[moved] = scores[moved - 1];
+            }
+            scores[position] = {percent, rotationIndex};
+        }
+        bestCoarse[currentCoin] = kept == 0 ? 0.0 : scores[0].percent;
+    }
+
+    /*-------------- Pass 2: refine around the best coarse angles --------------*/
+    // Templates that look best are refined first, so the bound is tight for the rest
+    int templateOrder[numberOfTemplates];
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        templateOrder[currentCoin] = currentCoin;
+    }
+    std::stable_sort(templateOrder, templateOrder + numberOfTemplates,
+                     [&](int a, int b) { return bestCoarse[a] > bestCoarse[b]; });
+
+    int evaluations = 0;
+    double bestPercent = 0.0;
+    for (int order = 0; order < numberOfTemplates; order++) {
+        int currentCoin = templateOrder[order];
+        TemplateMatch &match = matches[currentCoin];
+        match = TemplateMatch();
+
+        // Templates pruned by their coarse score could still have matched, so they are not exact. Templates
+        // outside the mask sort last, after every template that was scored.
+        if (order >= numRefined || !(templateMask & (1u << currentCoin))) {
+            match.exact = false;
+            continue;
+        }
+        const double numTemplateEdges = std::max(1, scale.numEdges[currentCoin]);
+
+        // Each refined rotation and its neighbours up to halfway to the next coarse angle
+        int fineRotations[refinedCoarseRotations * (coarseRotationStride / 2 * 2 + 1)];
+        int numFineRotations = 0;
+        for (int kept = 0; kept < numCoarseScores[currentCoin]; kept++) {
+            const CoarseScore &coarse = coarseScores[currentCoin][kept];
+            for (int offset = -coarseRotationStride / 2; offset <= coarseRotationStride / 2; offset++) {
+                int rotationIndex = ((coarse.rotationIndex + offset * angleStep) % rotationCount + rotationCount) %
+                                    rotationCount;
+
+                // Kept in ascending order without duplicates, inserted in place
+                int position = 0;
+                while (position < numFineRotations && fineRotations[position] < rotationIndex) {
+                    position++;
+                }
+                if (position < numFineRotations && fineRotations[position] == rotationIndex) {
+                    continue;
+                }
+                for (int moved = numFineRotations; moved > position; moved--) {
+                    fineRotations[moved] = fineRotations[moved - 1];
+                }
+                fineRotations[position] = rotationIndex;
+                numFineRotations++;
+            }
+        }
+
+        double highestAbandoned = 0.0;
+        for (int fine = 0; fine < numFineRotations; fine++) {
+            int rotationIndex = fineRotations[fine];
+            // Only a count above the best so far, and above the coin threshold, can change the result
+            double neededPercent = std::max({bestPercent, match.percent, coinMatchThreshold});
+            int matchCount = countWithBound(scale, currentCoin, rotationIndex, patch.packed,
+                                            neededPercent / 100.0 * numTemplateEdges);
+            evaluations++;
+
+            if (matchCount < 0) {
+                highestAbandoned = std::max(highestAbandoned, neededPercent);
+                continue;
+            }
+
+            double percent = matchCount / numTemplateEdges * 100.0;
+            if (percent > match.percent) {
+                match.percent = percent;
+                match.degrees = rotationIndex * templateBank.degreeIncrement();
+            }
+        }
+
+        // An abandoned rotation could have scored up to the bound it failed, which only matters if that is
+        // more than the template's best
+        match.exact = highestAbandoned <= match.percent;
+        bestPercent = std::max(bestPercent, match.percent);
+    }
+    return evaluations;
+}
@@ -0,0 +1,60 @@
+//==============================================================================
+// Coarse-to-Fine Matcher
+//------------------------------------------------------------------------------
+// A faster search over the same template rotations the packed matcher tries 
+// one by one. It runs in two passes:
+//
+//      1. Coarse: every template is scored at every third rotation on edge 
+//         maps downsampled 2x (a quarter of the words to count).
+//      2. Fine: templates are visited from the best coarse score down, and 
+//         only the rotations around each template's best coarse angles are 
+//         counted at full size. Each count runs a block of rows at a time and
+//         is abandoned (branch and bound) as soon as the edges counted so far
+//         plus every template edge left in the remaining rows cannot beat the
+//         best match found yet, or the coinMatchThreshold.
+//
+// The winning template and its percentage are exact counts. A template with 
+// a rotation that was abandoned while it could still have beaten the 
+// template's own best is marked inexact, and its percentage is only a lower 
+// bound. Rotations far from every good coarse angle are never counted, so the
+// result can differ from the exhaustive search; --compare-matchers reports 
+// where it does, and tests/testCoarseToFineMatcher.cpp fails if a coin's 
+// percentage differs by more than its tolerance on any of the test images.
+//
+// The adaptive quality levels (adaptiveQuality.h) make the search cheaper 
+// still: with an angleStep above 1 both passes only visit every angleStep-th
+// rotation, and with templatesRefined set only that many templates, the best
+// coarse scores, are refined at all.
+//==============================================================================
+
+#ifndef COARSE_TO_FINE_MATCHER_H
+#define COARSE_TO_FINE_MATCHER_H
+
+#include "templateBank.h"
+#include "templateMatcher.h"
+
+
+// Coarse pass tries every coarseRotationStride-th rotation
+const int coarseRotationStride{3};
+
+// Fine pass refines this many of each template's best coarse rotations
+const int refinedCoarseRotations{2};
+
+
+/*------------------------------ matchCoarseToFine -----------------------------
+ * Precondition:  scale belongs to templateBank. patch.packed and patch.coarse 
+ *                hold the patch edge image at scale.size and downsampled 2x.
+ * Postcondition: matches[t] is assigned the best rotation and percentage found
+ *                for template t, with exact set to false if its percent is 
+ *                only a lower bound. Only rotations that are multiples of 
+ *                angleStep are tried, and if templatesRefined is above 0 the 
+ *                templates after the first templatesRefined by coarse score 
+ *                keep an empty, inexact match, as do templates not in 
+ *                templateMask. Returns the number of full size 
+ *                template x rotation counts that were started.
+ */
+int matchCoarseToFine(const TemplateBank &templateBank, const TemplateBank::Scale &scale, const PatchEdges &patch,
+                      TemplateMatch matches[numberOfTemplates], int angleStep = 1, int templatesRefined = 0,
+                      unsigned int templateMask = allTemplates);
+
+#endif
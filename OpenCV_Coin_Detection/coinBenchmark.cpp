@@ -0,0 +1,678 @@
+//==============================================================================
+// Coin Benchmark
+//------------------------------------------------------------------------------
+// Times each step of findCoins on its own and the whole detector end to end,
+// on synthetic scenes drawn from the template images (see syntheticScene.h),
+// and writes the results as JSON so runs can be compared over time. The
+// scenes come from a fixed seed, so every run and every machine times the
+// same images.
+//
+// For every resolution, the microbenchmarks run on the calling thread over
+// the candidates of every scene:
+//      preprocessing           Step 1, grayscale, blur, Canny and contours
+//      contourFilter           Step 2, the size and ellipse tests
+//      patchExtraction         Step 3
+//      templatePreparation     Step 4.1, resize, edge image and packing
+//      findNumberOfEdges       edge count of a patch, packed and byte per pixel
+//      rotationMatching        Step 4.3 with each matcher, batched included, and
+//                              packed on true scale scenes with and without
+//                              the size prior's pruning. Each matcher also
+//                              reports the coins it identified as the coin 
+//                              placed there and the candidates it got wrong
+//      sizePrior.estimate      scene scale estimate from the candidates
+// and the end to end benchmarks run the CoinDetector on the worker pool:
+//      endToEnd.latency        one scene at a time, detect and annotate
+//      endToEnd.throughput     every scene at once, one task per scene
+//
+// Usage: CoinBenchmark [options]
+//      --resolutions=WxH,...   scene sizes (default 1280x720,1920x1080,4032x3024)
+//      --coins=N               coins per scene (default 12)
+//      --scenes=N              scenes per resolution (default 4)
+//      --seed=N                seed of the first scene (default 1)
+//      --min-time=SECONDS      time each benchmark for at least this long (default 0.5)
+//      --threads=N             worker threads for the end to end runs
+//      --filter=TEXT           only run benchmarks whose name contains TEXT
+//      --templates=DIR         template directory (default "Template Images/")
+//      --output=FILE           results file (default "benchmark.json")
+//      --baseline=FILE         print the change from an earlier results file
+//      --write-scenes=DIR      also write the scenes as PNG images
+//==============================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "opencv2/imgcodecs.hpp"
+
+#include "batchedClassifier.h"
+#include "coinDetector.h"
+#include "detectionRecord.h"
+#include "detectionScratch.h"
+#include "findCoins.h"
+#include "imageUtilities.h"
+#include "latencySummary.h"
+#include "scaleEstimator.h"
+#include "syntheticScene.h"
+#include "templateBank.h"
+#include "templateMatcher.h"
+#include "workerPool.h"
+
+
+// Version of the results file, raised when the meaning of a field changes
+const int benchmarkFileVersion{1};
+
+
+struct BenchmarkOptions {
+    std::vector<cv::Size> resolutions{cv::Size(1280, 720), cv::Size(1920, 1080), cv::Size(4032, 3024)};
+    int coinsPerScene{12};
+    int scenesPerResolution{4};
+    unsigned int seed{1};
+    double minSeconds{0.5};
+    unsigned int numThreads{0};
+    std::string filter;
+    std::string templateDirectory{"Template Images/"};
+    std::string outputPath{"benchmark.json"};
+    std::string baselinePath;
+    std::string sceneDirectory;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    std::string resolution;         // size the scenes were drawn at
+    std::string workingSize;        // size detection ran at, after downscaling to maxSourceDimension
+    long items{0};                  // images, contours or candidates handled per iteration
+    LatencySummary iterations;      // time of each iteration
+    double itemsPerSecond{0.0};
+    long coinsPlaced{-1};           // end to end and rotation matching only
+    long coinsFound{-1};            // accepted as coins, or for a matcher identified as the coin placed there
+    long coinsWrong{-1};            // rotation matching only, candidates accepted as the wrong coin or no coin
+};
+
+// The candidates of one scene and the prepared edges of each, shared by the microbenchmarks
+struct BenchmarkScene {
+    cv::Mat image;                                  // downscaled to maxSourceDimension like the detector does
+    double imageScale{1.0};                         // image size over the size the coins were drawn at
+    std::vector<SyntheticCoin> coins;
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<CoinDetection> candidates;
+    std::vector<cv::Mat> patches;
+    std::vector<const TemplateBank::Scale *> scales;
+    std::vector<PatchEdges> patchEdges;             // every form any matcher needs
+};
+
+
+/* sizeName
+ * Precondition: None
+ * Postcondition: Returns size as "WxH".
+ */
+static std::string sizeName(const cv::Size &size) {
+    return std::to_string(size.width) + "x" + std::to_string(size.height);
+}
+
+
+/* parseSize
+ * Precondition: None
+ * Postcondition: size is read from text of the form "WxH". Returns false if text is not one.
+ */
+static bool parseSize(const std::string &text, cv::Size &size) {
+    size_t separator = text.find('x');
+    if (separator == std::string::npos) {
+        return false;
+    }
+    try {
+        size = cv::Size(std::stoi(text.substr(0, separator)), std::stoi(text.substr(separator + 1)));
+    } catch (const std::exception &) {
+        return false;
+    }
+    return size.width > 0 && size.height > 0;
+}
+
+
+/* parseUnsigned
+ * Precondition: None
+ * Postcondition: Returns text as an unsigned int. Throws std::out_of_range, as std::stoul does for numbers too large
+ *                for it, if text is not all digits or is greater than maxValue, instead of wrapping "-1" or
+ *                truncating the value.
+ */
+static unsigned int parseUnsigned(const std::string &text, unsigned int maxValue) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        throw std::out_of_range(text);
+    }
+    unsigned long long number = std::stoull(text);
+    if (number > maxValue) {
+        throw std::out_of_range(text);
+    }
+    return (unsigned int) number;
+}
+
+
+/* parseBenchmarkOptions
+ * Precondition: argv holds argc arguments as passed to main.
+ * Postcondition: options is filled in from the arguments. Returns false and prints the problem if one is not
+ *                recognized.
+ */
+static bool parseBenchmarkOptions(int argc, char *argv[], BenchmarkOptions &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        std::string value = argument.substr(argument.find('=') + 1);
+        try {
+            if (argument.rfind("--resolutions=", 0) == 0) {
+                options.resolutions.clear();
+                std::stringstream list(value);
+                std::string item;
+                while (std::getline(list, item, ',')) {
+                    cv::Size size;
+                    if (!parseSize(item, size)) {
+                        std::cout << "Resolutions must look like 1920x1080: " << item << std::endl;
+                        return false;
+                    }
+                    options.resolutions.push_back(size);
+                }
+            } else if (argument.rfind("--coins=", 0) == 0) {
+                options.coinsPerScene = std::max(0, std::stoi(value));
+            } else if (argument.rfind("--scenes=", 0) == 0) {
+                options.scenesPerResolution = std::max(1, std::stoi(value));
+            } else if (argument.rfind("--seed=", 0) == 0) {
+                options.seed = parseUnsigned(value, UINT_MAX);
+            } else if (argument.rfind("--min-time=", 0) == 0) {
+                options.minSeconds = std::max(0.0, std::stod(value));
+            } else if (argument.rfind("--threads=", 0) == 0) {
+                options.numThreads = parseUnsigned(value, (unsigned int) INT_MAX);
+            } else if (argument.rfind("--filter=", 0) == 0) {
+                options.filter = value;
+            } else if (argument.rfind("--templates=", 0) == 0) {
+                options.templateDirectory = value;
+                if (!value.empty() && value.back() != '/' && value.back() != '\\') {
+                    options.templateDirectory += '/';
+                }
+            } else if (argument.rfind("--output=", 0) == 0) {
+                options.outputPath = value;
+            } else if (argument.rfind("--baseline=", 0) == 0) {
+                options.baselinePath = value;
+            } else if (argument.rfind("--write-scenes=", 0) == 0) {
+                options.sceneDirectory = value;
+                if (!value.empty() && value.back() != '/' && value.back() != '\\') {
+                    options.sceneDirectory += '/';
+                }
+            } else {
+                std::cout << "Unrecognized option: " << argument << std::endl;
+                return false;
+            }
+        } catch (const std::exception &) {
+            std::cout << "Not a number or out of range: " << argument << std::endl;
+            return false;
+        }
+    }
+    return !options.resolutions.empty();
+}
+
+
+/* prepareScene
+ * Precondition: templateBank has been loaded and coins were drawn on drawn by renderSyntheticScene.
+ * Postcondition: Returns the scene downscaled like the detector does, with its contours, candidates, patches and
+ *                patch edges.
+ */
+static BenchmarkScene prepareScene(const TemplateBank &templateBank, const cv::Mat &drawn,
+                                   const std::vector<SyntheticCoin> &coins) {
+    BenchmarkScene scene;
+    scene.coins = coins;
+    scene.image = drawn;
+    resizeSourceImage(drawn, scene.image, maxSourceDimension);
+    scene.imageScale = (double) scene.image.cols / drawn.cols;
+
+    DetectionSettings detection;
+    findEdgeContours(scene.image, detection, scene.contours);
+    scene.candidates = filterEllipticalContours(scene.contours, detection, scene.image.size());
+
+    // Keep a copy of every form of each patch's edges, the scratch buffers are overwritten per candidate
+    DetectionScratch &scratch = DetectionScratch::forThisThread();
+    for (const CoinDetection &candidate : scene.candidates) {
+        cv::Mat patch = extractCandidatePatch(scene.image, candidate).clone();
+        const TemplateBank::Scale &scale = preparePatchEdges(templateBank, MatcherType::coarseToFine, patch,
+                                                             candidate);
+        PatchEdges edges;
+        edges.edges = scratch.patchEdges.edges.clone();
+        edges.packed = scratch.patchEdges.packed;
+        edges.coarse = scratch.patchEdges.coarse;
+        preparePatchEdges(templateBank, MatcherType::polar, patch, candidate);
+        edges.polarSpectrum = scratch.patchEdges.polarSpectrum.clone();
+        preparePatchEdges(templateBank, MatcherType::chamfer, patch, candidate);
+        edges.chamferWeights = scratch.patchEdges.chamferWeights.clone();
+
+        scene.patches.push_back(patch);
+        scene.scales.push_back(&scale);
+        scene.patchEdges.push_back(edges);
+    }
+    return scene;
+}
+
+
+/* scoreMatcher
+ * Precondition: scenes were prepared by prepareScene.
+ * Postcondition: Classifies every candidate of scenes with matcher and sets the coins placed in result, the coins
+ *                found (some candidate on the coin was accepted as a coin of its type, either face) and the
+ *                candidates wrong (accepted as a coin of another type, or lying on no coin).
+ */
+static void scoreMatcher(const TemplateBank &templateBank, const std::vector<BenchmarkScene> &scenes,
+                         MatcherType matcher, BenchmarkResult &result) {
+    result.coinsPlaced = 0;
+    result.coinsFound = 0;
+    result.coinsWrong = 0;
+    for (const BenchmarkScene &scene : scenes) {
+        std::vector<bool> identified(scene.coins.size(), false);
+        for (size_t i = 0; i < scene.candidates.size(); i++) {
+            TemplateMatch matches[numberOfTemplates];
+            matchTemplates(templateBank, *scene.scales[i], matcher, scene.patchEdges[i], matches);
+            CoinDetection candidate = scene.candidates[i];
+            chooseBestTemplate(matches, candidate, coinThreshold(matcher, *scene.scales[i]));
+            if (!candidate.isCoin) {
+                continue;
+            }
+
+            // The coin whose centre is within half its radius of the candidate's, if any
+            int coinUnder = -1;
+            for (size_t coinIndex = 0; coinIndex < scene.coins.size(); coinIndex++) {
+                const SyntheticCoin &coin = scene.coins[coinIndex];
+                cv::Point2f centre = coin.centre * (float) scene.imageScale;
+                if (cv::norm(candidate.ellipse.center - centre) < coin.diameter * scene.imageScale / 4.0) {
+                    coinUnder = (int) coinIndex;
+                }
+            }
+
+            // Heads and tails of a coin are adjacent templates
+            if (coinUnder >= 0 && scene.coins[coinUnder].templateIndex / 2 == candidate.templateIndex / 2) {
+                identified[coinUnder] = true;
+            } else {
+                result.coinsWrong++;
+            }
+        }
+        result.coinsPlaced += (long) scene.coins.size();
+        result.coinsFound += (long) std::count(identified.begin(), identified.end(), true);
+    }
+}
+
+
+/* runBenchmark
+ * Precondition: iteration handles items items each time it is called.
+ * Postcondition: Calls iteration once untimed, then repeatedly for at least minSeconds and 3 iterations, and
+ *                returns the summary of their times.
+ */
+static BenchmarkResult runBenchmark(const std::string &name, long items, double minSeconds,
+                                    const std::function<void()> &iteration) {
+    iteration();
+
+    std::vector<double> iterationsMs;
+    auto start = std::chrono::steady_clock::now();
+    double elapsedSeconds = 0.0;
+    while (iterationsMs.size() < 3 || elapsedSeconds < minSeconds) {
+        auto iterationStart = std::chrono::steady_clock::now();
+        iteration();
+        auto iterationEnd = std::chrono::steady_clock::now();
+        iterationsMs.push_back(std::chrono::duration<double, std::milli>(iterationEnd - iterationStart).count());
+        elapsedSeconds = std::chrono::duration<double>(iterationEnd - start).count();
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.items = items;
+    result.iterations = summarizeLatencies(iterationsMs);
+    result.itemsPerSecond = items / std::max(result.iterations.meanMs / 1000.0, 1e-12);
+    return result;
+}
+
+
+/* printResult
+ * Precondition: None
+ * Postcondition: Prints one line with the median time and throughput of result.
+ */
+static void printResult(const BenchmarkResult &result) {
+    std::cout << std::fixed << std::setprecision(3) << std::left << std::setw(34) << result.name
+              << std::setw(11) << result.resolution << std::right << std::setw(12) << result.iterations.p50Ms
+              << " ms" << std::setprecision(1) << std::setw(14) << result.itemsPerSecond << " items/s";
+    if (result.coinsPlaced >= 0) {
+        std::cout << "  found " << result.coinsFound << " of " << result.coinsPlaced << " coins";
+    }
+    std::cout << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+
+/* writeResults
+ * Precondition: None
+ * Postcondition: Writes options and every result to options.outputPath as JSON. Returns false if it cannot.
+ */
+static bool writeResults(const BenchmarkOptions &options, int numThreads, const std::vector<BenchmarkResult> &results) {
+    std::ofstream file(options.outputPath);
+    if (!file) {
+        return false;
+    }
+
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    file << "{" << std::endl
+         << "  \"benchmarkVersion\": " << benchmarkFileVersion << "," << std::endl
+         << "  \"date\": " << jsonString(date) << "," << std::endl
+         << "  \"opencv\": " << jsonString(CV_VERSION) << "," << std::endl
+         << "  \"threads\": " << numThreads << "," << std::endl
+         << "  \"coinsPerScene\": " << options.coinsPerScene << "," << std::endl
+         << "  \"scenesPerResolution\": " << options.scenesPerResolution << "," << std::endl
+         << "  \"seed\": " << options.seed << "," << std::endl
+         << "  \"results\": [" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult &result = results[i];
+        file << "    {\"name\": " << jsonString(result.name)
+             << ", \"resolution\": " << jsonString(result.resolution)
+             << ", \"workingSize\": " << jsonString(result.workingSize)
+             << ", \"items\": " << result.items
+             << ", \"iterations\": " << result.iterations.count
+             << ", \"meanMs\": " << result.iterations.meanMs
+             << ", \"p50Ms\": " << result.iterations.p50Ms
+             << ", \"p95Ms\": " << result.iterations.p95Ms
+             << ", \"maxMs\": " << result.iterations.maxMs
+             << ", \"itemsPerSecond\": " << result.itemsPerSecond;
+        if (result.coinsPlaced >= 0) {
+            file << ", \"coinsPlaced\": " << result.coinsPlaced << ", \"coinsFound\": " << result.coinsFound;
+        }
+        if (result.coinsWrong >= 0) {
+            file << ", \"coinsWrong\": " << result.coinsWrong;
+        }
+        file << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    file << "  ]" << std::endl << "}" << std::endl;
+    return (bool) file;
+}
+
+
+/* compareWithBaseline
+ * Precondition: None
+ * Postcondition: Prints how the median time of every result changed from the result of the same name and
+ *                resolution in the results file at baselinePath. Returns false if it cannot be read.
+ */
+static bool compareWithBaseline(const std::string &baselinePath, const std::vector<BenchmarkResult> &results) {
+    cv::FileStorage baseline(baselinePath, cv::FileStorage::READ);
+    if (!baseline.isOpened()) {
+        return false;
+    }
+
+    std::cout << std::endl << "Change from " << baselinePath << " (median time, negative is faster):" << std::endl;
+    cv::FileNode baselineResults = baseline["results"];
+    for (const BenchmarkResult &result : results) {
+        for (int i = 0; i < (int) baselineResults.size(); i++) {
+            cv::FileNode old = baselineResults[i];
+            if ((std::string) old["name"] != result.name || (std::string) old["resolution"] != result.resolution) {
+                continue;
+            }
+            double oldMs = (double) old["p50Ms"];
+            std::cout << std::fixed << std::setprecision(1) << std::left << std::setw(34) << result.name
+                      << std::setw(11) << result.resolution << std::right << std::setw(9)
+                      << (result.iterations.p50Ms / std::max(oldMs, 1e-12) - 1.0) * 100.0 << " %" << std::endl;
+            std::cout.unsetf(std::ios::floatfield);
+        }
+    }
+    return true;
+}
+
+
+/*------------------------------------ main ------------------------------------
+ * Precondition:  The template directory holds the 8 images named in
+ *                templateFileNames.
+ * Postcondition: Runs every benchmark matching the filter at every
+ *                resolution, prints the median time and throughput of each
+ *                and writes them to the output file. Returns -1 if the
+ *                templates or options cannot be read or the results cannot
+ *                be written.
+ */
+int main(int argc, char *argv[]) {
+
+    BenchmarkOptions options;
+    if (!parseBenchmarkOptions(argc, argv, options)) {
+        return -1;
+    }
+
+    const TemplateBank templateBank(options.templateDirectory);
+    if (!templateBank.loaded()) {
+        std::cout << "Could not read the 8 template images from " << options.templateDirectory << std::endl;
+        return -1;
+    }
+    std::cout << "Templates: " << templateBank.sourceDescription() << std::endl;
+
+    WorkerPool workerPool(options.numThreads);
+    const DetectionSettings detection;
+    const CoinDetector detector(templateBank, workerPool, detection);
+    DetectionSettings batchedSettings = detection;
+    batchedSettings.matcher = MatcherType::batched;
+    const BatchedClassifier batchedClassifier(templateBank, batchedSettings);
+
+    std::vector<BenchmarkResult> results;
+    for (const cv::Size &resolution : options.resolutions) {
+
+        // Draw the scenes and find their candidates once, outside every timed loop
+        std::vector<BenchmarkScene> scenes;
+        std::vector<cv::Mat> drawnScenes;
+        long numContours = 0;
+        long numCandidates = 0;
+        long coinsPlaced = 0;
+        for (int sceneIndex = 0; sceneIndex < options.scenesPerResolution; sceneIndex++) {
+            SceneSettings sceneSettings;
+            sceneSettings.size = resolution;
+            sceneSettings.numCoins = options.coinsPerScene;
+            sceneSettings.seed = options.seed + (unsigned int) sceneIndex;
+
+            std::vector<SyntheticCoin> coins;
+            drawnScenes.push_back(renderSyntheticScene(templateBank, sceneSettings, coins));
+            scenes.push_back(prepareScene(templateBank, drawnScenes.back(), coins));
+            if (!options.sceneDirectory.empty()) {
+                cv::imwrite(options.sceneDirectory + "scene_" + sizeName(resolution) + "_" +
+                            std::to_string(sceneSettings.seed) + ".png", drawnScenes.back());
+            }
+
+            numContours += (long) scenes.back().contours.size();
+            numCandidates += (long) scenes.back().candidates.size();
+            coinsPlaced += (long) scenes.back().coins.size();
+        }
+        const std::string workingSize = sizeName(scenes.front().image.size());
+
+        auto benchmark = [&](const std::string &name, long items, const std::function<void()> &iteration) {
+            if (name.find(options.filter) == std::string::npos) {
+                return;
+            }
+            BenchmarkResult result = runBenchmark(name, items, options.minSeconds, iteration);
+            result.resolution = sizeName(resolution);
+            result.workingSize = workingSize;
+            printResult(result);
+            results.push_back(result);
+        };
+
+        /*----------------------- Steps 1 and 2 per scene --------------------------*/
+        benchmark("preprocessing", (long) scenes.size(), [&] {
+            std::vector<std::vector<cv::Point>> contours;
+            for (const BenchmarkScene &scene : scenes) {
+                findEdgeContours(scene.image, detection, contours);
+            }
+        });
+        benchmark("contourFilter", numContours, [&] {
+            for (const BenchmarkScene &scene : scenes) {
+                filterEllipticalContours(scene.contours, detection, scene.image.size());
+            }
+        });
+
+        /*---------------------- Steps 3 and 4 per candidate -----------------------*/
+        benchmark("patchExtraction", numCandidates, [&] {
+            for (const BenchmarkScene &scene : scenes) {
+                for (const CoinDetection &candidate : scene.candidates) {
+                    extractCandidatePatch(scene.image, candidate);
+                }
+            }
+        });
+        benchmark("templatePreparation", numCandidates, [&] {
+            for (const BenchmarkScene &scene : scenes) {
+                for (size_t i = 0; i < scene.candidates.size(); i++) {
+                    preparePatchEdges(templateBank, MatcherType::packed, scene.patches[i], scene.candidates[i]);
+                }
+            }
+        });
+
+        volatile long edgeCount = 0;
+        benchmark("findNumberOfEdges.packed", numCandidates, [&] {
+            for (const BenchmarkScene &scene : scenes) {
+                for (const PatchEdges &edges : scene.patchEdges) {
+                    edgeCount = edgeCount + findNumberOfEdges(edges.packed);
+                }
+            }
+        });
+        benchmark("findNumberOfEdges.bytes", numCandidates, [&] {
+            for (const BenchmarkScene &scene : scenes) {
+                for (const PatchEdges &edges : scene.patchEdges) {
+                    edgeCount = edgeCount + findNumberOfEdges(edges.edges);
+                }
+            }
+        });
+
+        const std::pair<const char *, MatcherType> matchers[] = {
+                {"rotationMatching.packed", MatcherType::packed},
+                {"rotationMatching.reference", MatcherType::reference},
+                {"rotationMatching.coarse", MatcherType::coarseToFine},
+                {"rotationMatching.polar", MatcherType::polar},
+                {"rotationMatching.chamfer", MatcherType::chamfer}
+        };
+        for (const auto &matcher : matchers) {
+            benchmark(matcher.first, numCandidates, [&] {
+                TemplateMatch matches[numberOfTemplates];
+                for (const BenchmarkScene &scene : scenes) {
+                    for (size_t i = 0; i < scene.patchEdges.size(); i++) {
+                        matchTemplates(templateBank, *scene.scales[i], matcher.second, scene.patchEdges[i], matches);
+                    }
+                }
+            });
+
+            // How often each matcher names the coin actually placed, untimed
+            if (!results.empty() && results.back().name == matcher.first) {
+                BenchmarkResult &result = results.back();
+                scoreMatcher(templateBank, scenes, matcher.second, result);
+                std::cout << "    identified " << result.coinsFound << " of " << result.coinsPlaced << " coins, "
+                          << result.coinsWrong << " candidates wrong" << std::endl;
+            }
+        }
+
+        // The packed matcher on scenes of coins at their real size ratios, matching every coin type and then only
+        // the types the size prior leaves each candidate
+        std::vector<BenchmarkScene> priorScenes;
+        long numPriorCandidates = 0;
+        long pruned = 0;
+        for (int sceneIndex = 0; sceneIndex < options.scenesPerResolution; sceneIndex++) {
+            SceneSettings sceneSettings;
+            sceneSettings.size = resolution;
+            sceneSettings.numCoins = options.coinsPerScene;
+            sceneSettings.seed = options.seed + (unsigned int) sceneIndex;
+            sceneSettings.trueScale = true;
+
+            std::vector<SyntheticCoin> coins;
+            cv::Mat drawn = renderSyntheticScene(templateBank, sceneSettings, coins);
+            priorScenes.push_back(prepareScene(templateBank, drawn, coins));
+            applySizePrior(priorScenes.back().candidates);
+            for (const CoinDetection &candidate : priorScenes.back().candidates) {
+                pruned += numberOfTemplates - countTemplates(candidate.plausibleTemplates);
+            }
+            numPriorCandidates += (long) priorScenes.back().candidates.size();
+        }
+        std::cout << "Size prior ruled out " << pruned << " of " << numPriorCandidates * numberOfTemplates
+                  << " template comparisons on true scale scenes" << std::endl;
+
+        benchmark("sizePrior.estimate", (long) priorScenes.size(), [&] {
+            for (BenchmarkScene &scene : priorScenes) {
+                applySizePrior(scene.candidates);
+            }
+        });
+        for (bool usePrior : {false, true}) {
+            benchmark(usePrior ? "rotationMatching.sizePrior" : "rotationMatching.trueScale", numPriorCandidates, [&] {
+                TemplateMatch matches[numberOfTemplates];
+                for (const BenchmarkScene &scene : priorScenes) {
+                    for (size_t i = 0; i < scene.patchEdges.size(); i++) {
+                        matchTemplates(templateBank, *scene.scales[i], MatcherType::packed, scene.patchEdges[i],
+                                       matches, 1, 0, usePrior ? scene.candidates[i].plausibleTemplates : allTemplates);
+                    }
+                }
+            });
+        }
+
+        // The batched matcher extracts and prepares its own patches, on the pool, as it does when detecting
+        benchmark("rotationMatching.batched", numCandidates, [&] {
+            std::vector<CoinDetection> candidates;
+            std::vector<CandidateClassifier::Item> items;
+            for (const BenchmarkScene &scene : scenes) {
+                candidates.insert(candidates.end(), scene.candidates.begin(), scene.candidates.end());
+            }
+            size_t next = 0;
+            for (const BenchmarkScene &scene : scenes) {
+                for (size_t i = 0; i < scene.candidates.size(); i++) {
+                    items.push_back({&scene.image, &candidates[next++]});
+                }
+            }
+            batchedClassifier.classify(workerPool, items);
+        });
+
+        /*------------------------------- End to end -------------------------------*/
+        std::vector<std::vector<CoinDetection>> detections(drawnScenes.size());
+        auto countFound = [&](BenchmarkResult &result) {
+            long found = 0;
+            for (const std::vector<CoinDetection> &sceneDetections : detections) {
+                found += std::count_if(sceneDetections.begin(), sceneDetections.end(),
+                                       [](const CoinDetection &candidate) { return candidate.isCoin; });
+            }
+            result.coinsPlaced = coinsPlaced;
+            result.coinsFound = found;
+        };
+
+        benchmark("endToEnd.latency", (long) drawnScenes.size(), [&] {
+            for (size_t sceneIndex = 0; sceneIndex < drawnScenes.size(); sceneIndex++) {
+                cv::Mat sourceImg = drawnScenes[sceneIndex];
+                resizeSourceImage(drawnScenes[sceneIndex], sourceImg, maxSourceDimension);
+                detections[sceneIndex] = detector.detect(sourceImg);
+                cv::Mat outputImg = sourceImg.clone();
+                annotateCoins(detections[sceneIndex], outputImg);
+            }
+        });
+        if (!results.empty() && results.back().name == "endToEnd.latency") {
+            countFound(results.back());
+        }
+
+        benchmark("endToEnd.throughput", (long) drawnScenes.size(), [&] {
+            WorkerPool::TaskGroup sceneTasks;
+            for (size_t sceneIndex = 0; sceneIndex < drawnScenes.size(); sceneIndex++) {
+                workerPool.run(sceneTasks, [&, sceneIndex] {
+                    cv::Mat sourceImg = drawnScenes[sceneIndex];
+                    resizeSourceImage(drawnScenes[sceneIndex], sourceImg, maxSourceDimension);
+                    detections[sceneIndex] = detector.detect(sourceImg);
+                    cv::Mat outputImg = sourceImg.clone();
+                    annotateCoins(detections[sceneIndex], outputImg);
+                });
+            }
+            workerPool.wait(sceneTasks);
+        });
+        if (!results.empty() && results.back().name == "endToEnd.throughput") {
+            countFound(results.back());
+        }
+    }
+
+    if (!writeResults(options, workerPool.numThreads(), results)) {
+        std::cout << "Could not write " << options.outputPath << std::endl;
+        return -1;
+    }
+    std::cout << "Wrote " << results.size() << " results to " << options.outputPath << std::endl;
+
+    if (!options.baselinePath.empty() && !compareWithBaseline(options.baselinePath, results)) {
+        std::cout << "Could not read the baseline " << options.baselinePath << std::endl;
+    }
+    return 0;
+}
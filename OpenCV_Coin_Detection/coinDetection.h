@@ -0,0 +1,46 @@
+//==============================================================================
+// CoinDetection
+//------------------------------------------------------------------------------
+// What findCoins learns about one elliptical contour. Every contour that fits 
+// well in an ellipse becomes a CoinDetection. isCoin is set once its patch 
+// has been matched against the templates and scored above the threshold of
+// the matcher (coinThreshold in templateMatcher.h).
+// A DetectionQuality says how thoroughly an image was searched when it was 
+// detected within a time budget.
+//==============================================================================
+
+#ifndef COIN_DETECTION_H
+#define COIN_DETECTION_H
+
+#include <string>
+
+#include "opencv2/core.hpp"
+
+
+struct CoinDetection {
+    int contourIndex{0};            // index of the contour in findContours order
+    cv::Rect boundingRect;          // bounding rectangle of the contour
+    cv::RotatedRect ellipse;        // ellipse fitted to the contour
+    int templateIndex{0};           // best matching template, a CoinTemplate
+    double matchPercent{0.0};       // percentage of that template's edges matched, or its chamfer score
+    int rotationDegrees{0};         // rotation of the template that matched best
+    bool isCoin{false};             // matchPercent is above coinThreshold for the matcher
+    std::string matcherReport;      // differences found by --compare-matchers, if any
+    int matcherEvaluations{0};      // full size template x rotation edge counts run on the patch
+    unsigned int plausibleTemplates{0xFFu};  // bit t set if CoinTemplate t is matched, see scaleEstimator.h
+    int trackId{-1};                // coin followed across video frames by a CoinTracker, -1 for a still image
+};
+
+
+// The quality levels an image was detected at, see adaptiveQuality.h. Level 0
+// is the detector's own settings, higher levels are faster and coarser.
+struct DetectionQuality {
+    int level{0};                   // lowest quality any step ran at, the larger of the two below
+    int detectionLevel{0};          // level of Steps 1 and 2
+    int classificationLevel{0};     // lowest quality level any candidate was classified at
+    cv::Size workingSize;           // size the image was searched at
+    double elapsedMs{0.0};          // time detect took
+    double budgetMs{0.0};           // time it was given, 0 if it had no budget
+};
+
+#endif
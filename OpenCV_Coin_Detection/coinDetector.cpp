@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+#include "coinDetector.h"
+#include "batchedClassifier.h"
+#include "findCoins.h"
+#include "imageUtilities.h"
+#include "scaleEstimator.h"
+#include "stageTrace.h"
+#include "templateMatcher.h"
+#include "tiledDetection.h"
+
+
+/* describeCandidateDifferences
+ * Precondition: candidates and reference were found in the same sourceImg.
+ * Postcondition: Returns a line for every ellipse of one list that has no ellipse in the other with its centre 
+ *                within a tenth of its diameter and a size within a tenth of its own. Empty if they agree.
+ */
+static std::string describeCandidateDifferences(const std::vector<CoinDetection> &candidates,
+                                                const std::vector<CoinDetection> &reference) {
+    auto sameEllipse = [](const cv::RotatedRect &a, const cv::RotatedRect &b) {
+        double diameter = std::max(a.size.width, a.size.height);
+        cv::Point2f offset = a.center - b.center;
+        return std::sqrt(offset.x * offset.x + offset.y * offset.y) <= diameter * 0.1 &&
+               std::abs(std::max(b.size.width, b.size.height) - diameter) <= diameter * 0.1;
+    };
+
+    std::stringstream report;
+    auto reportUnmatched = [&](const std::vector<CoinDetection> &found, const std::vector<CoinDetection> &other,
+                               const char *onlyIn) {
+        for (const CoinDetection &candidate : found) {
+            bool matched = std::any_of(other.begin(), other.end(), [&](const CoinDetection &otherCandidate) {
+                return sameEllipse(candidate.ellipse, otherCandidate.ellipse);
+            });
+            if (!matched) {
+                report << "  only " << onlyIn << ": ellipse at (" << candidate.ellipse.center.x << ", "
+                       << candidate.ellipse.center.y << ") size " << candidate.ellipse.size.width << " x "
+                       << candidate.ellipse.size.height << std::endl;
+            }
+        }
+    };
+    reportUnmatched(candidates, reference, "pyramid level");
+    reportUnmatched(reference, candidates, "full resolution");
+    return report.str();
+}
+
+
+/* CoinDetector
+ * Precondition: templateBank has been loaded, and it and workerPool outlive the CoinDetector.
+ * Postcondition: Creates a detector using settings and classifier, or template matching if classifier is null.
+ */
+CoinDetector::CoinDetector(const TemplateBank &templateBank, WorkerPool &workerPool, const DetectionSettings &settings,
+                           std::shared_ptr<const CandidateClassifier> classifier)
+        : templateBank(templateBank), workerPool(workerPool), detectionSettings(settings),
+          classifier(std::move(classifier)) {
+    bool usesTemplateMatching = false;
+
+    // The batched matcher flattens the templates once here rather than per image
+    if (!this->classifier && settings.matcher == MatcherType::batched) {
+        this->classifier = std::make_shared<const BatchedClassifier>(templateBank, settings);
+        usesTemplateMatching = true;
+    } else if (!this->classifier) {
+        this->classifier = std::make_shared<const TemplateMatchClassifier>(templateBank, settings);
+        usesTemplateMatching = true;
+    }
+
+    // Level 0 is this detector's own classifier, the faster levels match templates with less effort
+    if (settings.timeBudgetMs > 0.0 && settings.tileSize == 0) {
+        qualityController = std::make_unique<QualityController>(settings.timeBudgetMs, workerPool.numThreads());
+        for (int level = 0; level < numberOfQualityLevels; level++) {
+            levelSettings.push_back(settingsForLevel(settings, level));
+            if (level == 0 || !usesTemplateMatching) {
+                levelClassifiers.push_back(this->classifier);
+            } else {
+                levelClassifiers.push_back(std::make_shared<const TemplateMatchClassifier>(templateBank,
+                                                                                           levelSettings.back()));
+            }
+        }
+    }
+}
+
+
+/* scaleToImage
+ * Precondition: candidates were found in sourceImg, a copy of image downscaled to sourceSize.
+ * Postcondition: The bounding rectangles and ellipses of candidates are in the coordinates of image.
+ */
+static void scaleToImage(const cv::Mat &image, const cv::Size &sourceSize, std::vector<CoinDetection> &candidates) {
+    if (sourceSize == image.size()) {
+        return;
+    }
+
+    // Scale the shapes found in the downscaled copy back to image, pixel centre to pixel centre
+    double scaleX = (double) image.cols / sourceSize.width;
+    double scaleY = (double) image.rows / sourceSize.height;
+    for (CoinDetection &candidate : candidates) {
+        const cv::Rect &sourceRect = candidate.boundingRect;
+        int left = (int) std::floor(sourceRect.x * scaleX);
+        int top = (int) std::floor(sourceRect.y * scaleY);
+        int right = (int) std::ceil((sourceRect.x + sourceRect.width) * scaleX);
+        int bottom = (int) std::ceil((sourceRect.y + sourceRect.height) * scaleY);
+        candidate.boundingRect = cv::Rect(left, top, right - left, bottom - top) &
+                                 cv::Rect(0, 0, image.cols, image.rows);
+
+        cv::RotatedRect &ellipse = candidate.ellipse;
+        ellipse.center = cv::Point2f((float) ((ellipse.center.x + 0.5) * scaleX - 0.5),
+                                     (float) ((ellipse.center.y + 0.5) * scaleY - 0.5));
+        ellipse.size = cv::Size2f((float) (ellipse.size.width * scaleX), (float) (ellipse.size.height * scaleY));
+    }
+}
+
+
+/* countAcceptedCoins
+ * Precondition: candidates have been classified.
+ * Postcondition: The coins among candidates are added to the coinsAccepted trace counter.
+ */
+static void countAcceptedCoins(const std::vector<CoinDetection> &candidates) {
+#if COIN_TRACING
+    if (StageTrace::recording()) {
+        long coins = std::count_if(candidates.begin(), candidates.end(),
+                                   [](const CoinDetection &candidate) { return candidate.isCoin; });
+        TRACE_COUNT(TraceCounter::coinsAccepted, coins);
+    }
+#else
+    (void) candidates;
+#endif
+}
+
+
+/* detect
+ * Precondition: image is a BGR image with rows and cols greater than 0.
+ * Postcondition: Returns every candidate found in image, in contour order and in the coordinates of image.
+ */
+std::vector<CoinDetection> CoinDetector::detect(const cv::Mat &image) const {
+    DetectionQuality quality;
+    return detect(image, quality);
+}
+
+
+/* detect
+ * Precondition: image is a BGR image with rows and cols greater than 0.
+ * Postcondition: Returns every candidate found in image, and the quality it was found at.
+ */
+std::vector<CoinDetection> CoinDetector::detect(const cv::Mat &image, DetectionQuality &quality) const {
+    TRACE_STAGE(detectTimer, TraceStage::detect);
+    auto start = std::chrono::steady_clock::now();
+    quality = DetectionQuality();
+
+    if (qualityController) {
+        return detectWithinBudget(image, quality);
+    }
+
+    // Large scans keep their full resolution and are searched tile by tile
+    std::vector<std::vector<CoinDetection>> candidates(1);
+    if (detectionSettings.tileSize > 0) {
+        candidates[0] = detectCoinsTiled(workerPool, templateBank, detectionSettings, image);
+        quality.workingSize = image.size();
+    } else {
+        std::vector<cv::Mat> sourceImgs(1);
+        candidates[0] = findInImage(image, sourceImgs[0], detectionSettings, maxSourceDimension);
+        classifyCandidates(sourceImgs, candidates);
+        scaleToImage(image, sourceImgs[0].size(), candidates[0]);
+        quality.workingSize = sourceImgs[0].size();
+    }
+    countAcceptedCoins(candidates[0]);
+    quality.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return std::move(candidates[0]);
+}
+
+
+/* detectWithinBudget
+ * Precondition: image is a BGR image with rows and cols greater than 0, and the detector has a qualityController.
+ * Postcondition: Returns every candidate found in image at the levels the time budget allows, and those levels.
+ */
+std::vector<CoinDetection> CoinDetector::detectWithinBudget(const cv::Mat &image, DetectionQuality &quality) const {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&] {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    const double budgetMs = qualityController->budget();
+
+    // Steps 1 and 2 at the best level that fits their share of the budget
+    quality.detectionLevel = qualityController->chooseDetectionLevel(image.size());
+    cv::Mat sourceImg;
+    std::vector<CoinDetection> candidates = findInImage(image, sourceImg, levelSettings[quality.detectionLevel],
+                                                        qualityLevels[quality.detectionLevel].workingDimension);
+    qualityController->recordDetection(quality.detectionLevel, sourceImg.size(), elapsedMs());
+
+    // Classify a few candidates per worker at a time, each group at the best level the time left allows for all
+    // the candidates still waiting. The level only ever steps down, so one image is not classified unevenly.
+    const size_t groupSize = (size_t) std::max(8, workerPool.numThreads() * 2);
+    int level = 0;
+    std::vector<CandidateClassifier::Item> items;
+    for (size_t first = 0; first < candidates.size(); first += groupSize) {
+        size_t last = std::min(candidates.size(), first + groupSize);
+        level = qualityController->chooseClassificationLevel((int) (candidates.size() - first),
+                                                             budgetMs - elapsedMs(), level);
+        items.clear();
+        for (size_t candidateIndex = first; candidateIndex < last; candidateIndex++) {
+            items.push_back({&sourceImg, &candidates[candidateIndex]});
+        }
+
+        double groupStart = elapsedMs();
+        levelClassifiers[level]->classify(workerPool, items);
+        qualityController->recordClassification(level, (int) items.size(), elapsedMs() - groupStart);
+    }
+    quality.classificationLevel = level;
+    quality.level = std::max(quality.detectionLevel, quality.classificationLevel);
+
+    scaleToImage(image, sourceImg.size(), candidates);
+    countAcceptedCoins(candidates);
+    quality.workingSize = sourceImg.size();
+    quality.budgetMs = budgetMs;
+    quality.elapsedMs = elapsedMs();
+    return candidates;
+}
+
+
+/* detect
+ * Precondition: Every image is a BGR image with rows and cols greater than 0.
+ * Postcondition: Returns the candidates of each image, classified together.
+ */
+std::vector<std::vector<CoinDetection>> CoinDetector::detect(const std::vector<cv::Mat> &images) const {
+    TRACE_STAGE(detectTimer, TraceStage::detect);
+    std::vector<std::vector<CoinDetection>> candidates(images.size());
+
+    if (detectionSettings.tileSize > 0) {
+        for (size_t imageIndex = 0; imageIndex < images.size(); imageIndex++) {
+            candidates[imageIndex] = detectCoinsTiled(workerPool, templateBank, detectionSettings, images[imageIndex]);
+            countAcceptedCoins(candidates[imageIndex]);
+        }
+        return candidates;
+    }
+
+    // Each image has its own budget, so they are not classified together
+    if (qualityController) {
+        workerPool.parallelFor((int) images.size(), [&](int imageIndex) {
+            candidates[imageIndex] = detect(images[imageIndex]);
+        });
+        return candidates;
+    }
+
+    // Find the candidates of every image first, one task per image, then classify them all at once
+    std::vector<cv::Mat> sourceImgs(images.size());
+    workerPool.parallelFor((int) images.size(), [&](int imageIndex) {
+        candidates[imageIndex] = findInImage(images[imageIndex], sourceImgs[imageIndex], detectionSettings,
+                                             maxSourceDimension);
+    });
+    classifyCandidates(sourceImgs, candidates);
+    for (size_t imageIndex = 0; imageIndex < images.size(); imageIndex++) {
+        scaleToImage(images[imageIndex], sourceImgs[imageIndex].size(), candidates[imageIndex]);
+        countAcceptedCoins(candidates[imageIndex]);
+    }
+    return candidates;
+}
+
+
+/* findInImage
+ * Precondition: image is a BGR image with rows and cols greater than 0.
+ * Postcondition: sourceImg is image downscaled to at most maxDimension, and its candidates found with settings are
+ *                returned.
+ */
+std::vector<CoinDetection> CoinDetector::findInImage(const cv::Mat &image, cv::Mat &sourceImg,
+                                                     const DetectionSettings &settings, int maxDimension) const {
+
+    // Search a copy downscaled to a max dimension of 2500 pixels (or less with a time budget), or image itself if
+    // it is no larger
+    sourceImg = image;
+    resizeSourceImage(image, sourceImg, maxDimension);
+
+    std::vector<CoinDetection> candidates = findCandidates(sourceImg, settings);
+
+    // Leave each candidate only the coin types its size fits, once the scale of the image is known
+    if (settings.sizePrior) {
+        applySizePrior(candidates);
+    }
+
+    // If requested, check the ellipses found on the pyramid level against the full resolution path
+    if (settings.compareDetection && settings.pyramidLevels > 0) {
+        DetectionSettings fullResolution = settings;
+        fullResolution.pyramidLevels = 0;
+        fullResolution.blurSigma = 0.0;
+        std::string report = describeCandidateDifferences(candidates, findCandidates(sourceImg, fullResolution));
+        if (!report.empty()) {
+            std::cout << "Pyramid detection differences:" << std::endl << report;
+        }
+    }
+    return candidates;
+}
+
+
+/* classifyCandidates
+ * Precondition: candidates[i] were found in sourceImgs[i].
+ * Postcondition: Every candidate is classified.
+ */
+void CoinDetector::classifyCandidates(const std::vector<cv::Mat> &sourceImgs,
+                                      std::vector<std::vector<CoinDetection>> &candidates) const {
+    std::vector<CandidateClassifier::Item> items;
+    for (size_t imageIndex = 0; imageIndex < candidates.size(); imageIndex++) {
+        for (CoinDetection &candidate : candidates[imageIndex]) {
+            items.push_back({&sourceImgs[imageIndex], &candidate});
+        }
+    }
+
+    // One call for every image, so a batched classifier can fill its batches across them
+    classifier->classify(workerPool, items);
+}
+
+
+/* printSummary
+ * Precondition: detections were returned by detect.
+ * Postcondition: Writes the quality level if there is a budget, the coarse-to-fine savings, the size prior's prune
+ *                rate, any matcher differences and a line per coin to out.
+ */
+void CoinDetector::printSummary(const std::vector<CoinDetection> &detections, std::ostream &out,
+                                const DetectionQuality *quality) const {
+
+    if (quality && qualityController) {
+        out << "Detected at quality " << qualityLevels[quality->level].name << " (level " << quality->level
+            << ", working size " << quality->workingSize.width << " x " << quality->workingSize.height << ") in "
+            << std::round(quality->elapsedMs) << " of " << quality->budgetMs << " ms" << std::endl;
+    }
+
+    // Report how much of the exhaustive rotation sweep the coarse-to-fine search skipped
+    if (detectionSettings.matcher == MatcherType::coarseToFine && !detections.empty()) {
+        long evaluations = 0;
+        for (const CoinDetection &candidate : detections) {
+            evaluations += candidate.matcherEvaluations;
+        }
+        long exhaustive = (long) detections.size() * numberOfTemplates * templateBank.numRotations();
+        out << "Coarse-to-fine search ran " << evaluations << " of " << exhaustive
+            << " template x rotation evaluations (" << exhaustive - evaluations << " saved)" << std::endl;
+    }
+
+    // Report how many template comparisons the size prior ruled out
+    if (detectionSettings.sizePrior && detectionSettings.tileSize == 0 && !detections.empty()) {
+        long pruned = 0;
+        for (const CoinDetection &candidate : detections) {
+            pruned += numberOfTemplates - countTemplates(candidate.plausibleTemplates);
+        }
+        long comparisons = (long) detections.size() * numberOfTemplates;
+        if (pruned == 0) {
+            out << "Size prior found no unambiguous scale, every coin type was matched" << std::endl;
+        } else {
+            out << "Size prior ruled out " << pruned << " of " << comparisons << " template comparisons ("
+                << std::round(100.0 * pruned / comparisons) << "% pruned)" << std::endl;
+        }
+    }
+
+    for (const CoinDetection &candidate : detections) {
+        if (!candidate.matcherReport.empty()) {
+            out << "Matcher differences on contour " << candidate.contourIndex << ":" << std::endl
+                << candidate.matcherReport;
+        }
+        if (candidate.isCoin) {
+            out << "Patch Closest to " << coinNames[candidate.templateIndex] << " with " << candidate.matchPercent
+                << (detectionSettings.matcher == MatcherType::chamfer ? "% chamfer score" : "% matching edges")
+                << std::endl;
+        }
+    }
+}
+
+
+const DetectionSettings &CoinDetector::settings() const {
+    return detectionSettings;
+}
+
+
+const TemplateBank &CoinDetector::templates() const {
+    return templateBank;
+}
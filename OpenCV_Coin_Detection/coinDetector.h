@@ -0,0 +1,146 @@
+//==============================================================================
+// CoinDetector
+//------------------------------------------------------------------------------
+// The detection steps of findCoins behind one object, for programs that link 
+// the CoinDetector library instead of running the command line tool. A 
+// CoinDetector holds a loaded TemplateBank, the WorkerPool its candidates are
+// classified on and the DetectionSettings it was made with; detect takes an 
+// image and returns every candidate found in it:
+//
+//      TemplateBank templateBank("Template Images/");
+//      WorkerPool workerPool;
+//      CoinDetector detector(templateBank, workerPool);
+//      std::vector<CoinDetection> coins = detector.detect(image);
+//
+// Candidates are classified by a CandidateClassifier (candidateClassifier.h),
+// template matching unless another is given, so a program can plug in its 
+// own. Tiled scans (settings.tileSize) are always classified by template 
+// matching.
+//
+// With settings.timeBudgetMs set, detect lowers the working resolution and 
+// the matcher effort of each image as far as it needs to finish in about that
+// time (adaptiveQuality.h), and reports the quality levels it used. A 
+// classifier given to the constructor is used at every level; only template
+// matching has cheaper levels of its own.
+//
+// detect never modifies its image and may be called from several threads, or
+// from tasks of the pool, at once. Each worker classifies candidates in its 
+// own DetectionScratch, so the buffers of the per-contour loop are reused 
+// across contours and images.
+//==============================================================================
+
+#ifndef COIN_DETECTOR_H
+#define COIN_DETECTOR_H
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "adaptiveQuality.h"
+#include "candidateClassifier.h"
+#include "coinDetection.h"
+#include "detectionSettings.h"
+#include "templateBank.h"
+#include "workerPool.h"
+
+
+class CoinDetector {
+public:
+
+    /*------------------------------- CoinDetector -----------------------------
+     * Precondition:  templateBank has been loaded. templateBank and workerPool
+     *                outlive the CoinDetector.
+     * Postcondition: Creates a detector using settings. Candidates are 
+     *                classified by classifier, or if it is null by template 
+     *                matching with the matcher settings selects.
+     */
+    CoinDetector(const TemplateBank &templateBank, WorkerPool &workerPool,
+                 const DetectionSettings &settings = DetectionSettings(),
+                 std::shared_ptr<const CandidateClassifier> classifier = nullptr);
+
+    /*----------------------------------- detect -------------------------------
+     * Precondition:  image is a BGR image with rows and cols greater than 0.
+     * Postcondition: Steps 1 to 6 of findCoins. Returns every contour of image
+     *                that fits well in an ellipse, in contour order, with the 
+     *                ones matched as coins marked isCoin. Images larger than 
+     *                maxSourceDimension are searched at that size (or tile by
+     *                tile at full resolution if settings.tileSize is set), but
+     *                the coordinates returned are always in image.
+     */
+    std::vector<CoinDetection> detect(const cv::Mat &image) const;
+
+    /*----------------------------------- detect -------------------------------
+     * Precondition:  image is a BGR image with rows and cols greater than 0.
+     * Postcondition: Returns detect(image). quality is assigned the levels it
+     *                was detected at, all 0 unless settings.timeBudgetMs is 
+     *                set, and the time it took.
+     */
+    std::vector<CoinDetection> detect(const cv::Mat &image, DetectionQuality &quality) const;
+
+    /*----------------------------------- detect -------------------------------
+     * Precondition:  Every image is a BGR image with rows and cols greater 
+     *                than 0.
+     * Postcondition: Returns detect(images[i]) as element i. With 
+     *                MatcherType::batched the candidates of all the images 
+     *                are classified together, so small images still fill 
+     *                whole batches.
+     */
+    std::vector<std::vector<CoinDetection>> detect(const std::vector<cv::Mat> &images) const;
+
+    /*-------------------------------- printSummary ----------------------------
+     * Precondition:  detections were returned by detect.
+     * Postcondition: Writes the line findCoins prints for every coin, any 
+     *                --compare-matchers differences, for the coarse-to-fine 
+     *                matcher the evaluations it saved, and with the size 
+     *                prior the template comparisons it ruled out, to out.
+     *                If quality is given and the detector has a time budget,
+     *                also writes the quality the image was detected at.
+     */
+    void printSummary(const std::vector<CoinDetection> &detections, std::ostream &out,
+                      const DetectionQuality *quality = nullptr) const;
+
+    const DetectionSettings &settings() const;
+    const TemplateBank &templates() const;
+
+private:
+
+    /*------------------------------- findInImage ------------------------------
+     * Precondition:  image is a BGR image with rows and cols greater than 0.
+     * Postcondition: Steps 1 and 2 with settings. sourceImg is image, or a 
+     *                copy downscaled to maxDimension, and its candidates are
+     *                returned.
+     */
+    std::vector<CoinDetection> findInImage(const cv::Mat &image, cv::Mat &sourceImg,
+                                           const DetectionSettings &settings, int maxDimension) const;
+
+    /*----------------------------- detectWithinBudget -------------------------
+     * Precondition:  image is a BGR image with rows and cols greater than 0.
+     *                The detector has a qualityController.
+     * Postcondition: Returns detect(image), found and classified at the 
+     *                levels qualityController picks, which quality is 
+     *                assigned.
+     */
+    std::vector<CoinDetection> detectWithinBudget(const cv::Mat &image, DetectionQuality &quality) const;
+
+    /*---------------------------- classifyCandidates --------------------------
+     * Precondition:  candidates[i] were found in sourceImgs[i] by findInImage.
+     * Postcondition: Steps 3 to 6 for every candidate of every image, by one 
+     *                call to the classifier.
+     */
+    void classifyCandidates(const std::vector<cv::Mat> &sourceImgs,
+                            std::vector<std::vector<CoinDetection>> &candidates) const;
+
+    const TemplateBank &templateBank;
+    WorkerPool &workerPool;
+    DetectionSettings detectionSettings;
+    std::shared_ptr<const CandidateClassifier> classifier;
+
+    // Only with a time budget: the cost estimates, and the settings and classifier of each quality level
+    std::unique_ptr<QualityController> qualityController;
+    std::vector<DetectionSettings> levelSettings;
+    std::vector<std::shared_ptr<const CandidateClassifier>> levelClassifiers;
+};
+
+#endif
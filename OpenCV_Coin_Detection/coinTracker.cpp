@@ -0,0 +1,151 @@
+#include <cfloat>
+#include <cmath>
+
+#include "coinTracker.h"
+#include "findCoins.h"
+
+
+/* CoinTracker
+ * Precondition: None
+ * Postcondition: No coins are tracked yet.
+ */
+CoinTracker::CoinTracker(const TrackerSettings &settings) : trackerSettings(settings) {}
+
+
+/* sameCoin
+ * Precondition: None
+ * Postcondition: Returns true if candidate's centre is within positionTolerance diameters of tracked's centre and 
+ *                its width and height are within sizeTolerance of tracked's.
+ */
+bool CoinTracker::sameCoin(const cv::RotatedRect &tracked, const cv::RotatedRect &candidate) const {
+    double diameter = std::max(tracked.size.width, tracked.size.height);
+    cv::Point2f offset = candidate.center - tracked.center;
+    if (std::sqrt(offset.x * offset.x + offset.y * offset.y) > trackerSettings.positionTolerance * diameter) {
+        return false;
+    }
+
+    // fitEllipse may swap width and height between frames for a nearly round coin
+    double trackedMin = std::min(tracked.size.width, tracked.size.height);
+    double candidateMin = std::min(candidate.size.width, candidate.size.height);
+    double candidateMax = std::max(candidate.size.width, candidate.size.height);
+    return std::abs(candidateMax - diameter) <= trackerSettings.sizeTolerance * diameter &&
+           std::abs(candidateMin - trackedMin) <= trackerSettings.sizeTolerance * trackedMin;
+}
+
+
+/* update
+ * Precondition: frame has been resized the same way as every earlier frame. templateBank has been loaded.
+ * Postcondition: Returns the classified candidates of frame, and the tracked coins are updated.
+ */
+std::vector<CoinDetection> CoinTracker::update(WorkerPool &workerPool, const TemplateBank &templateBank,
+                                               const DetectionSettings &settings, const cv::Mat &frame) {
+    return track(findCandidates(frame, settings), workerPool, [&](CoinDetection &candidate) {
+        classifyCandidate(templateBank, settings, frame, candidate);
+    });
+}
+
+
+/* track
+ * Precondition: candidates are the unclassified candidates of the next frame. classify is safe to call from 
+ *               several workers at once.
+ * Postcondition: Returns candidates, classified by classify or by the coin each was paired with and labelled with
+ *                its trackId, and the tracked coins are updated.
+ */
+std::vector<CoinDetection> CoinTracker::track(std::vector<CoinDetection> candidates, WorkerPool &workerPool,
+                                              const std::function<void(CoinDetection &)> &classify) {
+
+    // Pair each candidate with the nearest tracked coin that is still in the same place and the same size
+    std::vector<int> trackOfCandidate(candidates.size(), -1);
+    std::vector<bool> trackPaired(tracks.size(), false);
+    for (int candidateIndex = 0; candidateIndex < (int) candidates.size(); candidateIndex++) {
+        const cv::RotatedRect &ellipse = candidates[candidateIndex].ellipse;
+
+        double nearestDistance = DBL_MAX;
+        for (int trackIndex = 0; trackIndex < (int) tracks.size(); trackIndex++) {
+            const cv::RotatedRect &tracked = tracks[trackIndex].detection.ellipse;
+            if (trackPaired[trackIndex] || !sameCoin(tracked, ellipse)) {
+                continue;
+            }
+
+            cv::Point2f offset = ellipse.center - tracked.center;
+            double distance = offset.x * offset.x + offset.y * offset.y;
+            if (distance < nearestDistance) {
+                nearestDistance = distance;
+                trackOfCandidate[candidateIndex] = trackIndex;
+            }
+        }
+
+        if (trackOfCandidate[candidateIndex] >= 0) {
+            trackPaired[trackOfCandidate[candidateIndex]] = true;
+        }
+    }
+
+    // Reuse the classification of paired coins, and list the rest to be classified
+    std::vector<int> toClassify;
+    for (int candidateIndex = 0; candidateIndex < (int) candidates.size(); candidateIndex++) {
+        int trackIndex = trackOfCandidate[candidateIndex];
+        bool stale = trackIndex >= 0 && trackerSettings.reclassifyInterval > 0 &&
+                     tracks[trackIndex].framesSinceClassified + 1 >= trackerSettings.reclassifyInterval;
+
+        CoinDetection &candidate = candidates[candidateIndex];
+        candidate.trackId = trackIndex >= 0 ? tracks[trackIndex].detection.trackId : nextTrackId++;
+        if (trackIndex < 0 || stale) {
+            toClassify.push_back(candidateIndex);
+            continue;
+        }
+
+        const CoinDetection &tracked = tracks[trackIndex].detection;
+        candidate.templateIndex = tracked.templateIndex;
+        candidate.matchPercent = tracked.matchPercent;
+        candidate.rotationDegrees = tracked.rotationDegrees;
+        candidate.isCoin = tracked.isCoin;
+    }
+
+    workerPool.parallelFor((int) toClassify.size(), [&](int i) {
+        classify(candidates[toClassify[i]]);
+    });
+
+    classified = (int) toClassify.size();
+    reused = (int) candidates.size() - classified;
+
+    // The candidates become the tracked coins, along with the ones that were only missed for a few frames
+    std::vector<bool> wasClassified(candidates.size(), false);
+    for (int candidateIndex : toClassify) {
+        wasClassified[candidateIndex] = true;
+    }
+
+    std::vector<Track> nextTracks;
+    for (int candidateIndex = 0; candidateIndex < (int) candidates.size(); candidateIndex++) {
+        int trackIndex = trackOfCandidate[candidateIndex];
+        int framesSinceClassified = wasClassified[candidateIndex] ? 0 : tracks[trackIndex].framesSinceClassified + 1;
+        nextTracks.push_back({candidates[candidateIndex], 0, framesSinceClassified});
+    }
+    for (int trackIndex = 0; trackIndex < (int) tracks.size(); trackIndex++) {
+        if (!trackPaired[trackIndex] && tracks[trackIndex].missedFrames < trackerSettings.maxMissedFrames) {
+            Track missed = tracks[trackIndex];
+            missed.missedFrames++;
+            nextTracks.push_back(missed);
+        }
+    }
+    tracks = std::move(nextTracks);
+
+    return candidates;
+}
+
+
+/* classifiedLastFrame
+ * Precondition: None
+ * Postcondition: Returns the number of candidates classifyCandidate ran on in the last update.
+ */
+int CoinTracker::classifiedLastFrame() const {
+    return classified;
+}
+
+
+/* reusedLastFrame
+ * Precondition: None
+ * Postcondition: Returns the number of candidates in the last update that reused a tracked classification.
+ */
+int CoinTracker::reusedLastFrame() const {
+    return reused;
+}
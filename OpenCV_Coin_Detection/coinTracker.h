@@ -0,0 +1,86 @@
+//==============================================================================
+// CoinTracker
+//------------------------------------------------------------------------------
+// Follows coins from one video frame to the next so the template matcher only
+// runs on what has changed. Every frame the candidates are found as usual 
+// (Steps 1 and 2 of findCoins), and each is paired with the closest coin 
+// tracked in earlier frames whose ellipse is in nearly the same place and of 
+// nearly the same size. A paired candidate reuses that coin's classification;
+// only new or changed candidates are passed to classifyCandidate. A tracked 
+// coin that is not seen for maxMissedFrames frames is forgotten.
+//
+// Every tracked coin gets a trackId when it is first seen, and keeps it for as
+// long as it is tracked, through reclassification and missed frames alike.
+//==============================================================================
+
+#ifndef COIN_TRACKER_H
+#define COIN_TRACKER_H
+
+#include <functional>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "coinDetection.h"
+#include "detectionSettings.h"
+#include "templateBank.h"
+#include "workerPool.h"
+
+
+struct TrackerSettings {
+    double positionTolerance{0.25};     // centre may move this fraction of the coin's diameter per frame
+    double sizeTolerance{0.1};          // width and height may change by this fraction
+    int maxMissedFrames{5};             // frames a coin may go unseen before it is forgotten
+    int reclassifyInterval{0};          // classify a tracked coin again after this many frames, 0 for never
+};
+
+
+class CoinTracker {
+public:
+    explicit CoinTracker(const TrackerSettings &settings = TrackerSettings());
+
+    /*---------------------------------- update --------------------------------
+     * Precondition:  frame has been resized the same way as every earlier 
+     *                frame passed to update. templateBank has been loaded.
+     * Postcondition: Returns the candidates found in frame in contour order, 
+     *                each classified either by reusing the coin it was paired
+     *                with or by classifyCandidate on workerPool. The tracked 
+     *                coins are replaced by the returned candidates plus the 
+     *                ones missed for at most maxMissedFrames frames.
+     */
+    std::vector<CoinDetection> update(WorkerPool &workerPool, const TemplateBank &templateBank,
+                                      const DetectionSettings &settings, const cv::Mat &frame);
+
+    /*---------------------------------- track ---------------------------------
+     * Precondition:  candidates are the unclassified candidates of the next
+     *                frame. classify may be called from several workers of 
+     *                workerPool at once, each with a different candidate.
+     * Postcondition: Does what update does with candidates instead of the 
+     *                candidates of a frame, calling classify for each one 
+     *                that is new or due to be classified again. Every 
+     *                returned candidate has the trackId of its coin.
+     */
+    std::vector<CoinDetection> track(std::vector<CoinDetection> candidates, WorkerPool &workerPool,
+                                     const std::function<void(CoinDetection &)> &classify);
+
+    // Candidates in the last frame that were classified, and that reused a tracked coin's classification
+    int classifiedLastFrame() const;
+    int reusedLastFrame() const;
+
+private:
+    struct Track {
+        CoinDetection detection;        // ellipse where the coin was last seen and its classification
+        int missedFrames;               // frames since it was last seen
+        int framesSinceClassified;      // frames since classifyCandidate last ran on it
+    };
+
+    bool sameCoin(const cv::RotatedRect &tracked, const cv::RotatedRect &candidate) const;
+
+    TrackerSettings trackerSettings;
+    std::vector<Track> tracks;
+    int nextTrackId{0};
+    int classified{0};
+    int reused{0};
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "classifierTools.h"
+#include "findCoins.h"
+#include "imageDecoder.h"
+#include "imagePipeline.h"
+#include "imageUtilities.h"
+
+
+/* compareClassifiers
+ * Precondition: inputPath is an input image or a directory of them.
+ * Postcondition: Classifies every candidate of the input images with baseline and with candidate, and prints the 
+ *                throughput of both and how often they disagree.
+ */
+bool compareClassifiers(WorkerPool &workerPool, const DetectionSettings &settings, const std::string &inputPath,
+                        const CandidateClassifier &baseline, const CandidateClassifier &candidate) {
+
+    // Decode and find the candidates once, only the classification is timed
+    std::vector<cv::Mat> images;
+    std::vector<CoinDetection> candidates;
+    std::vector<int> imageOfCandidate;
+    auto addImage = [&](const std::string &path) {
+        cv::Mat image = decodeImage(path, maxSourceDimension);
+        if (image.empty()) {
+            std::cout << "Could not read " << path << std::endl;
+            return;
+        }
+        resizeSourceImage(image, image, maxSourceDimension);
+        for (const CoinDetection &found : findCandidates(image, settings)) {
+            candidates.push_back(found);
+            imageOfCandidate.push_back((int) images.size());
+        }
+        images.push_back(image);
+    };
+    if (std::filesystem::is_directory(inputPath)) {
+        for (const auto &entry : std::filesystem::directory_iterator(inputPath)) {
+            if (!entry.is_directory() && isInputImage(entry.path().string())) {
+                addImage(entry.path().string());
+            }
+        }
+    } else {
+        addImage(inputPath);
+    }
+    if (candidates.empty()) {
+        std::cout << "No candidates found to classify" << std::endl;
+        return false;
+    }
+
+    // Each classifier runs twice and the second run is timed, so both start with their scratch buffers grown
+    auto timeClassifier = [&](const CandidateClassifier &classifier, std::vector<CoinDetection> &classified) {
+        double seconds = 0.0;
+        for (int pass = 0; pass < 2; pass++) {
+            classified = candidates;
+            std::vector<CandidateClassifier::Item> items;
+            for (size_t candidateIndex = 0; candidateIndex < classified.size(); candidateIndex++) {
+                items.push_back({&images[imageOfCandidate[candidateIndex]], &classified[candidateIndex]});
+            }
+            auto start = std::chrono::steady_clock::now();
+            classifier.classify(workerPool, items);
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        return seconds;
+    };
+    std::vector<CoinDetection> baselineResults;
+    std::vector<CoinDetection> candidateResults;
+    double baselineSeconds = timeClassifier(baseline, baselineResults);
+    double candidateSeconds = timeClassifier(candidate, candidateResults);
+
+    int differentDecisions = 0;
+    for (size_t candidateIndex = 0; candidateIndex < candidates.size(); candidateIndex++) {
+        const CoinDetection &a = baselineResults[candidateIndex];
+        const CoinDetection &b = candidateResults[candidateIndex];
+        if (a.isCoin != b.isCoin || (a.isCoin && a.templateIndex != b.templateIndex)) {
+            differentDecisions++;
+        }
+    }
+
+    auto printThroughput = [&](const CandidateClassifier &classifier, double seconds) {
+        std::cout << classifier.name() << ": " << candidates.size() / std::max(seconds, 1e-9) << " candidates/s, "
+                  << seconds * 1e6 / candidates.size() << " us per candidate on " << workerPool.numThreads()
+                  << " threads" << std::endl;
+    };
+    std::cout << std::fixed << std::setprecision(1)
+              << candidates.size() << " candidates in " << images.size() << " images" << std::endl;
+    printThroughput(baseline, baselineSeconds);
+    printThroughput(candidate, candidateSeconds);
+    std::cout << "Speed up: " << baselineSeconds / std::max(candidateSeconds, 1e-9) << "x" << std::endl
+              << "Coin decisions that differ: " << differentDecisions << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    return true;
+}
@@ -0,0 +1,23 @@
+#include "opencv2/core.hpp"
+
+#include "imageUtilities.h"
+
+/* countMatchingEdges
+ * Precondition: templateEdges and patchEdges are single channel images of the same size.
+ * Postcondition: Returns the number of pixels that are edges (greater than 0) in both images, one byte at a time.
+ */
+int countMatchingEdges(const cv::Mat &templateEdges, const cv::Mat &patchEdges) {
+    int matchCount = 0;
+    for (int r = 0; r < templateEdges.rows; r++) {
+        for (int c = 0; c < templateEdges.cols; c++) {
+            //If there is an edge in the template image, check for a match in the patch
+            if (templateEdges.at<uchar>(r, c) > 0) {
+                //If corresponding pixel in the patch is also an edge, increment the count
+                if (patchEdges.at<uchar>(r, c) > 0) {
+                    matchCount++;
+                }
+            }
+        }
+    }
+    return matchCount;
+}
@@ -0,0 +1,16 @@
+#include "opencv2/imgproc.hpp"
+
+#include "imageUtilities.h"
+
+/* createEdgeImage
+ * Precondition: colorImg is a 3 channel BGR image with rows and cols greater than 0.
+ * Postcondition: edgeImg is assigned the Canny edge image of colorImg after converting it to grayscale and blurring
+ *                it three times with a 3x3 Gaussian kernel.
+ */
+void createEdgeImage(const cv::Mat &colorImg, cv::Mat &edgeImg) {
+    cv::cvtColor(colorImg, edgeImg, cv::COLOR_BGR2GRAY);
+    GaussianBlur(edgeImg, edgeImg, cv::Size(3, 3), 2.0, 2.0);
+    GaussianBlur(edgeImg, edgeImg, cv::Size(3, 3), 2.0, 2.0);
+    GaussianBlur(edgeImg, edgeImg, cv::Size(3, 3), 2.0, 2.0);
+    Canny(edgeImg, edgeImg, 20, 40);
+}
@@ -0,0 +1,150 @@
+#include <iostream>
+
+#include "detectionClient.h"
+
+#ifndef _WIN32
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "imagePipeline.h"
+#include "latencySummary.h"
+#include "socketMessage.h"
+
+
+/* readRequest
+ * Precondition: path names an image file.
+ * Postcondition: Assigns request the payload asking for the image at path, its path if sendPath is set, otherwise
+ *                its encoded bytes. Returns false if the file cannot be read.
+ */
+static bool readRequest(const std::string &path, bool sendPath, std::string &request) {
+    if (sendPath) {
+        // The server may run in another directory
+        request = pathRequest + std::filesystem::absolute(path).string();
+        return true;
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    request.assign(1, imageRequest);
+    request.append(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return request.size() <= maxMessageSize;
+}
+
+
+/* runDetectionClient
+ * Precondition: inputPath is an image or a directory of images.
+ * Postcondition: Sends every image to the server at socketPath and prints the responses and latencies. Returns 0
+ *                if every request was answered without an error.
+ */
+int runDetectionClient(const std::string &socketPath, const std::string &inputPath, const ClientSettings &settings) {
+    std::signal(SIGPIPE, SIG_IGN);      // a server going away fails the write instead of ending the client
+
+    std::vector<std::string> paths;
+    if (std::filesystem::is_directory(inputPath)) {
+        for (const auto &entry : std::filesystem::directory_iterator(inputPath)) {
+            if (!entry.is_directory() && isInputImage(entry.path().string())) {
+                paths.push_back(entry.path().string());
+            }
+        }
+    } else {
+        paths.push_back(inputPath);
+    }
+
+    // Read the requests up front so only the round trips are timed
+    std::vector<std::string> requests(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (!readRequest(paths[i], settings.sendPaths, requests[i])) {
+            std::cout << "Could not read " << paths[i] << std::endl;
+            return -1;
+        }
+    }
+
+    const size_t totalRequests = requests.size() * std::max(settings.repeat, 1u);
+    std::atomic<size_t> nextRequest{0};
+    std::atomic<bool> failed{false};
+    std::mutex outputMutex;
+    std::vector<double> latenciesMs;
+
+    // Each connection takes the next request until all have been sent
+    auto sendRequests = [&]() {
+        int socketFd = connectToServer(socketPath);
+        if (socketFd < 0) {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << "Could not connect to " << socketPath << std::endl;
+            failed = true;
+            return;
+        }
+        std::string response;
+        for (size_t index = nextRequest++; index < totalRequests && !failed; index = nextRequest++) {
+            size_t image = index % requests.size();
+            auto start = std::chrono::steady_clock::now();
+            if (!writeMessage(socketFd, requests[image]) || !readMessage(socketFd, response)) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cout << "Lost the connection sending " << paths[image] << std::endl;
+                failed = true;
+                break;
+            }
+            std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - start;
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            latenciesMs.push_back(latency.count());
+            std::cout << paths[image] << ": " << response << std::endl;
+            if (response.rfind("{\"error\"", 0) == 0) {
+                failed = true;
+            }
+        }
+        closeSocket(socketFd);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> connections;
+    for (unsigned int i = 0; i < std::max(settings.numConnections, 1u); i++) {
+        connections.emplace_back(sendRequests);
+    }
+    for (std::thread &connection : connections) {
+        connection.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    LatencySummary latency = summarizeLatencies(latenciesMs);
+    std::cout << std::fixed << std::setprecision(1)
+              << "Requests: " << latency.count << "  Requests per second: "
+              << latency.count / std::max(elapsed.count(), 1e-9) << std::endl
+              << "Round trip ms  mean: " << latency.meanMs << "  p50: " << latency.p50Ms << "  p95: " << latency.p95Ms
+              << "  p99: " << latency.p99Ms << "  max: " << latency.maxMs << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+
+    // Ask the server how long its requests took, without the socket round trip
+    int socketFd = connectToServer(socketPath);
+    std::string stats;
+    if (socketFd >= 0 && writeMessage(socketFd, std::string(1, statsRequest)) && readMessage(socketFd, stats)) {
+        std::cout << "Server: " << stats << std::endl;
+    }
+    if (socketFd >= 0) {
+        closeSocket(socketFd);
+    }
+    return failed ? -1 : 0;
+}
+
+#else
+
+/* runDetectionClient
+ * Precondition: None
+ * Postcondition: Unix domain sockets are only served on POSIX systems, so prints that and returns -1.
+ */
+int runDetectionClient(const std::string &, const std::string &, const ClientSettings &) {
+    std::cout << "The detection client needs Unix domain sockets, which are not supported here" << std::endl;
+    return -1;
+}
+
+#endif
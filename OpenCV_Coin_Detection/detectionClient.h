@@ -0,0 +1,36 @@
+//==============================================================================
+// Detection Client
+//------------------------------------------------------------------------------
+// A local test client for the detection server (see detectionServer.h). It 
+// sends every input image to a running server, either as its encoded bytes 
+// or as its path, over one or more connections at once, prints each 
+// detection record it gets back, and then prints the latency and throughput 
+// it saw along with the server's own request latency percentiles.
+//==============================================================================
+
+#ifndef DETECTION_CLIENT_H
+#define DETECTION_CLIENT_H
+
+#include <string>
+
+
+struct ClientSettings {
+    bool sendPaths{false};              // send image paths for the server to read instead of their bytes
+    unsigned int numConnections{1};     // connections sending requests at once
+    unsigned int repeat{1};             // times every image is sent
+};
+
+
+/*------------------------------ runDetectionClient ----------------------------
+ * Precondition:  inputPath is a .jpg, .jpeg or .png image or a directory of 
+ *                them.
+ * Postcondition: Sends every image settings.repeat times to the server at 
+ *                socketPath, spread over settings.numConnections connections,
+ *                and prints each response, the client side latency 
+ *                percentiles and requests per second, and the server 
+ *                statistics. Returns 0 if every request was answered without
+ *                an error, otherwise -1.
+ */
+int runDetectionClient(const std::string &socketPath, const std::string &inputPath, const ClientSettings &settings);
+
+#endif
@@ -0,0 +1,168 @@
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+#include "detectionRecord.h"
+#include "adaptiveQuality.h"
+#include "findCoins.h"
+#include "templateBank.h"
+
+
+// Coin type of each pair of templates in CoinTemplate order
+static const char *const coinTypes[numberOfTemplates / 2] = {"penny", "nickel", "dime", "quarter"};
+
+
+/* coinFace
+ * Precondition: templateIndex is a CoinTemplate.
+ * Postcondition: Returns "heads" or "tails". Heads and tails alternate in CoinTemplate order.
+ */
+static const char *coinFace(int templateIndex) {
+    return templateIndex % 2 == 0 ? "heads" : "tails";
+}
+
+
+/* jsonString
+ * Precondition: None
+ * Postcondition: Returns text as a quoted JSON string.
+ */
+std::string jsonString(const std::string &text) {
+    std::ostringstream quoted;
+    quoted << '"';
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted << '\\' << c;
+        } else if (c < 0x20) {
+            quoted << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int) c << std::dec;
+        } else {
+            quoted << c;
+        }
+    }
+    quoted << '"';
+    return quoted.str();
+}
+
+
+/* csvField
+ * Precondition: None
+ * Postcondition: Returns text quoted for CSV if it contains a comma, quote or line break.
+ */
+static std::string csvField(const std::string &text) {
+    if (text.find_first_of(",\"\r\n") == std::string::npos) {
+        return text;
+    }
+    std::string quoted = "\"";
+    for (char c : text) {
+        quoted += c;
+        if (c == '"') {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+
+/* recordFormatFor
+ * Precondition: None
+ * Postcondition: Returns csv if path has the extension ".csv", otherwise jsonLines.
+ */
+RecordFormat recordFormatFor(const std::string &path) {
+    return std::filesystem::path(path).extension() == ".csv" ? RecordFormat::csv : RecordFormat::jsonLines;
+}
+
+
+/* writeRecordHeader
+ * Precondition: out is at the start of the file.
+ * Postcondition: Writes the CSV column names if format is csv.
+ */
+void writeRecordHeader(std::ostream &out, RecordFormat format) {
+    if (format == RecordFormat::csv) {
+        out << "image,width,height,candidates,type,face,rect_x,rect_y,rect_width,rect_height,"
+               "ellipse_x,ellipse_y,ellipse_width,ellipse_height,ellipse_angle,match_percent,rotation_degrees,"
+               "total_value,quality_level" << std::endl;
+    }
+}
+
+
+/* writeDetectionRecord
+ * Precondition: detections were returned by CoinDetector::detect for an image that was resized to imageSize.
+ * Postcondition: Writes the record for imageName in format to out, with quality if it is given, and flushes it.
+ */
+void writeDetectionRecord(std::ostream &out, RecordFormat format, const std::string &imageName,
+                          const cv::Size &imageSize, const std::vector<CoinDetection> &detections,
+                          const DetectionQuality *quality) {
+
+    std::ostringstream totalValue;
+    totalValue << std::fixed << std::setprecision(2) << valueOfCoins(detections);
+
+    // Ends every CSV row, empty without a quality
+    std::string qualityColumn = quality ? "," + std::to_string(quality->level) : ",";
+
+    std::ostringstream record;
+    record << std::setprecision(6);
+
+    if (format == RecordFormat::jsonLines) {
+        record << "{\"image\":" << jsonString(imageName) << ",\"width\":" << imageSize.width
+               << ",\"height\":" << imageSize.height << ",\"candidates\":" << detections.size() << ",\"coins\":[";
+
+        bool firstCoin = true;
+        for (const CoinDetection &coin : detections) {
+            if (!coin.isCoin) {
+                continue;
+            }
+            const cv::Rect &rect = coin.boundingRect;
+            const cv::RotatedRect &ellipse = coin.ellipse;
+
+            record << (firstCoin ? "" : ",")
+                   << "{\"type\":\"" << coinTypes[coin.templateIndex / 2] << "\",\"face\":\""
+                   << coinFace(coin.templateIndex) << "\""
+                   << ",\"boundingRect\":{\"x\":" << rect.x << ",\"y\":" << rect.y << ",\"width\":" << rect.width
+                   << ",\"height\":" << rect.height << "}"
+                   << ",\"ellipse\":{\"x\":" << ellipse.center.x << ",\"y\":" << ellipse.center.y
+                   << ",\"width\":" << ellipse.size.width << ",\"height\":" << ellipse.size.height
+                   << ",\"angle\":" << ellipse.angle << "}"
+                   << ",\"matchPercent\":" << coin.matchPercent << ",\"rotationDegrees\":" << coin.rotationDegrees
+                   << "}";
+            firstCoin = false;
+        }
+        record << "],\"totalValue\":" << totalValue.str();
+
+        if (quality) {
+            record << ",\"quality\":{\"level\":" << quality->level << ",\"name\":\""
+                   << qualityLevels[quality->level].name << "\",\"detectionLevel\":" << quality->detectionLevel
+                   << ",\"classificationLevel\":" << quality->classificationLevel
+                   << ",\"workingWidth\":" << quality->workingSize.width
+                   << ",\"workingHeight\":" << quality->workingSize.height
+                   << ",\"elapsedMs\":" << quality->elapsedMs << ",\"budgetMs\":" << quality->budgetMs << "}";
+        }
+        record << "}\n";
+
+    } else {
+        std::ostringstream imageColumns;
+        imageColumns << csvField(imageName) << "," << imageSize.width << "," << imageSize.height << ","
+                     << detections.size() << ",";
+
+        bool foundCoin = false;
+        for (const CoinDetection &coin : detections) {
+            if (!coin.isCoin) {
+                continue;
+            }
+            const cv::Rect &rect = coin.boundingRect;
+            const cv::RotatedRect &ellipse = coin.ellipse;
+
+            record << imageColumns.str() << coinTypes[coin.templateIndex / 2] << "," << coinFace(coin.templateIndex)
+                   << "," << rect.x << "," << rect.y << "," << rect.width << "," << rect.height
+                   << "," << ellipse.center.x << "," << ellipse.center.y << "," << ellipse.size.width
+                   << "," << ellipse.size.height << "," << ellipse.angle
+                   << "," << coin.matchPercent << "," << coin.rotationDegrees << "," << totalValue.str()
+                   << qualityColumn << "\n";
+            foundCoin = true;
+        }
+
+        // An image without coins still gets a row, so every image read shows up in the file
+        if (!foundCoin) {
+            record << imageColumns.str() << ",,,,,,,,,,,,," << totalValue.str() << qualityColumn << "\n";
+        }
+    }
+
+    out << record.str() << std::flush;
+}
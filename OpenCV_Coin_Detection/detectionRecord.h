@@ -0,0 +1,74 @@
+//==============================================================================
+// DetectionRecord
+//------------------------------------------------------------------------------
+// Machine-readable output for the detections in one image, so runs without a 
+// display can be consumed by other programs. Each image becomes either one 
+// JSON Lines record:
+//
+//      {"image":"a.jpg","width":2500,"height":1875,"candidates":5,
+//       "coins":[{"type":"quarter","face":"heads","boundingRect":{...},
+//                 "ellipse":{...},"matchPercent":52.1,"rotationDegrees":45}],
+//       "totalValue":0.25}
+//
+// or CSV rows, one per coin, with a single row with empty coin columns for 
+// an image without coins. Coordinates are in the image after findCoins 
+// resized it to width x height. Images detected within a time budget also
+// record the quality they were detected at, as a "quality" object with the
+// level, its name, the working size and the time taken, or as the 
+// quality_level column.
+//==============================================================================
+
+#ifndef DETECTION_RECORD_H
+#define DETECTION_RECORD_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "coinDetection.h"
+
+
+enum class RecordFormat {
+    jsonLines,
+    csv
+};
+
+
+/*------------------------------- recordFormatFor ------------------------------
+ * Precondition:  None
+ * Postcondition: Returns csv if path has the extension ".csv", otherwise 
+ *                jsonLines.
+ */
+RecordFormat recordFormatFor(const std::string &path);
+
+
+/*------------------------------- writeRecordHeader ----------------------------
+ * Precondition:  out is at the start of the file.
+ * Postcondition: Writes the column names if format is csv. JSON Lines has no 
+ *                header, so nothing is written for it.
+ */
+void writeRecordHeader(std::ostream &out, RecordFormat format);
+
+
+/*------------------------------ writeDetectionRecord --------------------------
+ * Precondition:  detections were returned by CoinDetector::detect for an 
+ *                image that was resized to imageSize.
+ * Postcondition: Writes the record for imageName in format to out and flushes
+ *                it, so the records of a run that is stopped early are whole.
+ *                The quality is recorded if it is given.
+ */
+void writeDetectionRecord(std::ostream &out, RecordFormat format, const std::string &imageName,
+                          const cv::Size &imageSize, const std::vector<CoinDetection> &detections,
+                          const DetectionQuality *quality = nullptr);
+
+
+/*---------------------------------- jsonString --------------------------------
+ * Precondition:  None
+ * Postcondition: Returns text as a quoted JSON string, escaping quotes, 
+ *                backslashes and control characters.
+ */
+std::string jsonString(const std::string &text);
+
+#endif
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <atomic>
+
+#include "detectionScratch.h"
+
+
+// Growths of every thread's buffers, only touched when a buffer is reallocated
+static std::atomic<long> growthCount(0);
+
+
+/* forThisThread
+ * Precondition: None
+ * Postcondition: Returns the scratch owned by the calling thread.
+ */
+DetectionScratch &DetectionScratch::forThisThread() {
+    static thread_local DetectionScratch scratch;
+    return scratch;
+}
+
+
+/* view
+ * Precondition: rows and cols are greater than 0.
+ * Postcondition: Returns a rows x cols view of the top left corner of buffer, growing buffer only if it is too small.
+ */
+cv::Mat DetectionScratch::view(cv::Mat &buffer, int rows, int cols, int type) {
+    if (buffer.rows < rows || buffer.cols < cols || buffer.type() != type) {
+        bool sameType = !buffer.empty() && buffer.type() == type;
+        buffer.create(sameType ? std::max(rows, buffer.rows) : rows, sameType ? std::max(cols, buffer.cols) : cols,
+                      type);
+        growthCount++;
+    }
+    return buffer(cv::Rect(0, 0, cols, rows));
+}
+
+
+/* pack
+ * Precondition: edgeImage is a single channel 8-bit image.
+ * Postcondition: packed holds the bits of edgeImage, and a reallocation of its buffer is counted.
+ */
+void DetectionScratch::pack(PackedEdgeImage &packed, const cv::Mat &edgeImage) {
+    size_t capacity = packed.capacity();
+    packed.pack(edgeImage);
+    if (packed.capacity() != capacity) {
+        growthCount++;
+    }
+}
+
+
+/* buffersGrown
+ * Precondition: None
+ * Postcondition: Returns the number of buffer growths over every thread's scratch.
+ */
+long DetectionScratch::buffersGrown() {
+    return growthCount;
+}
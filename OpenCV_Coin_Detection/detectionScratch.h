@@ -0,0 +1,72 @@
+//==============================================================================
+// DetectionScratch
+//------------------------------------------------------------------------------
+// The working buffers of classifyCandidate. Every thread that classifies 
+// candidates owns one, so a worker reuses the same mask, patch and edge images
+// for every contour of every image it is given instead of allocating them per
+// contour. The buffers only grow: each is allocated at the largest size asked
+// of it so far and handed out as a view of its top left corner. Once a thread
+// has seen its largest patch, classifying a candidate with the packed, 
+// coarse or chamfer matcher grows none of these buffers; 
+// tests/testScratchReuse.cpp checks this. That is not the same as allocating
+// nothing: cv::resize, cv::Canny and cv::distanceTransform still allocate 
+// temporaries inside OpenCV, and the polar and reference matchers allocate 
+// per template.
+//==============================================================================
+
+#ifndef DETECTION_SCRATCH_H
+#define DETECTION_SCRATCH_H
+
+#include <string>
+
+#include "opencv2/core.hpp"
+
+#include "detectionSettings.h"
+#include "packedEdgeImage.h"
+#include "templateBank.h"
+#include "templateMatcher.h"
+
+
+struct DetectionScratch {
+    cv::Mat maskBuffer;         // ellipse mask of the patch
+    cv::Mat patchBuffer;        // pixels inside the ellipse
+    cv::Mat resizedBuffer;      // patch resized to the template scale
+    cv::Mat edgesBuffer;        // edge image of the resized patch, viewed by patchEdges.edges
+    cv::Mat coarseBuffer;       // edges downsampled 2x for the coarse-to-fine matcher
+    cv::Mat invertedBuffer;     // inverted edges, the input of the chamfer matcher's distance transform
+    cv::Mat chamferBuffer;      // chamfer weights, viewed by patchEdges.chamferWeights
+    PatchEdges patchEdges;
+
+    /*------------------------------- forThisThread ----------------------------
+     * Precondition:  None
+     * Postcondition: Returns the scratch owned by the calling thread, empty 
+     *                the first time the thread asks for it.
+     */
+    static DetectionScratch &forThisThread();
+
+    /*----------------------------------- view ---------------------------------
+     * Precondition:  buffer is one of this scratch's buffers, rows and cols 
+     *                are greater than 0.
+     * Postcondition: Returns a rows x cols view of the top left corner of 
+     *                buffer with the given type. buffer is only reallocated, 
+     *                and the growth counted, if it is too small or of another 
+     *                type.
+     */
+    cv::Mat view(cv::Mat &buffer, int rows, int cols, int type);
+
+    /*----------------------------------- pack ---------------------------------
+     * Precondition:  edgeImage is a single channel 8-bit image.
+     * Postcondition: packed holds the bits of edgeImage. The growth is counted
+     *                if its buffer had to be reallocated.
+     */
+    void pack(PackedEdgeImage &packed, const cv::Mat &edgeImage);
+
+    /*------------------------------- buffersGrown -----------------------------
+     * Precondition:  None
+     * Postcondition: Returns how many times a buffer of any thread's scratch 
+     *                has been allocated or reallocated.
+     */
+    static long buffersGrown();
+};
+
+#endif
@@ -0,0 +1,393 @@
+#include <iostream>
+
+#include "detectionServer.h"
+
+#ifndef _WIN32
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <iomanip>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "opencv2/imgcodecs.hpp"
+
+#include "boundedQueue.h"
+#include "detectionRecord.h"
+#include "findCoins.h"
+#include "imageDecoder.h"
+#include "imageUtilities.h"
+#include "latencySummary.h"
+#include "socketMessage.h"
+#include "stageTrace.h"
+
+
+// Number of recent request latencies the percentiles are taken over
+const size_t latencyWindow{10000};
+
+// Set by the signal handlers and by stopDetectionServer from another thread. Only a lock-free atomic may be
+// stored to from a signal handler as well.
+static std::atomic<bool> stopRequested{false};
+static_assert(std::atomic<bool>::is_always_lock_free, "stopRequested is stored to from a signal handler");
+
+
+/* requestStop
+ * Precondition: Called as a signal handler.
+ * Postcondition: The accept loop stops at its next poll.
+ */
+static void requestStop(int) {
+    stopRequested = true;
+}
+
+
+// A request waiting in the queue for a handler, and the promise its connection waits on
+struct ServerJob {
+    std::string request;
+    std::chrono::steady_clock::time_point received;
+    std::promise<std::string> response;
+};
+
+
+// Everything shared by the connection and handler threads
+struct ServerState {
+    const CoinDetector &detector;
+    BoundedQueue<std::shared_ptr<ServerJob>> queue;
+
+    std::mutex statsMutex;
+    std::vector<double> recentLatenciesMs;      // ring of the last latencyWindow requests
+    size_t nextLatency{0};
+    long requestsServed{0};
+    long requestsFailed{0};
+
+    ServerState(const CoinDetector &coinDetector, size_t maxQueued) : detector(coinDetector), queue(maxQueued) {}
+};
+
+
+/* errorResponse
+ * Precondition: None
+ * Postcondition: Returns the JSON object answering a request that failed because of problem.
+ */
+static std::string errorResponse(const std::string &problem) {
+    return "{\"error\":" + jsonString(problem) + "}";
+}
+
+
+/* answerRequest
+ * Precondition: request is a request payload other than statsRequest.
+ * Postcondition: Decodes the image given by request, detects its coins and returns their detection record, or an
+ *                error response with failed set if the request is malformed, the image cannot be read or anything
+ *                on the way throws.
+ */
+static std::string answerRequest(const CoinDetector &detector, const std::string &request, bool &failed) {
+    failed = true;
+    if (request.size() < 2 || (request[0] != imageRequest && request[0] != pathRequest)) {
+        return errorResponse("unrecognized request");
+    }
+    const bool tiled = detector.settings().tileSize > 0;
+
+    try {
+        cv::Mat image;
+        std::string imageName;
+        if (request[0] == imageRequest) {
+            cv::Mat encoded(1, (int) request.size() - 1, CV_8UC1, (void *) (request.data() + 1));
+            image = cv::imdecode(encoded, cv::IMREAD_COLOR);
+            imageName = "request";
+        } else {
+            std::string path = request.substr(1);
+            image = decodeImage(path, tiled ? 0 : maxSourceDimension);
+            imageName = std::filesystem::path(path).filename().string();
+        }
+        if (image.empty()) {
+            return errorResponse("could not decode the image");
+        }
+
+        // Report at the 2500 pixel working size, like the command line tool, unless large scans are tiled
+        if (!tiled) {
+            resizeSourceImage(image, image, maxSourceDimension);
+        }
+        DetectionQuality quality;
+        std::vector<CoinDetection> detections = detector.detect(image, quality);
+
+        std::ostringstream record;
+        writeDetectionRecord(record, RecordFormat::jsonLines, imageName, image.size(), detections,
+                             detector.settings().timeBudgetMs > 0.0 ? &quality : nullptr);
+        std::string response = record.str();
+        if (!response.empty() && response.back() == '\n') {
+            response.pop_back();
+        }
+        failed = false;
+        return response;
+
+    } catch (const std::exception &e) {
+        return errorResponse(e.what());
+    } catch (...) {
+        return errorResponse("unknown error");
+    }
+}
+
+
+/* recordRequest
+ * Precondition: None
+ * Postcondition: latencyMs replaces the oldest of the recent latencies once there are latencyWindow of them, and
+ *                the request is counted as served or failed.
+ */
+static void recordRequest(ServerState &state, double latencyMs, bool failed) {
+    std::lock_guard<std::mutex> lock(state.statsMutex);
+    if (state.recentLatenciesMs.size() < latencyWindow) {
+        state.recentLatenciesMs.push_back(latencyMs);
+    } else {
+        state.recentLatenciesMs[state.nextLatency] = latencyMs;
+    }
+    state.nextLatency = (state.nextLatency + 1) % latencyWindow;
+    state.requestsServed++;
+    if (failed) {
+        state.requestsFailed++;
+    }
+}
+
+
+/* statsResponse
+ * Precondition: None
+ * Postcondition: Returns the JSON object with the requests served and failed so far and the latency percentiles
+ *                of the recent ones.
+ */
+static std::string statsResponse(ServerState &state) {
+    long served;
+    long failed;
+    std::vector<double> latenciesMs;
+    {
+        std::lock_guard<std::mutex> lock(state.statsMutex);
+        served = state.requestsServed;
+        failed = state.requestsFailed;
+        latenciesMs = state.recentLatenciesMs;
+    }
+    LatencySummary latency = summarizeLatencies(std::move(latenciesMs));
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2)
+        << "{\"requests\":" << served << ",\"failed\":" << failed
+        << ",\"latencyMs\":{\"window\":" << latency.count << ",\"mean\":" << latency.meanMs
+        << ",\"p50\":" << latency.p50Ms << ",\"p95\":" << latency.p95Ms << ",\"p99\":" << latency.p99Ms
+        << ",\"max\":" << latency.maxMs << "}}";
+    return out.str();
+}
+
+
+/* handleRequests
+ * Precondition: None
+ * Postcondition: Answers queued requests until the queue is closed and empty, as handler handlerIndex.
+ */
+static void handleRequests(ServerState &state, unsigned int handlerIndex) {
+    TRACE_THREAD_NAME("handler " + std::to_string(handlerIndex));
+    std::shared_ptr<ServerJob> job;
+    while (state.queue.pop(job)) {
+        bool failed = false;
+        std::string response = answerRequest(state.detector, job->request, failed);
+
+        std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - job->received;
+        recordRequest(state, latency.count(), failed);
+        job->response.set_value(std::move(response));
+        job.reset();
+    }
+}
+
+
+/* serveConnection
+ * Precondition: socketFd is an accepted client connection.
+ * Postcondition: Queues each request read from socketFd and writes back its answer, answering statistics requests
+ *                directly, until the client disconnects, a message cannot be read or the queue is closed. Then 
+ *                finished is set; the socket is left open for the accept loop to close.
+ */
+static void serveConnection(ServerState &state, int socketFd, std::atomic<bool> &finished) {
+    std::string request;
+    while (readMessage(socketFd, request)) {
+        std::string response;
+        if (request.size() == 1 && request[0] == statsRequest) {
+            response = statsResponse(state);
+        } else {
+            auto job = std::make_shared<ServerJob>();
+            job->received = std::chrono::steady_clock::now();
+            job->request = std::move(request);
+            std::future<std::string> answer = job->response.get_future();
+
+            // Blocks while the queue is full, which stops this connection reading until the handlers catch up
+            if (!state.queue.push(std::move(job))) {
+                break;
+            }
+            response = answer.get();
+        }
+        if (!writeMessage(socketFd, response)) {
+            break;
+        }
+    }
+    finished = true;
+}
+
+
+/* openListener
+ * Precondition: None
+ * Postcondition: Returns a socket listening at socketPath, removing a stale socket file nobody is listening on, or
+ *                -1 after printing the problem.
+ */
+static int openListener(const std::string &socketPath, int backlog) {
+    sockaddr_un address{};
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        std::cout << "Invalid socket path: " << socketPath << std::endl;
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    int runningServer = connectToServer(socketPath);
+    if (runningServer >= 0) {
+        closeSocket(runningServer);
+        std::cout << "A server is already listening on " << socketPath << std::endl;
+        return -1;
+    }
+    unlink(socketPath.c_str());
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || bind(listenFd, (const sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(listenFd, backlog) != 0) {
+        std::cout << "Could not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (listenFd >= 0) {
+            close(listenFd);
+        }
+        return -1;
+    }
+    return listenFd;
+}
+
+
+// A client connection and the thread reading it
+struct Connection {
+    int socketFd{-1};
+    std::thread reader;
+    std::atomic<bool> finished{false};
+};
+
+
+/* runDetectionServer
+ * Precondition: detector was made with a loaded TemplateBank.
+ * Postcondition: Answers requests on settings.socketPath until SIGINT or SIGTERM, then prints the request latency
+ *                percentiles and returns 0. Returns -1 if the socket cannot be created.
+ */
+int runDetectionServer(const CoinDetector &detector, const ServerSettings &settings) {
+    // Cleared before the socket opens, so a stop requested as soon as a client can connect is never lost
+    stopRequested = false;
+    int listenFd = openListener(settings.socketPath, (int) settings.maxClients);
+    if (listenFd < 0) {
+        return -1;
+    }
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    std::signal(SIGPIPE, SIG_IGN);      // a client hanging up fails the write instead of ending the server
+
+    ServerState state(detector, std::max(settings.maxQueuedRequests, 1u));
+    std::vector<std::thread> handlers;
+    for (unsigned int i = 0; i < std::max(settings.numHandlers, 1u); i++) {
+        handlers.emplace_back(handleRequests, std::ref(state), i);
+    }
+    std::cout << "Listening on " << settings.socketPath << ", stop with Ctrl+C" << std::endl;
+
+    std::list<Connection> connections;
+    while (!stopRequested) {
+        pollfd listener{listenFd, POLLIN, 0};
+        int ready = poll(&listener, 1, 250);
+
+        // Close the connections whose clients have gone
+        for (auto connection = connections.begin(); connection != connections.end();) {
+            if (connection->finished) {
+                connection->reader.join();
+                closeSocket(connection->socketFd);
+                connection = connections.erase(connection);
+            } else {
+                ++connection;
+            }
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        int clientFd = accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0) {
+            continue;
+        }
+        if (connections.size() >= settings.maxClients) {
+            writeMessage(clientFd, errorResponse("too many clients"));
+            closeSocket(clientFd);
+            continue;
+        }
+        connections.emplace_back();
+        Connection &connection = connections.back();
+        connection.socketFd = clientFd;
+        connection.reader = std::thread(serveConnection, std::ref(state), clientFd, std::ref(connection.finished));
+    }
+
+    // Wake every connection blocked reading its client, let the handlers finish what was queued, then stop them
+    close(listenFd);
+    unlink(settings.socketPath.c_str());
+    for (Connection &connection : connections) {
+        shutdown(connection.socketFd, SHUT_RDWR);
+    }
+    for (Connection &connection : connections) {
+        connection.reader.join();
+        closeSocket(connection.socketFd);
+    }
+    state.queue.close();
+    for (std::thread &handler : handlers) {
+        handler.join();
+    }
+
+    LatencySummary latency = summarizeLatencies(state.recentLatenciesMs);
+    std::cout << std::fixed << std::setprecision(1)
+              << "Requests: " << state.requestsServed << "  failed: " << state.requestsFailed << std::endl
+              << "Latency ms (last " << latency.count << ")  mean: " << latency.meanMs << "  p50: " << latency.p50Ms
+              << "  p95: " << latency.p95Ms << "  p99: " << latency.p99Ms << "  max: " << latency.maxMs << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    return 0;
+}
+
+
+/* stopDetectionServer
+ * Precondition: None
+ * Postcondition: The accept loop stops at its next poll, as if SIGTERM had arrived.
+ */
+void stopDetectionServer() {
+    stopRequested = true;
+}
+
+#else
+
+/* runDetectionServer
+ * Precondition: None
+ * Postcondition: Unix domain sockets are only served on POSIX systems, so prints that and returns -1.
+ */
+int runDetectionServer(const CoinDetector &, const ServerSettings &) {
+    std::cout << "The detection server needs Unix domain sockets, which are not supported here" << std::endl;
+    return -1;
+}
+
+
+/* stopDetectionServer
+ * Precondition: None
+ * Postcondition: No server runs here, so does nothing.
+ */
+void stopDetectionServer() {
+}
+
+#endif
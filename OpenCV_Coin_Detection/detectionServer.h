@@ -0,0 +1,60 @@
+//==============================================================================
+// Detection Server
+//------------------------------------------------------------------------------
+// Keeps the template bank, the worker pool and a CoinDetector warm in one 
+// long-running process and detects coins for local clients over a Unix 
+// domain socket (see socketMessage.h for the protocol), so a caller pays for
+// a detection instead of for process start up and template loading.
+//
+// Each client connection is read by its own thread, which places every 
+// request it receives in one bounded queue shared by all connections and 
+// waits for the answer. A fixed number of handler threads take requests from
+// the queue and run the detector, whose candidates are classified on the 
+// worker pool. While the queue is full, connections stop reading, so a burst
+// of clients is held back instead of piling up decoded images in memory, and
+// clients beyond the connection limit are refused.
+//
+// The time from reading a request to having its answer is kept for the most
+// recent requests. Clients can ask for its percentiles, and they are printed
+// when the server stops on SIGINT or SIGTERM. Unix domain sockets are only 
+// served on POSIX systems.
+//==============================================================================
+
+#ifndef DETECTION_SERVER_H
+#define DETECTION_SERVER_H
+
+#include <string>
+
+#include "coinDetector.h"
+
+
+struct ServerSettings {
+    std::string socketPath;                 // Unix domain socket to listen on
+    unsigned int maxQueuedRequests{16};     // requests waiting for a handler before connections stop reading
+    unsigned int numHandlers{4};            // requests detected at once
+    unsigned int maxClients{64};            // connections open at once, more are refused
+};
+
+
+/*------------------------------ runDetectionServer ----------------------------
+ * Precondition:  detector was made with a loaded TemplateBank. Must not be 
+ *                called from a task of the detector's WorkerPool.
+ * Postcondition: Listens on settings.socketPath, replacing a stale socket 
+ *                file left there, and answers requests until SIGINT or 
+ *                SIGTERM. Then prints the number of requests served and their
+ *                latency percentiles, removes the socket file and returns 0.
+ *                Returns -1 if the socket cannot be created or Unix domain 
+ *                sockets are not supported.
+ */
+int runDetectionServer(const CoinDetector &detector, const ServerSettings &settings);
+
+
+/*----------------------------- stopDetectionServer ----------------------------
+ * Precondition:  None
+ * Postcondition: A running runDetectionServer stops as it does on SIGTERM, 
+ *                within a quarter of a second. Meant for a caller that runs
+ *                the server on a thread of its own, such as a test.
+ */
+void stopDetectionServer();
+
+#endif
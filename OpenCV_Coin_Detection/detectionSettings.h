@@ -0,0 +1,75 @@
+//==============================================================================
+// Detection Settings
+//------------------------------------------------------------------------------
+// Runtime switches that change how findCoins classifies a patch. The defaults
+// give the program's normal behaviour; main fills them in from the command 
+// line (see programOptions.h).
+//==============================================================================
+
+#ifndef DETECTION_SETTINGS_H
+#define DETECTION_SETTINGS_H
+
+
+// How Step 4.3 compares a patch with the templates
+enum class MatcherType {
+    packed,         // bit-packed edge images with the popcount kernel
+    reference,      // byte-per-pixel loop, kept to check the other matchers
+    polar,          // circular cross-correlation of polar edge images
+    coarseToFine,   // downsampled coarse angles, then bounded full size counts
+    batched,        // many patches at once as one matrix product, see batchedClassifier.h
+    chamfer         // template edge point lists scored on a distance transform, see chamferMatcher.h
+};
+
+
+struct DetectionSettings {
+    MatcherType matcher{MatcherType::packed};
+
+    // Also run the brute force rotation sweep on every patch and report where
+    // its result differs from the selected matcher
+    bool compareMatchers{false};
+
+    // Steps 1 and 2 find the contours on the image halved this many times by
+    // cv::pyrDown, then map the ellipses back to full resolution. 0 keeps the
+    // full resolution path with its six 5x5 Gaussian blurs.
+    int pyramidLevels{0};
+
+    // Sigma of the single Gaussian blur used instead of the six, in pixels of
+    // the pyramid level. 0 picks the sigma that smooths as much as the six 
+    // blurs did at full resolution.
+    double blurSigma{0.0};
+
+    // Also find the contours at full resolution and report ellipses that only
+    // one of the two paths found
+    bool compareDetection{false};
+
+    // If above 0, images are not downscaled to 2500 pixels but processed at 
+    // full resolution in tiles of this many pixels square, overlapping by 
+    // tileOverlap pixels (see tiledDetection.h). The overlap should be larger
+    // than the biggest coin.
+    int tileSize{0};
+    int tileOverlap{512};
+
+    // Patches scored per matrix product by MatcherType::batched
+    int batchSize{256};
+
+    // The packed, reference, coarse-to-fine and chamfer matchers only try 
+    // every angleStep-th template rotation, trading angular resolution for 
+    // speed
+    int angleStep{1};
+
+    // If above 0, the coarse-to-fine matcher only refines this many templates,
+    // those with the best coarse scores; the rest keep no match
+    int templatesRefined{0};
+
+    // Estimate the scale of each image from its candidates' sizes and only
+    // match each candidate against the coin types its size fits (see 
+    // scaleEstimator.h). Not used by tiled scans or the stream mode.
+    bool sizePrior{false};
+
+    // If above 0, CoinDetector lowers the working resolution and the matcher 
+    // effort so each image is detected in about this many milliseconds (see 
+    // adaptiveQuality.h). Not used by tiled scans.
+    double timeBudgetMs{0.0};
+};
+
+#endif
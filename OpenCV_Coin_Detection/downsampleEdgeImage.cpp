@@ -0,0 +1,23 @@
+#include "opencv2/core.hpp"
+
+#include "imageUtilities.h"
+
+/* downsampleEdgeImage
+ * Precondition: edgeImg is a single channel 8-bit image.
+ * Postcondition: coarseImg is half the size of edgeImg, each pixel set to 255 if its 2x2 block holds an edge.
+ */
+void downsampleEdgeImage(const cv::Mat &edgeImg, cv::Mat &coarseImg) {
+    coarseImg.create((edgeImg.rows + 1) / 2, (edgeImg.cols + 1) / 2, CV_8UC1);
+
+    for (int coarseRow = 0; coarseRow < coarseImg.rows; coarseRow++) {
+        const uchar *top = edgeImg.ptr<uchar>(coarseRow * 2);
+        const uchar *bottom = edgeImg.ptr<uchar>(std::min(coarseRow * 2 + 1, edgeImg.rows - 1));
+        uchar *coarse = coarseImg.ptr<uchar>(coarseRow);
+
+        for (int coarseCol = 0; coarseCol < coarseImg.cols; coarseCol++) {
+            int left = coarseCol * 2;
+            int right = std::min(left + 1, edgeImg.cols - 1);
+            coarse[coarseCol] = (top[left] | top[right] | bottom[left] | bottom[right]) ? 255 : 0;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include "opencv2/imgcodecs.hpp"
+
+#include "classifierTools.h"
+#include "featureClassifier.h"
+#include "findCoins.h"
+#include "imageDecoder.h"
+#include "imagePipeline.h"
+#include "imageUtilities.h"
+
+
+/* exportCandidateCrops
+ * Precondition: inputPath is an input image or a directory of them. templateBank has been loaded.
+ * Postcondition: The patch of every candidate is written to the directory of the label template matching gave it.
+ */
+bool exportCandidateCrops(WorkerPool &workerPool, const TemplateBank &templateBank,
+                          const DetectionSettings &settings, const std::string &inputPath,
+                          const std::string &cropDirectory) {
+    std::error_code error;
+    for (int label = 0; label < numberOfLabels; label++) {
+        std::filesystem::create_directories(cropDirectory + cropLabelName(label), error);
+        if (error) {
+            std::cout << "Could not create " << cropDirectory + cropLabelName(label) << std::endl;
+            return false;
+        }
+    }
+
+    const TemplateMatchClassifier templateMatching(templateBank, settings);
+    int labelCounts[numberOfLabels] = {};
+    bool written = true;
+
+    auto exportImage = [&](const std::string &path) {
+        cv::Mat image = decodeImage(path, maxSourceDimension);
+        if (image.empty()) {
+            std::cout << "Could not read " << path << std::endl;
+            return;
+        }
+        resizeSourceImage(image, image, maxSourceDimension);
+
+        std::vector<CoinDetection> candidates = findCandidates(image, settings);
+        std::vector<CandidateClassifier::Item> items;
+        for (CoinDetection &candidate : candidates) {
+            items.push_back({&image, &candidate});
+        }
+        templateMatching.classify(workerPool, items);
+
+        // Named after the image and contour, so a crop can be traced back to where it was found
+        std::string imageName = std::filesystem::path(path).stem().string();
+        for (const CoinDetection &candidate : candidates) {
+            int label = candidate.isCoin ? candidate.templateIndex : notCoinLabel;
+            std::string cropPath = cropDirectory + cropLabelName(label) + "/" + imageName + "_" +
+                                   std::to_string(candidate.contourIndex) + ".png";
+            if (!cv::imwrite(cropPath, extractCandidatePatch(image, candidate))) {
+                std::cout << "Could not write " << cropPath << std::endl;
+                written = false;
+                return;
+            }
+            labelCounts[label]++;
+        }
+    };
+    if (std::filesystem::is_directory(inputPath)) {
+        for (const auto &entry : std::filesystem::directory_iterator(inputPath)) {
+            if (!entry.is_directory() && isInputImage(entry.path().string()) && written) {
+                exportImage(entry.path().string());
+            }
+        }
+    } else {
+        exportImage(inputPath);
+    }
+
+    std::cout << "Exported crops to " << cropDirectory << ":";
+    for (int label = 0; label < numberOfLabels; label++) {
+        std::cout << " " << cropLabelName(label) << " " << labelCounts[label];
+    }
+    std::cout << std::endl << "Move any crop template matching got wrong into the right directory before training"
+              << std::endl;
+    return written;
+}
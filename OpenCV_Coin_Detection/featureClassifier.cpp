@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <filesystem>
+
+#include "opencv2/imgproc.hpp"
+
+#include "featureClassifier.h"
+#include "detectionScratch.h"
+#include "findCoins.h"
+#include "stageTrace.h"
+
+
+/* cropLabelName
+ * Precondition: 0 <= label < numberOfLabels
+ * Postcondition: Returns the template file name of label without its extension, or "notCoin".
+ */
+std::string cropLabelName(int label) {
+    if (label == notCoinLabel) {
+        return "notCoin";
+    }
+    return std::filesystem::path(templateFileNames[label]).stem().string();
+}
+
+
+/* computeCoinFeatures
+ * Precondition: patch is a BGR image of a candidate filling it. features has room for coinFeatureLength values.
+ * Postcondition: features holds the ring statistics and radial gradient histogram of the disc inscribed in patch.
+ */
+void computeCoinFeatures(const cv::Mat &patch, float *features) {
+    const int size = coinFeaturePatchSize;
+    DetectionScratch &scratch = DetectionScratch::forThisThread();
+
+    cv::Mat resizedPatch = scratch.view(scratch.resizedBuffer, size, size, CV_8UC3);
+    cv::resize(patch, resizedPatch, resizedPatch.size(), 0, 0, cv::INTER_AREA);
+
+    cv::Mat gray;
+    cv::Mat lab;
+    cv::Mat gradientX;
+    cv::Mat gradientY;
+    cv::cvtColor(resizedPatch, gray, cv::COLOR_BGR2GRAY);
+    cv::cvtColor(resizedPatch, lab, cv::COLOR_BGR2Lab);
+    cv::Sobel(gray, gradientX, CV_32F, 1, 0);
+    cv::Sobel(gray, gradientY, CV_32F, 0, 1);
+
+    double ringPixels[coinFeatureRings] = {};
+    double ringGray[coinFeatureRings] = {};
+    double ringGraySquared[coinFeatureRings] = {};
+    double ringA[coinFeatureRings] = {};
+    double ringB[coinFeatureRings] = {};
+    double histogram[coinFeatureRings][coinFeatureBins] = {};
+    double discGray = 0.0;
+    double discGraySquared = 0.0;
+    double discPixels = 0.0;
+
+    const double centre = (size - 1) / 2.0;
+    const double radius = size / 2.0;
+    for (int y = 0; y < size; y++) {
+        const uchar *grayRow = gray.ptr<uchar>(y);
+        const uchar *labRow = lab.ptr<uchar>(y);
+        const float *gradientXRow = gradientX.ptr<float>(y);
+        const float *gradientYRow = gradientY.ptr<float>(y);
+
+        for (int x = 0; x < size; x++) {
+            double offsetX = x - centre;
+            double offsetY = y - centre;
+            double distance = std::sqrt(offsetX * offsetX + offsetY * offsetY);
+            if (distance >= radius) {
+                continue;
+            }
+            int ring = std::min(coinFeatureRings - 1, (int) (distance / radius * coinFeatureRings));
+
+            double value = grayRow[x];
+            ringPixels[ring]++;
+            ringGray[ring] += value;
+            ringGraySquared[ring] += value * value;
+            ringA[ring] += labRow[3 * x + 1];
+            ringB[ring] += labRow[3 * x + 2];
+            discGray += value;
+            discGraySquared += value * value;
+            discPixels++;
+
+            // Gradient direction measured from the direction to the centre, so rotating the coin changes nothing
+            double magnitude = std::sqrt(gradientXRow[x] * gradientXRow[x] + gradientYRow[x] * gradientYRow[x]);
+            if (magnitude > 0.0 && distance > 0.5) {
+                double angle = std::atan2(gradientYRow[x], gradientXRow[x]) - std::atan2(offsetY, offsetX);
+                angle = std::fmod(angle + 4.0 * CV_PI, 2.0 * CV_PI);
+                int bin = std::min(coinFeatureBins - 1, (int) (angle / (2.0 * CV_PI) * coinFeatureBins));
+                histogram[ring][bin] += magnitude;
+            }
+        }
+    }
+
+    // Grey levels relative to the disc, in units of its standard deviation, cancel out brightness and contrast
+    double discMean = discGray / std::max(discPixels, 1.0);
+    double discDeviation = std::sqrt(std::max(discGraySquared / std::max(discPixels, 1.0) - discMean * discMean,
+                                              0.0)) + 1.0;
+    double histogramNorm = 0.0;
+    for (int ring = 0; ring < coinFeatureRings; ring++) {
+        for (int bin = 0; bin < coinFeatureBins; bin++) {
+            histogramNorm += histogram[ring][bin] * histogram[ring][bin];
+        }
+    }
+    histogramNorm = std::sqrt(histogramNorm) + DBL_EPSILON;
+
+    float *feature = features;
+    for (int ring = 0; ring < coinFeatureRings; ring++) {
+        double pixels = std::max(ringPixels[ring], 1.0);
+        double mean = ringGray[ring] / pixels;
+        double deviation = std::sqrt(std::max(ringGraySquared[ring] / pixels - mean * mean, 0.0));
+
+        *feature++ = (float) ((mean - discMean) / discDeviation);
+        *feature++ = (float) (deviation / discDeviation);
+        *feature++ = (float) ((ringA[ring] / pixels - 128.0) / 128.0);
+        *feature++ = (float) ((ringB[ring] / pixels - 128.0) / 128.0);
+        for (int bin = 0; bin < coinFeatureBins; bin++) {
+            *feature++ = (float) (histogram[ring][bin] / histogramNorm);
+        }
+    }
+}
+
+
+/* load
+ * Precondition: None
+ * Postcondition: Reads the network saved at path, or returns false with the reason in problem.
+ */
+bool FeatureClassifier::load(const std::string &path, std::string &problem) {
+    cv::FileStorage file(path, cv::FileStorage::READ);
+    if (!file.isOpened()) {
+        problem = "could not open " + path;
+        return false;
+    }
+    if (file["featureVersion"].empty() || (int) file["featureVersion"] != coinFeatureVersion) {
+        problem = path + " was trained on another feature version, train it again";
+        return false;
+    }
+
+    cv::Ptr<cv::ml::ANN_MLP> loadedNetwork = cv::ml::ANN_MLP::create();
+    loadedNetwork->read(file["network"]);
+    cv::Mat layerSizes = loadedNetwork->getLayerSizes();
+    if (!loadedNetwork->isTrained() || layerSizes.total() < 2 || layerSizes.at<int>(0) != coinFeatureLength ||
+        layerSizes.at<int>((int) layerSizes.total() - 1) != numberOfLabels) {
+        problem = path + " holds no trained network of the expected shape";
+        return false;
+    }
+    network = loadedNetwork;
+    return true;
+}
+
+
+/* save
+ * Precondition: trained() is true.
+ * Postcondition: Writes the feature version and the network to path. Returns false if it cannot be written.
+ */
+bool FeatureClassifier::save(const std::string &path) const {
+    cv::FileStorage file(path, cv::FileStorage::WRITE);
+    if (!file.isOpened()) {
+        return false;
+    }
+    file << "featureVersion" << coinFeatureVersion;
+    file << "network" << "{";
+    network->write(file);
+    file << "}";
+    file.release();
+    return true;
+}
+
+
+/* train
+ * Precondition: features holds one row per sample and labels the label of each row.
+ * Postcondition: A new network with one hidden layer is trained on the samples.
+ */
+void FeatureClassifier::train(const cv::Mat &features, const std::vector<int> &labels) {
+    const int hiddenUnits{32};
+
+    // One output per label, 1 for the sample's label and -1 for the others
+    cv::Mat responses(features.rows, numberOfLabels, CV_32F, cv::Scalar(-1.0));
+    for (int sample = 0; sample < features.rows; sample++) {
+        responses.at<float>(sample, labels[sample]) = 1.0f;
+    }
+
+    int layers[3] = {coinFeatureLength, hiddenUnits, numberOfLabels};
+    network = cv::ml::ANN_MLP::create();
+    network->setLayerSizes(cv::Mat(1, 3, CV_32S, layers));
+    network->setActivationFunction(cv::ml::ANN_MLP::SIGMOID_SYM, 1.0, 1.0);
+    network->setTrainMethod(cv::ml::ANN_MLP::RPROP);
+    network->setTermCriteria(cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 2000, 1e-5));
+
+    // Inputs are scaled by the network itself; the outputs stay in the -1 to 1 range of the activation
+    network->train(cv::ml::TrainData::create(features, cv::ml::ROW_SAMPLE, responses),
+                   cv::ml::ANN_MLP::NO_OUTPUT_SCALE);
+}
+
+
+/* predict
+ * Precondition: trained() is true and features holds rows of coinFeatureLength values.
+ * Postcondition: outputs holds the numberOfLabels scores of each row.
+ */
+void FeatureClassifier::predict(const cv::Mat &features, cv::Mat &outputs) const {
+    network->predict(features, outputs);
+}
+
+
+/* trained
+ * Precondition: None
+ * Postcondition: Returns true once a network has been trained or loaded.
+ */
+bool FeatureClassifier::trained() const {
+    return !network.empty() && network->isTrained();
+}
+
+
+/* classify
+ * Precondition: Each item's candidate was found in its sourceImg and has not been classified yet.
+ * Postcondition: Every candidate is classified from its features.
+ */
+void FeatureClassifier::classify(WorkerPool &workerPool, const std::vector<Item> &items) const {
+    if (items.empty()) {
+        return;
+    }
+
+    // One row of features per candidate, computed as tasks, then every row is scored by one call to the network
+    cv::Mat features((int) items.size(), coinFeatureLength, CV_32F);
+    workerPool.parallelFor((int) items.size(), [&](int row) {
+        cv::Mat patch = extractCandidatePatch(*items[row].sourceImg, *items[row].candidate);
+        TRACE_STAGE(featureTimer, TraceStage::featureExtraction);
+        computeCoinFeatures(patch, features.ptr<float>(row));
+    });
+
+    cv::Mat outputs;
+    {
+        TRACE_STAGE(predictTimer, TraceStage::featureExtraction);
+        predict(features, outputs);
+    }
+
+    for (int row = 0; row < (int) items.size(); row++) {
+        CoinDetection &candidate = *items[row].candidate;
+        const float *scores = outputs.ptr<float>(row);
+
+        // Only the coin types the size prior left can win
+        int best = -1;
+        for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+            bool plausible = candidate.plausibleTemplates & (1u << currentCoin);
+            if (plausible && (best < 0 || scores[currentCoin] > scores[best])) {
+                best = currentCoin;
+            }
+        }
+        best = std::max(best, 0);
+        candidate.templateIndex = best;
+        candidate.matchPercent = std::min(std::max((scores[best] + 1.0) * 50.0, 0.0), 100.0);
+        candidate.rotationDegrees = 0;
+        candidate.matcherEvaluations = 0;
+        candidate.isCoin = scores[best] >= scores[notCoinLabel];
+    }
+}
+
+
+std::string FeatureClassifier::name() const {
+    return "feature classifier (radial features, " + std::to_string(coinFeatureLength) + " values)";
+}
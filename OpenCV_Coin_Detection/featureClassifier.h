@@ -0,0 +1,154 @@
+//==============================================================================
+// FeatureClassifier
+//------------------------------------------------------------------------------
+// A CandidateClassifier that describes each patch with a short vector of 
+// rotation invariant features and scores it with a small neural network 
+// (cv::ml::ANN_MLP) trained on labelled patches, instead of counting edge 
+// overlaps against every template at every rotation.
+//
+// The patch is resized to coinFeaturePatchSize square and the disc inscribed
+// in it is split into coinFeatureRings rings of equal width. Per ring the
+// features are:
+//      - the mean grey level relative to the whole disc, and its spread, both
+//        divided by the disc's standard deviation so lighting cancels out
+//      - the mean a* and b* colour (CIE Lab), which separate copper pennies 
+//        from the silver coins
+//      - a histogram of gradient directions measured against the direction 
+//        to the centre, in 8 bins weighted by gradient magnitude (a radial 
+//        HOG), normalized over the whole disc
+// None of them change when the coin is rotated, so one pass replaces the 
+// search over 72 rotations. The network has one output per template plus one
+// for candidates that are not coins; the highest output wins.
+//
+// The trained network is saved in an OpenCV FileStorage file along with the
+// feature version, and loaded at start up. trainFeatureClassifier (run by the
+// ClassifierTrainer tool) builds it from rotated and relit copies of the 
+// template images plus any labelled crops, which exportCandidateCrops can 
+// write for review.
+//==============================================================================
+
+#ifndef FEATURE_CLASSIFIER_H
+#define FEATURE_CLASSIFIER_H
+
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+#include "opencv2/ml.hpp"
+
+#include "candidateClassifier.h"
+#include "detectionSettings.h"
+#include "templateBank.h"
+#include "workerPool.h"
+
+
+// Model file looked for in the template directory
+const char featureModelFileName[] = "coinClassifier.yml";
+
+// Changes whenever computeCoinFeatures does, so older models are refused
+const int coinFeatureVersion{1};
+
+const int coinFeaturePatchSize{64};
+const int coinFeatureRings{8};
+const int coinFeatureBins{8};
+const int coinFeatureLength{coinFeatureRings * (4 + coinFeatureBins)};
+
+// Labels are CoinTemplate values, plus this one for candidates that are not coins
+const int notCoinLabel{numberOfTemplates};
+const int numberOfLabels{numberOfTemplates + 1};
+
+
+
+/*-------------------------------- cropLabelName -------------------------------
+ * Precondition:  0 <= label < numberOfLabels
+ * Postcondition: Returns the directory name of the labelled crops of label:
+ *                the template file name without its extension, e.g. 
+ *                "pennyHeads", or "notCoin".
+ */
+std::string cropLabelName(int label);
+
+
+/*------------------------------ computeCoinFeatures ---------------------------
+ * Precondition:  patch is a BGR image of a coin, or candidate, filling it, 
+ *                such as extractCandidatePatch returns. features has room for
+ *                coinFeatureLength values.
+ * Postcondition: features holds the rotation invariant features of the disc 
+ *                inscribed in patch. Uses the calling thread's 
+ *                DetectionScratch.
+ */
+void computeCoinFeatures(const cv::Mat &patch, float *features);
+
+
+class FeatureClassifier : public CandidateClassifier {
+public:
+
+    /*------------------------------------ load --------------------------------
+     * Precondition:  None
+     * Postcondition: Reads the network saved at path and returns true. Returns
+     *                false with the reason in problem if the file is missing,
+     *                was made for another feature version or holds no trained
+     *                network of the expected shape.
+     */
+    bool load(const std::string &path, std::string &problem);
+
+    /*------------------------------------ save --------------------------------
+     * Precondition:  trained() is true.
+     * Postcondition: Writes the network and the feature version to path. 
+     *                Returns false if it cannot be written.
+     */
+    bool save(const std::string &path) const;
+
+    /*------------------------------------ train -------------------------------
+     * Precondition:  features holds one CV_32F row of coinFeatureLength values
+     *                per sample and labels the label of each row.
+     * Postcondition: A new network is trained on the samples.
+     */
+    void train(const cv::Mat &features, const std::vector<int> &labels);
+
+    /*----------------------------------- predict ------------------------------
+     * Precondition:  trained() is true and features holds CV_32F rows of 
+     *                coinFeatureLength values.
+     * Postcondition: Each row of outputs holds numberOfLabels scores from -1 to
+     *                1 for the matching row of features; the highest wins.
+     */
+    void predict(const cv::Mat &features, cv::Mat &outputs) const;
+
+    /*----------------------------------- trained ------------------------------
+     * Precondition:  None
+     * Postcondition: Returns true once a network has been trained or loaded.
+     */
+    bool trained() const;
+
+    /*---------------------------------- classify ------------------------------
+     * Precondition:  See CandidateClassifier::classify. trained() is true.
+     * Postcondition: The features of every patch are computed as tasks of 
+     *                workerPool, then scored together. Each candidate's 
+     *                templateIndex is the best scoring template and its 
+     *                matchPercent that template's score mapped to 0 to 100; 
+     *                isCoin is set unless notCoinLabel scored higher still. 
+     *                rotationDegrees is 0, since the features do not depend 
+     *                on the rotation.
+     */
+    void classify(WorkerPool &workerPool, const std::vector<Item> &items) const override;
+
+    std::string name() const override;
+
+private:
+    cv::Ptr<cv::ml::ANN_MLP> network;
+};
+
+
+/*---------------------------- trainFeatureClassifier --------------------------
+ * Precondition:  templateDirectory holds the 8 template images.
+ * Postcondition: Trains a FeatureClassifier on every template rotated every 
+ *                10 degrees under three lightings, plus every image in 
+ *                cropDirectory/<cropLabelName(label)>/ for each label. The 
+ *                accuracy and time per sample on a fifth of the samples held
+ *                out is printed, then the network is trained on all of them 
+ *                and saved to modelPath. Returns false if the templates 
+ *                cannot be read or the model cannot be written.
+ */
+bool trainFeatureClassifier(const std::string &templateDirectory, const std::string &cropDirectory,
+                            const std::string &modelPath);
+
+#endif
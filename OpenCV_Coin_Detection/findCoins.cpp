@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include "opencv2/imgproc.hpp"
+
+#include "findCoins.h"
+#include "detectionScratch.h"
+#include "imageUtilities.h"
+#include "packedEdgeImage.h"
+#include "chamferMatcher.h"
+#include "polarMatcher.h"
+#include "stageTrace.h"
+#include "templateMatcher.h"
+
+
+/* equivalentBlurSigma
+ * Precondition: pyramidLevels >= 0
+ * Postcondition: Returns the sigma, in pixels of the pyramid level, of one Gaussian blur that together with the 
+ *                cv::pyrDown filters smooths as much as six 5x5 sigma 2 blurs at full resolution.
+ */
+static double equivalentBlurSigma(int pyramidLevels) {
+    // A 5x5 kernel cuts the sigma 2 Gaussian off at 2 pixels, leaving a variance of about 1.66 per blur
+    const double fullResolutionVariance = 6 * 1.663;
+
+    // Each pyrDown blurs with [1 4 6 4 1] / 16 (variance 1) at its input resolution
+    double remainingVariance = fullResolutionVariance;
+    double levelArea = 1.0;
+    for (int level = 0; level < pyramidLevels; level++) {
+        remainingVariance -= levelArea;
+        levelArea *= 4.0;
+    }
+    return remainingVariance > 0.0 ? std::sqrt(remainingVariance / levelArea) : 0.0;
+}
+
+
+/* findCandidates
+ * Precondition: A valid sourceImg is provided which has rows and cols greater than 0.
+ * Postcondition: Steps 1 and 2 of findCoins. Returns every contour that fits well in an ellipse, in contour order,
+ *                with only its contourIndex, boundingRect and ellipse filled in, in sourceImg coordinates.
+ */
+std::vector<CoinDetection> findCandidates(const cv::Mat &sourceImg, const DetectionSettings &settings) {
+    std::vector<std::vector<cv::Point>> contours;
+    findEdgeContours(sourceImg, settings, contours);
+    return filterEllipticalContours(contours, settings, sourceImg.size());
+}
+
+
+/* findEdgeContours
+ * Precondition: A valid sourceImg is provided which has rows and cols greater than 0.
+ * Postcondition: Step 1 of findCoins. contours holds the outer contours of the blurred image's dilated Canny edges,
+ *                in the coordinates of the pyramid level they were found on.
+ */
+void findEdgeContours(const cv::Mat &sourceImg, const DetectionSettings &settings,
+                      std::vector<std::vector<cv::Point>> &contours) {
+
+    // Constants
+    const int cannyThreshold{25};
+    const int cannyThreshold2 = cannyThreshold * 2;
+
+    const int numOfTimeToBlur{6};
+    const int blurKernelSize{5};
+
+    /*------------------------- Step 1: BLUR_&_CANNY -------------------------*/
+
+    //1.1 - crease grayscale image from sourceImg
+    TRACE_STAGE(stepTimer, TraceStage::grayAndBlur);
+    cv::Mat sourceImgGray;
+    cvtColor(sourceImg, sourceImgGray, cv::COLOR_BGR2GRAY);
+
+    //1.2 - Blur the Image to reduce noise
+    if (settings.pyramidLevels == 0 && settings.blurSigma <= 0.0) {
+        for (int i = 0; i < numOfTimeToBlur; i++) {
+            cv::GaussianBlur(sourceImgGray, sourceImgGray, cv::Size(blurKernelSize, blurKernelSize), 2.0, 2.0);
+        }
+    } else {
+        //  Halve the image once per pyramid level, then blur once with the remaining smoothing
+        for (int level = 0; level < settings.pyramidLevels; level++) {
+            cv::pyrDown(sourceImgGray, sourceImgGray);
+        }
+        double sigma = settings.blurSigma > 0.0 ? settings.blurSigma : equivalentBlurSigma(settings.pyramidLevels);
+        if (sigma > 0.0) {
+            cv::GaussianBlur(sourceImgGray, sourceImgGray, cv::Size(0, 0), sigma, sigma);
+        }
+    }
+
+    //1.3 - Canny Edge detection
+    TRACE_NEXT_STAGE(stepTimer, TraceStage::canny);
+    cv::Mat sourceImgCanny;
+    Canny(sourceImgGray, sourceImgCanny, cannyThreshold, cannyThreshold2);
+
+    //1.4 - Dilate Canny Image
+    cv::Mat dilationKernel = getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3), cv::Point(1, 1));
+    cv::dilate(sourceImgCanny, sourceImgCanny, dilationKernel);
+
+    //1.5 - Find contours from edges
+    TRACE_NEXT_STAGE(stepTimer, TraceStage::findContours);
+    findContours(sourceImgCanny, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    TRACE_COUNT(TraceCounter::contoursFound, contours.size());
+
+    /*cv::namedWindow("Canny", cv::WINDOW_NORMAL);
+    cv::resizeWindow("Canny", cv::Size(sourceImg.cols / 2, sourceImg.rows / 2));
+    imshow("Canny", sourceImgCanny);
+    cv::waitKey();*/
+}
+
+
+/* filterEllipticalContours
+ * Precondition: contours were found by findEdgeContours with the same settings on an image of sourceSize.
+ * Postcondition: Step 2 of findCoins. Returns a candidate for every contour that fits well in an ellipse, in 
+ *                contour order, scaled to sourceSize.
+ */
+std::vector<CoinDetection> filterEllipticalContours(const std::vector<std::vector<cv::Point>> &contours,
+                                                    const DetectionSettings &settings, const cv::Size &sourceSize) {
+
+    // Constants
+    const double ellipseAreaThreshold{0.997};
+    const int minAreaOfCircle{750};
+
+    // Pixels of sourceImg per pixel of the level the contours are found on
+    const int levelScale = 1 << settings.pyramidLevels;
+
+    /*------------ Step 2: Cycle through each Detected Contour ---------------*/
+    // Keep every contour that fits well in an enclosing ellipse as a coin candidate
+    TRACE_STAGE(filterTimer, TraceStage::ellipseFilter);
+    std::vector<CoinDetection> candidates;
+    int tooSmall = 0;
+    int notElliptical = 0;
+    for (int currentContour = 0; currentContour < (int) contours.size(); currentContour++) {
+
+        // If contour has less than 5 points or area is less than threshold, skip
+        if (contours[currentContour].size() < 5 ||
+            (contourArea(contours[currentContour]) * levelScale * levelScale <= minAreaOfCircle)) {
+            tooSmall++;
+            continue;
+        }
+
+        //2.1 - Create Shapes to Enclose the Contour
+        //  Find enclosing ellipse of contour
+        cv::RotatedRect ellipse = cv::fitEllipse(contours[currentContour]);
+        double areaOfMinEnclosingEllipse = (ellipse.size.height / 2.0 * ellipse.size.width / 2.0 * CV_PI);
+        double ellipseAreaRatio = contourArea(contours[currentContour]) / areaOfMinEnclosingEllipse;
+
+        //  Skip contour if it does not fit well in an enclosing ellipse
+        if (ellipseAreaRatio < ellipseAreaThreshold || ellipseAreaRatio > (1 - ellipseAreaThreshold) + 1) {
+            notElliptical++;
+            continue;
+        }
+
+        //  Get Bounding Rectangle around Contour
+        CoinDetection candidate;
+        candidate.contourIndex = currentContour;
+        candidate.boundingRect = boundingRect(contours[currentContour]);
+        candidate.ellipse = ellipse;
+
+        //  Scale the shapes found on the pyramid level back to sourceImg, pixel centre to pixel centre
+        if (levelScale > 1) {
+            const cv::Rect &levelRect = candidate.boundingRect;
+            candidate.boundingRect = cv::Rect(levelRect.x * levelScale, levelRect.y * levelScale,
+                                              levelRect.width * levelScale, levelRect.height * levelScale) &
+                                     cv::Rect(0, 0, sourceSize.width, sourceSize.height);
+            candidate.ellipse.center = (ellipse.center + cv::Point2f(0.5f, 0.5f)) * (float) levelScale -
+                                       cv::Point2f(0.5f, 0.5f);
+            candidate.ellipse.size = cv::Size2f(ellipse.size.width * levelScale, ellipse.size.height * levelScale);
+        }
+        candidates.push_back(candidate);
+    }
+    TRACE_COUNT(TraceCounter::contoursTooSmall, tooSmall);
+    TRACE_COUNT(TraceCounter::contoursNotElliptical, notElliptical);
+    return candidates;
+}
+
+
+/* annotateCoins
+ * Precondition: detections were returned by CoinDetector::detect for the image outputImg is a copy of.
+ * Postcondition: Step 7 of findCoins. Every candidate is enclosed in a red ellipse, each coin gets a green 
+ *                bounding rectangle labelled with its name and match percentage, and the value of the collection 
+ *                is written at the top of outputImg.
+ */
+void annotateCoins(const std::vector<CoinDetection> &detections, cv::Mat &outputImg) {
+
+    /*----------------Step 7: Draw Identifying Shapes and Annotate Findings----------------*/
+    TRACE_STAGE(annotationTimer, TraceStage::annotation);
+    // Candidates are annotated in contour order, so the output does not depend on which task finished first
+    for (const CoinDetection &candidate : detections) {
+
+        // Draw red enclosing ellipse around contour on outputImg
+        cv::ellipse(outputImg, candidate.ellipse, cv::Scalar(0, 0, 255), 3, cv::LINE_AA);
+
+        if (!candidate.isCoin) {
+            continue;
+        }
+
+        std::string coinName = coinNames[candidate.templateIndex];
+
+        // Draw enclosing rectangle
+        cv::Point p1 = candidate.boundingRect.tl();
+        cv::Point p2 = candidate.boundingRect.br();
+        cv::rectangle(outputImg, p1, p2, cv::Scalar(0, 255, 0), 2, cv::LINE_AA);
+
+        // Write Annotation for Object Identification
+        cv::Point textOrigin(p1.x, p2.y + 30);
+        cv::putText(outputImg, coinName, textOrigin, cv::FONT_HERSHEY_SIMPLEX, 1.0,
+                    cv::Scalar(0, 0, 0), 4);
+        cv::putText(outputImg, coinName, textOrigin, cv::FONT_HERSHEY_SIMPLEX, 1.0,
+                    cv::Scalar(255, 255, 255), 2);
+
+        std::stringstream ss;
+        ss << candidate.matchPercent << "% Match";
+        std::string percentMatch = ss.str();
+
+        cv::Point matchTextOrigin(p1.x, p2.y + 60);
+        cv::putText(outputImg, percentMatch, matchTextOrigin, cv::FONT_HERSHEY_SIMPLEX, 1.0,
+                    cv::Scalar(0, 0, 0), 4);
+
+        cv::putText(outputImg, percentMatch, matchTextOrigin, cv::FONT_HERSHEY_SIMPLEX, 1.0,
+                    cv::Scalar(255, 255, 255), 2);
+    }
+
+    // Determine value of the collection
+    double valueOfCollection = valueOfCoins(detections);
+
+    std::stringstream ss;
+    ss << "Total Value of Collection: $" << std::setprecision(2) << std::fixed << valueOfCollection;
+    std::string collectionValue = ss.str();
+
+    cv::Point textOrigin(30, 60);
+    cv::putText(outputImg, collectionValue, textOrigin, cv::FONT_HERSHEY_SIMPLEX, 2.0,
+                cv::Scalar(0, 0, 0), 6);
+    cv::putText(outputImg, collectionValue, textOrigin, cv::FONT_HERSHEY_SIMPLEX, 2.0,
+                cv::Scalar(100, 255, 0), 2);
+
+    return;
+}
+
+
+/* valueOfCoins
+ * Precondition: None
+ * Postcondition: Returns the total value in dollars of the detections that are coins.
+ */
+double valueOfCoins(const std::vector<CoinDetection> &detections) {
+    int coinTypeCount[numberOfTemplates] = {0};
+    for (const CoinDetection &candidate : detections) {
+        if (candidate.isCoin) {
+            coinTypeCount[candidate.templateIndex]++;
+        }
+    }
+
+    double valueOfCollection = 0.0;
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        valueOfCollection += (coinTypeCount[currentCoin] * coinValues[currentCoin]);
+    }
+    return valueOfCollection;
+}
+
+
+
+/* extractCandidatePatch
+ * Precondition: candidate was found in sourceImg by Step 2 of findCoins.
+ * Postcondition: Step 3 of findCoins. Returns a view of the calling thread's scratch holding the pixels of sourceImg
+ *                inside the candidate's ellipse, on black, in the coordinates of its bounding rectangle.
+ */
+cv::Mat extractCandidatePatch(const cv::Mat &sourceImg, const CoinDetection &candidate) {
+    const cv::Rect &boundingRectVals = candidate.boundingRect;
+    const cv::RotatedRect &ellipse = candidate.ellipse;
+    DetectionScratch &scratch = DetectionScratch::forThisThread();
+    TRACE_STAGE(extractionTimer, TraceStage::patchExtraction);
+
+    // mask of the pixels inside the ellipse, in the coordinates of the Bounding Rectangle around Contour
+    cv::Mat ellipseMask = scratch.view(scratch.maskBuffer, boundingRectVals.height, boundingRectVals.width, CV_8UC1);
+    ellipseMask.setTo(cv::Scalar(0));
+    cv::RotatedRect patchEllipse(ellipse.center - cv::Point2f((float) boundingRectVals.x, (float) boundingRectVals.y),
+                                 ellipse.size, ellipse.angle);
+    cv::ellipse(ellipseMask, patchEllipse, cv::Scalar(255), cv::FILLED, cv::LINE_8);
+
+    // Extract object found by the contour from a view of sourceImg, leaving the background black
+    cv::Mat patch = scratch.view(scratch.patchBuffer, boundingRectVals.height, boundingRectVals.width, CV_8UC3);
+    patch.setTo(cv::Scalar(0, 0, 0));
+    sourceImg(boundingRectVals).copyTo(patch, ellipseMask);
+    return patch;
+}
+
+
+/* preparePatchEdges
+ * Precondition: patch was extracted for candidate by extractCandidatePatch.
+ * Postcondition: Step 4.1 of findCoins. The calling thread's scratch.patchEdges holds the edges of patch resized to
+ *                the template scale nearest its mean diameter, which is returned, in every form matcher compares.
+ */
+const TemplateBank::Scale &preparePatchEdges(const TemplateBank &templateBank, MatcherType matcher,
+                                             const cv::Mat &patch, const CoinDetection &candidate) {
+    const cv::Rect &boundingRectVals = candidate.boundingRect;
+    const cv::RotatedRect &ellipse = candidate.ellipse;
+    DetectionScratch &scratch = DetectionScratch::forThisThread();
+    TRACE_STAGE(preparationTimer, TraceStage::templatePreparation);
+
+    // The patch is stretched to a square like the templates were, which undoes a tilted coin's foreshortening the
+    // way resizing each template to the patch did. The scale is the one nearest the geometric mean of its sides,
+    // the diameter of a circle of the same area: the longer side upsamples the short one and loses tilted coins.
+    int meanDiameter = (int) std::lround(std::sqrt((double) patch.cols * patch.rows));
+    const TemplateBank::Scale &templateScale = templateBank.nearestScale(meanDiameter);
+    cv::Mat resizedPatch = scratch.view(scratch.resizedBuffer, templateScale.size, templateScale.size, CV_8UC3);
+    cv::resize(patch, resizedPatch, resizedPatch.size(), 0, 0, cv::INTER_AREA);
+
+    PatchEdges &patchEdges = scratch.patchEdges;
+    patchEdges.edges = scratch.view(scratch.edgesBuffer, templateScale.size, templateScale.size, CV_8UC1);
+    createEdgeImage(resizedPatch, patchEdges.edges);
+    scratch.pack(patchEdges.packed, patchEdges.edges);
+
+    // Downsampled edges for the coarse pass of the coarse-to-fine matcher
+    if (matcher == MatcherType::coarseToFine) {
+        cv::Mat coarseEdges = scratch.view(scratch.coarseBuffer, (templateScale.size + 1) / 2,
+                                           (templateScale.size + 1) / 2, CV_8UC1);
+        downsampleEdgeImage(patchEdges.edges, coarseEdges);
+        scratch.pack(patchEdges.coarse, coarseEdges);
+    }
+
+    // Weights from the distance transform of the edges for the chamfer matcher, every row chamferStride bytes
+    if (matcher == MatcherType::chamfer && templateScale.size <= chamferStride) {
+        cv::Mat inverted = scratch.view(scratch.invertedBuffer, templateScale.size, templateScale.size, CV_8UC1);
+        patchEdges.chamferWeights = scratch.view(scratch.chamferBuffer, templateScale.size, chamferStride, CV_8UC1);
+        createChamferWeights(patchEdges.edges, inverted, patchEdges.chamferWeights);
+    }
+
+    // Coin centre inside the resized patch, used by the polar matcher
+    if (matcher == MatcherType::polar) {
+        cv::Point2f patchCentre((ellipse.center.x - boundingRectVals.x) * templateScale.size / patch.cols,
+                                (ellipse.center.y - boundingRectVals.y) * templateScale.size / patch.rows);
+        createPolarSpectrum(patchEdges.edges, patchCentre, false, patchEdges.polarSpectrum);
+    }
+    return templateScale;
+}
+
+
+/*------------------------------ classifyCandidate -----------------------------
+ * Precondition:  candidate was found in sourceImg by Step 2 of findCoins, so 
+ *                its boundingRect lies inside sourceImg. templateBank has been 
+ *                loaded.
+ * Postcondition: Steps 3 to 6 of findCoins: the patch enclosed by the 
+ *                candidate's ellipse is compared to every template and the 
+ *                candidate's templateIndex, matchPercent, rotationDegrees and 
+ *                isCoin are filled in. Only candidate and the calling 
+ *                thread's DetectionScratch are modified, so candidates can be
+ *                classified on different threads.
+ */
+void classifyCandidate(const TemplateBank &templateBank, const DetectionSettings &settings, const cv::Mat &sourceImg,
+                       CoinDetection &candidate) {
+
+    // Every buffer below is a view of this thread's scratch, reused from the contours it classified before
+    DetectionScratch &scratch = DetectionScratch::forThisThread();
+
+    /*-------------------------Step 3: Get Patch Around the Contour------------------------*/
+    cv::Mat patch = extractCandidatePatch(sourceImg, candidate);
+
+    /*cv::namedWindow("Patch", cv::WINDOW_NORMAL);
+    cv::resizeWindow("Patch", patch.cols * 2, patch.rows * 2);
+    imshow("Patch", patch);
+    cv::imwrite("patch.jpg", patch);
+    cv::waitKey();*/
+
+
+    /*---------------------------Step 4: Compare to Template Coins-------------------------*/
+    // 4.1 - Resize patch to the nearest precomputed template size and create its edge image
+    const TemplateBank::Scale &templateScale = preparePatchEdges(templateBank, settings.matcher, patch, candidate);
+    PatchEdges &patchEdges = scratch.patchEdges;
+
+    /*cv::namedWindow("patchedges", cv::WINDOW_NORMAL);
+    cv::resizeWindow("patchedges", patchEdges.edges.rows * 2, patchEdges.edges.cols * 2);
+    imshow("patchedges", patchEdges.edges);
+    cv::imwrite("patchEdges.jpg", patchEdges.edges);
+    cv::waitKey();*/
+
+    // 4.3 - Compare each template to the current patch with the selected matcher
+    TRACE_STAGE(matchTimer, TraceStage::rotationSweep);
+    TemplateMatch templateMatches[numberOfTemplates];
+    candidate.matcherEvaluations = matchTemplates(templateBank, templateScale, settings.matcher, patchEdges,
+                                                  templateMatches, settings.angleStep, settings.templatesRefined,
+                                                  candidate.plausibleTemplates);
+    TRACE_COUNT(TraceCounter::templateAngleEvaluations, candidate.matcherEvaluations);
+
+    // 4.4 - If requested, check the selected matcher against the brute force rotation sweep
+    if (settings.compareMatchers) {
+        MatcherType bruteForce = settings.matcher == MatcherType::packed ? MatcherType::reference
+                                                                          : MatcherType::packed;
+        TemplateMatch bruteForceMatches[numberOfTemplates];
+        matchTemplates(templateBank, templateScale, bruteForce, patchEdges, bruteForceMatches, 1, 0,
+                       candidate.plausibleTemplates);
+
+        // The polar matcher rounds its angle, and the chamfer matcher's near misses can pull its best score a
+        // rotation off the exact one. Neither percentage is compared, only the angles and the decisions.
+        int angleTolerance = settings.matcher == MatcherType::polar || settings.matcher == MatcherType::chamfer
+                             ? templateBank.degreeIncrement() : 0;
+        candidate.matcherReport = describeMatcherDifferences(templateMatches, bruteForceMatches, angleTolerance,
+                                                             coinThreshold(settings.matcher, templateScale));
+    }
+
+    /*----------------Steps 5 and 6: Pick the best template and decide if it is a coin-----------------*/
+    chooseBestTemplate(templateMatches, candidate, coinThreshold(settings.matcher, templateScale));
+}
@@ -0,0 +1,133 @@
+//==============================================================================
+// findCoins
+//------------------------------------------------------------------------------
+// The coin detection steps run on each input image:
+//      1. Blur the image and find the contours of its edges.
+//      2. Keep the contours that fit well in an ellipse.
+//      3. Extract the patch enclosed by each ellipse.
+//      4. Compare the patch's edges to every template at every rotation.
+//      5. Pick the template that matched best.
+//      6. Decide if the patch is a coin, and which coin.
+//      7. Annotate the output image and total the value of the coins.
+//
+// CoinDetector (coinDetector.h) runs Steps 1 to 6 and annotateCoins runs 
+// Step 7, so callers that only need the detections can skip drawing the 
+// output image. annotationOverlay.h records Step 7 as an SVG or JSON overlay
+// instead and draws it later, at preview size if asked.
+// findCandidates and classifyCandidate split Steps 1 to 6 for callers, such 
+// as the stream mode, that only classify some of the candidates. The single 
+// steps they are made of (findEdgeContours, filterEllipticalContours,
+// extractCandidatePatch and preparePatchEdges) are exposed for the benchmarks.
+//==============================================================================
+
+#ifndef FIND_COINS_H
+#define FIND_COINS_H
+
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "coinDetection.h"
+#include "detectionSettings.h"
+#include "templateBank.h"
+#include "workerPool.h"
+
+
+// Images larger than this many pixels on a side are downscaled before detection, unless they are tiled
+const int maxSourceDimension{2500};
+
+
+/*-------------------------------- findCandidates ------------------------------
+ * Precondition:  A valid sourceImg is provided which has rows and cols greater 
+ *                than 0, already resized by CoinDetector or the caller.
+ * Postcondition: Steps 1 and 2 of findCoins. Every contour that fits well in 
+ *                an ellipse is returned in contour order with its 
+ *                contourIndex, boundingRect and ellipse filled in, ready to 
+ *                be passed to classifyCandidate. If settings.pyramidLevels is
+ *                above 0 the contours are found on a cv::pyrDown level of 
+ *                sourceImg and their ellipse and boundingRect are scaled back
+ *                to the coordinates of sourceImg.
+ */
+std::vector<CoinDetection> findCandidates(const cv::Mat &sourceImg, const DetectionSettings &settings);
+
+
+/*------------------------------ findEdgeContours ------------------------------
+ * Precondition:  A valid sourceImg is provided which has rows and cols greater 
+ *                than 0.
+ * Postcondition: Step 1 of findCoins, the first half of findCandidates. 
+ *                contours holds the outer contours of the dilated Canny edges
+ *                of sourceImg, blurred (and reduced settings.pyramidLevels 
+ *                times), in the coordinates of that pyramid level.
+ */
+void findEdgeContours(const cv::Mat &sourceImg, const DetectionSettings &settings,
+                      std::vector<std::vector<cv::Point>> &contours);
+
+
+/*-------------------------- filterEllipticalContours --------------------------
+ * Precondition:  contours were found by findEdgeContours, with the same 
+ *                settings, on an image of sourceSize.
+ * Postcondition: Step 2 of findCoins, the second half of findCandidates. 
+ *                Returns the candidates findCandidates would, for every 
+ *                contour large enough and fitting well in an ellipse.
+ */
+std::vector<CoinDetection> filterEllipticalContours(const std::vector<std::vector<cv::Point>> &contours,
+                                                    const DetectionSettings &settings, const cv::Size &sourceSize);
+
+
+/*-------------------------------- annotateCoins -------------------------------
+ * Precondition:  detections were returned by CoinDetector::detect, and 
+ *                outputImg is a copy of the image they were found in.
+ * Postcondition: Step 7 of findCoins. Every detection is enclosed in a red 
+ *                ellipse, each coin is given a green bounding rectangle, its 
+ *                name and match percentage, and the value of the collection 
+ *                is written at the top of outputImg.
+ */
+void annotateCoins(const std::vector<CoinDetection> &detections, cv::Mat &outputImg);
+
+
+/*--------------------------------- valueOfCoins -------------------------------
+ * Precondition:  None
+ * Postcondition: Returns the total value in dollars of the detections that 
+ *                have isCoin set.
+ */
+double valueOfCoins(const std::vector<CoinDetection> &detections);
+
+
+/*------------------------------ classifyCandidate -----------------------------
+ * Precondition:  candidate was found in sourceImg by Step 2 of findCoins, so 
+ *                its boundingRect lies inside sourceImg. templateBank has been 
+ *                loaded.
+ * Postcondition: Steps 3 to 6 of findCoins: the patch enclosed by the 
+ *                candidate's ellipse is compared to every template and the 
+ *                candidate's templateIndex, matchPercent, rotationDegrees and 
+ *                isCoin are filled in. Only candidate and the calling 
+ *                thread's DetectionScratch are modified, so candidates can be
+ *                classified on different threads.
+ */
+void classifyCandidate(const TemplateBank &templateBank, const DetectionSettings &settings, const cv::Mat &sourceImg,
+                       CoinDetection &candidate);
+
+
+/*---------------------------- extractCandidatePatch ---------------------------
+ * Precondition:  candidate was found in sourceImg by Step 2 of findCoins.
+ * Postcondition: Step 3 of findCoins. Returns the pixels of sourceImg inside 
+ *                the candidate's ellipse on a black background, the size of 
+ *                its boundingRect. The result is a view of the calling 
+ *                thread's DetectionScratch, overwritten by the next call.
+ */
+cv::Mat extractCandidatePatch(const cv::Mat &sourceImg, const CoinDetection &candidate);
+
+
+/*------------------------------ preparePatchEdges -----------------------------
+ * Precondition:  patch was returned by extractCandidatePatch for candidate. 
+ *                templateBank has been loaded.
+ * Postcondition: Step 4.1 of findCoins. The patch is resized to the nearest 
+ *                template scale, which is returned, and its edge image is 
+ *                left in the calling thread's DetectionScratch::patchEdges,
+ *                packed, and downsampled, as a polar spectrum or as chamfer
+ *                weights if matcher needs it, ready for matchTemplates.
+ */
+const TemplateBank::Scale &preparePatchEdges(const TemplateBank &templateBank, MatcherType matcher,
+                                             const cv::Mat &patch, const CoinDetection &candidate);
+
+#endif
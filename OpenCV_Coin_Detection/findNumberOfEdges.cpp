@@ -1,10 +1,13 @@
 #include "opencv2/imgcodecs.hpp"
 
+#include "imageUtilities.h"
+#include "packedEdgeImage.h"
+
 /* findNumberOfEdges
  * Precondition: edgeImage must be a single channel, binary image with edges a value of 255 and non-edges as 0.
  * Postcondition: The number of edge pixels are counted and the sum is returned as an int.
  */
-int findNumberOfEdges(cv::Mat &edgeImage) {
+int findNumberOfEdges(const cv::Mat &edgeImage) {
     int numEdges = 0;
     for (int r = 0; r < edgeImage.rows; r++) {
         for (int c = 0; c < edgeImage.cols; c++) {
@@ -15,4 +18,13 @@ int findNumberOfEdges(cv::Mat &edgeImage) {
         }
     }
     return numEdges;
+}
+
+
+/* findNumberOfEdges
+ * Precondition: None
+ * Postcondition: The number of set bits in the packed edgeImage is returned as an int.
+ */
+int findNumberOfEdges(const PackedEdgeImage &edgeImage) {
+    return countMatchingEdges(edgeImage, edgeImage);
 }
\ No newline at end of file
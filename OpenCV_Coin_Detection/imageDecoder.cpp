@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <fstream>
+
+#include "opencv2/imgcodecs.hpp"
+
+#include "imageDecoder.h"
+
+
+/* readJpegSize
+ * Precondition: file is positioned just after the JPEG start of image marker.
+ * Postcondition: Walks the marker segments up to the first start of frame and assigns size its width and height.
+ *                Returns false if no start of frame is found.
+ */
+static bool readJpegSize(std::ifstream &file, cv::Size &size) {
+    unsigned char segment[7];
+    while (file.read((char *) segment, 4)) {
+        if (segment[0] != 0xFF) {
+            return false;
+        }
+        // Fill bytes may pad a marker
+        while (segment[1] == 0xFF) {
+            segment[1] = segment[2];
+            segment[2] = segment[3];
+            if (!file.read((char *) &segment[3], 1)) {
+                return false;
+            }
+        }
+
+        int marker = segment[1];
+        int length = (segment[2] << 8) | segment[3];
+
+        // SOF0 to SOF15 hold the frame size, except DHT (C4), JPG (C8) and DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (!file.read((char *) segment, 5)) {
+                return false;
+            }
+            size.height = (segment[1] << 8) | segment[2];
+            size.width = (segment[3] << 8) | segment[4];
+            return size.width > 0 && size.height > 0;
+        }
+        if (length < 2 || !file.seekg(length - 2, std::ios::cur)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+
+/* readHeaderSize
+ * Precondition: None
+ * Postcondition: Assigns size the dimensions in the JPEG or PNG header of path and isJpeg whether it is a JPEG. 
+ *                Returns false if there are none.
+ */
+static bool readHeaderSize(const std::string &path, cv::Size &size, bool &isJpeg) {
+    std::ifstream file(path, std::ios::binary);
+    unsigned char signature[8];
+    if (!file.read((char *) signature, 2)) {
+        return false;
+    }
+
+    isJpeg = signature[0] == 0xFF && signature[1] == 0xD8;
+    if (isJpeg) {
+        return readJpegSize(file, size);
+    }
+
+    // PNG: 8 byte signature, then the IHDR chunk whose data starts with the width and height
+    static const unsigned char pngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    unsigned char header[16];
+    if (signature[0] == pngSignature[0] && signature[1] == pngSignature[1] && file.read((char *) &signature[2], 6) &&
+        std::equal(signature, signature + 8, pngSignature) && file.read((char *) header, 16)) {
+        size.width = (header[8] << 24) | (header[9] << 16) | (header[10] << 8) | header[11];
+        size.height = (header[12] << 24) | (header[13] << 16) | (header[14] << 8) | header[15];
+        return size.width > 0 && size.height > 0;
+    }
+    return false;
+}
+
+
+/* readImageSize
+ * Precondition: None
+ * Postcondition: Assigns size the dimensions in the JPEG or PNG header of path. Returns false if there are none.
+ */
+bool readImageSize(const std::string &path, cv::Size &size) {
+    bool isJpeg;
+    return readHeaderSize(path, size, isJpeg);
+}
+
+
+/* decodeImage
+ * Precondition: None
+ * Postcondition: Returns the BGR image at path, decoded at a reduced JPEG scale if that still meets maxDimension.
+ */
+cv::Mat decodeImage(const std::string &path, int maxDimension) {
+    int readMode = cv::IMREAD_COLOR;
+
+    cv::Size size;
+    bool isJpeg = false;
+    if (maxDimension > 0 && readHeaderSize(path, size, isJpeg)) {
+
+        // libjpeg rounds each side up when it scales, so a side of n becomes ceil(n / factor)
+        const int largerSide = std::max(size.width, size.height);
+        const int reducedModes[] = {cv::IMREAD_REDUCED_COLOR_8, cv::IMREAD_REDUCED_COLOR_4, cv::IMREAD_REDUCED_COLOR_2};
+        const int factors[] = {8, 4, 2};
+        for (int i = 0; isJpeg && i < 3; i++) {
+            if ((largerSide + factors[i] - 1) / factors[i] >= maxDimension) {
+                readMode = reducedModes[i];
+                break;
+            }
+        }
+    }
+    return cv::imread(path, readMode);
+}
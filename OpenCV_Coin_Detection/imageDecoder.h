@@ -0,0 +1,39 @@
+//==============================================================================
+// Image Decoder
+//------------------------------------------------------------------------------
+// Reads input images at no more resolution than findCoins will use. Before 
+// decoding, the width and height are read from the JPEG or PNG header. A JPEG
+// larger than the working resolution is then decoded directly at the 
+// smallest DCT-reduced scale (1/2, 1/4 or 1/8, see cv::IMREAD_REDUCED_COLOR_*)
+// that is still at least that large, which skips most of the decode work and 
+// memory for phone photos. Anything else is decoded in full.
+//==============================================================================
+
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <string>
+
+#include "opencv2/core.hpp"
+
+
+/*------------------------------- readImageSize --------------------------------
+ * Precondition:  None
+ * Postcondition: Assigns size the width and height stored in the header of 
+ *                the JPEG or PNG file at path and returns true. Returns false 
+ *                if the file cannot be read or has no header recognized.
+ */
+bool readImageSize(const std::string &path, cv::Size &size);
+
+
+/*------------------------------- decodeImage ----------------------------------
+ * Precondition:  None
+ * Postcondition: Returns the 3 channel BGR image at path, or an empty Mat if 
+ *                it cannot be read. If maxDimension is above 0 and path is a 
+ *                JPEG whose larger side is at least twice maxDimension, it is 
+ *                decoded at the smallest reduced scale whose larger side is 
+ *                still at least maxDimension.
+ */
+cv::Mat decodeImage(const std::string &path, int maxDimension);
+
+#endif
@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cctype>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opencv2/imgcodecs.hpp"
+
+#include "imagePipeline.h"
+#include "boundedQueue.h"
+#include "findCoins.h"
+#include "imageDecoder.h"
+#include "imageUtilities.h"
+#include "stageTrace.h"
+
+
+/* InFlightLimit
+ * Counts the images that have entered the pipeline but not yet left it. The walker acquires a slot before it
+ * starts an image and the last stage releases it, which bounds memory use by maxImagesInFlight images.
+ */
+class InFlightLimit {
+public:
+    explicit InFlightLimit(unsigned int maxInFlight) : available(maxInFlight) {}
+
+    void acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        slotFreed.wait(lock, [this] { return available > 0; });
+        available--;
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        available++;
+        slotFreed.notify_one();
+    }
+
+private:
+    unsigned int available;
+    std::mutex mutex;
+    std::condition_variable slotFreed;
+};
+
+
+/* isInputImage
+ * Precondition: None
+ * Postcondition: Returns true if path has the extension ".jpg", ".jpeg" or ".png" in any case.
+ */
+bool isInputImage(const std::string &path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return (char) std::tolower(c); });
+    return extension == ".jpg" || extension == ".jpeg" || extension == ".png";
+}
+
+
+/* outputFileName
+ * Precondition: imgName has an extension.
+ * Postcondition: Returns imgName with "_output" inserted before its extension.
+ */
+std::string outputFileName(const std::string &imgName) {
+    std::filesystem::path imgPath(imgName);
+    return imgPath.stem().string() + "_output" + imgPath.extension().string();
+}
+
+
+/* writeOutputs
+ * Precondition: image has been detected and annotated as settings asks.
+ * Postcondition: Writes the annotated image, overlay, preview and coin thumbnails settings asks for, and prints
+ *                which of them could not be written with the name of image.
+ */
+static void writeOutputs(const PipelineImage &image, const PipelineSettings &settings) {
+    auto reportFailure = [&](const std::string &what) {
+        std::cout << "Could not write " << what << " of " << image.name << std::endl;
+    };
+
+    if (settings.writeImages) {
+        TRACE_STAGE(encodeTimer, TraceStage::encode);
+        std::string outputPath = settings.outputDirectory + outputFileName(image.name);
+        if (!cv::imwrite(outputPath, image.output)) {
+            reportFailure("the annotated image " + outputPath);
+        }
+    }
+    // writeOverlay reports its own failures, the overlay is named after the image
+    if (settings.overlayFormat != OverlayFormat::none) {
+        writeOverlay(image.path, settings.overlayFormat, image.detectedSize, image.detections);
+    }
+    if (settings.previewSize > 0 || settings.thumbnailSize > 0) {
+        TRACE_STAGE(encodeTimer, TraceStage::encode);
+        if (settings.previewSize > 0) {
+            std::string previewPath = settings.outputDirectory + previewFileName(image.name);
+            if (!cv::imwrite(previewPath, renderAnnotated(image.source, image.detectedSize, image.detections,
+                                                          settings.previewSize))) {
+                reportFailure("the preview " + previewPath);
+            }
+        }
+        if (settings.thumbnailSize > 0) {
+            long coins = std::count_if(image.detections.begin(), image.detections.end(),
+                                       [](const CoinDetection &candidate) { return candidate.isCoin; });
+            int written = writeCoinThumbnails(image.source, image.detectedSize, image.detections,
+                                              settings.outputDirectory, image.name, settings.thumbnailSize);
+            if (written < coins) {
+                reportFailure(std::to_string(coins - written) + " of the " + std::to_string(coins) +
+                              " coin thumbnails");
+            }
+        }
+    }
+}
+
+
+/* runPipeline
+ * Precondition: inputPath is an input image or a directory, detector classifies on workerPool. Must not be called
+ *               from a task of workerPool.
+ * Postcondition: Every input image has been detected, and written if settings.writeImages is set. Returns the
+ *                number of images processed.
+ */
+int runPipeline(const std::string &inputPath, WorkerPool &workerPool, const CoinDetector &detector,
+                const PipelineSettings &settings, const std::function<void(PipelineImage &)> &onFinished) {
+
+    const unsigned int maxInFlight = std::max(1u, settings.maxImagesInFlight);
+    InFlightLimit inFlight(maxInFlight);
+
+    // No queue can hold more than the images in flight, so pushes only wait on a full queue when a later 
+    // stage is the bottleneck
+    BoundedQueue<std::string> pathQueue(maxInFlight);
+    BoundedQueue<PipelineImage> encodeQueue(maxInFlight);
+    BoundedQueue<PipelineImage> finishedQueue(maxInFlight);
+
+    std::atomic<int> imagesProcessed(0);
+    const DetectionSettings &detection = detector.settings();
+
+    /*---------------------- Stage 1: Walk the input path ----------------------*/
+    std::thread walker([&] {
+        auto startImage = [&](const std::string &path) {
+            inFlight.acquire();
+            pathQueue.push(path);
+        };
+
+        if (std::filesystem::is_directory(inputPath)) {
+            for (const auto &entry : std::filesystem::directory_iterator(inputPath)) {
+                if (!entry.is_directory() && isInputImage(entry.path().string())) {
+                    startImage(entry.path().string());
+                }
+            }
+        } else {
+            startImage(inputPath);
+        }
+        pathQueue.close();
+    });
+
+    /*------------- Stage 2 and 3: Decode, then detect on the pool -------------*/
+    WorkerPool::TaskGroup detectTasks;
+    std::vector<std::thread> decoders;
+    // Decoding is the heaviest stage before detection, so by default every core may decode
+    unsigned int numDecoders = settings.numDecoders > 0 ? settings.numDecoders
+                                                        : std::max(1u, std::thread::hardware_concurrency());
+    numDecoders = std::min(numDecoders, maxInFlight);
+    for (unsigned int i = 0; i < numDecoders; i++) {
+        decoders.emplace_back([&, i] {
+            TRACE_THREAD_NAME("decoder " + std::to_string(i));
+            std::string path;
+            while (pathQueue.pop(path)) {
+                PipelineImage image;
+                image.path = path;
+                image.name = std::filesystem::path(path).filename().string();
+                {
+                    TRACE_STAGE(decodeTimer, TraceStage::decode);
+                    image.source = decodeImage(path, detection.tileSize > 0 ? 0 : maxSourceDimension);
+                }
+
+                if (image.source.empty()) {
+                    std::cout << "Could not read " << path << std::endl;
+                    inFlight.release();
+                    continue;
+                }
+
+                // The task owns the image until it hands it to the encoders
+                auto pending = std::make_shared<PipelineImage>(std::move(image));
+                workerPool.run(detectTasks, [&, pending] {
+                    auto abandon = [&](const char *reason) {
+                        std::cout << "Could not process " << pending->path << ": " << reason << std::endl;
+                        pending->output.release();
+                        pending->source.release();
+                        inFlight.release();
+                    };
+
+                    // Anything thrown, a bad_alloc from the clone as much as a cv::Exception from detection, must
+                    // still free the slot, or the walker would wait forever. Left to WorkerPool it would also be
+                    // rethrown from the closer thread's wait and end the program.
+                    try {
+                        // Annotate and report at the 2500 pixel working size, unless large scans are tiled
+                        if (detection.tileSize == 0) {
+                            resizeSourceImage(pending->source, pending->source, maxSourceDimension);
+                        }
+                        pending->detections = detector.detect(pending->source, pending->quality);
+                        pending->detectedSize = pending->source.size();
+
+                        // Only draw on a copy of the image if someone will look at it. A tiled scan is drawn at the
+                        // working size, so the full resolution source is never copied.
+                        if (settings.writeImages || settings.keepImages) {
+                            pending->output = renderAnnotated(pending->source, pending->detectedSize,
+                                                              pending->detections,
+                                                              detection.tileSize > 0 ? maxSourceDimension : 0);
+                        }
+                        // Previews and thumbnails are drawn from the source by the encoders
+                        if (!settings.keepImages && settings.previewSize == 0 && settings.thumbnailSize == 0) {
+                            pending->source.release();
+                        }
+                        encodeQueue.push(std::move(*pending));
+                    } catch (const std::exception &e) {
+                        abandon(e.what());
+                    } catch (...) {
+                        abandon("unknown error");
+                    }
+                });
+            }
+        });
+    }
+
+    /*---------------------- Stage 4: Encode and write -------------------------*/
+    std::vector<std::thread> encoders;
+    for (unsigned int i = 0; i < std::max(1u, settings.numEncoders); i++) {
+        encoders.emplace_back([&, i] {
+            TRACE_THREAD_NAME("encoder " + std::to_string(i));
+            PipelineImage image;
+            while (encodeQueue.pop(image)) {
+                // A failed write is reported and the image still finishes, so its slot is freed
+                try {
+                    writeOutputs(image, settings);
+                } catch (const std::exception &e) {
+                    std::cout << "Could not write the output of " << image.name << ": " << e.what() << std::endl;
+                } catch (...) {
+                    std::cout << "Could not write the output of " << image.name << ": unknown error" << std::endl;
+                }
+                if (!settings.keepImages) {
+                    image.output.release();
+                    image.source.release();
+                }
+                imagesProcessed++;
+                finishedQueue.push(std::move(image));
+            }
+        });
+    }
+
+    // Close each queue once every stage feeding it has finished
+    std::thread closer([&] {
+        walker.join();
+        for (std::thread &decoder : decoders) {
+            decoder.join();
+        }
+        workerPool.wait(detectTasks);
+        encodeQueue.close();
+        for (std::thread &encoder : encoders) {
+            encoder.join();
+        }
+        finishedQueue.close();
+    });
+
+    /*------- Stage 5: Report finished images and hand them to the caller ------*/
+    PipelineImage image;
+    while (finishedQueue.pop(image)) {
+        // Images finish on many threads, so their summaries are only printed here, one whole summary at a time
+        std::ostringstream summary;
+        detector.printSummary(image.detections, summary, &image.quality);
+        std::istringstream summaryLines(summary.str());
+        std::string line;
+        std::ostringstream prefixed;
+        while (std::getline(summaryLines, line)) {
+            prefixed << image.name << ": " << line << '\n';
+        }
+        std::cout << prefixed.str() << std::flush;
+
+        if (onFinished) {
+            onFinished(image);
+        }
+        image = PipelineImage();
+        inFlight.release();
+    }
+
+    closer.join();
+    return imagesProcessed;
+}
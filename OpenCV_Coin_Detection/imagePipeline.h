@@ -0,0 +1,92 @@
+//==============================================================================
+// ImagePipeline
+//------------------------------------------------------------------------------
+// Streams a batch of images through the program instead of loading them all 
+// first. A walker thread lists the input files, decoder threads read them (at
+// reduced resolution when that is all detection needs, see imageDecoder.h), 
+// a CoinDetector runs on the worker pool and encoder threads write each annotated
+// image to the output directory as soon as it is ready. The stages are 
+// connected by BoundedQueues, and the walker waits for a free slot before 
+// starting each image, so at most maxImagesInFlight images are held in memory
+// at once no matter how large the batch is.
+//==============================================================================
+
+#ifndef IMAGE_PIPELINE_H
+#define IMAGE_PIPELINE_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "annotationOverlay.h"
+#include "coinDetection.h"
+#include "coinDetector.h"
+#include "workerPool.h"
+
+
+struct PipelineSettings {
+    unsigned int maxImagesInFlight{8};      // images decoded but not yet finished
+    unsigned int numDecoders{0};            // 0 for one per hardware thread, at most maxImagesInFlight
+    unsigned int numEncoders{2};
+    std::string outputDirectory;            // where the annotated images are written
+    bool writeImages{true};                 // false skips drawing and writing the annotated images
+    bool keepImages{true};                  // hand source and output to onFinished, false releases them early
+    OverlayFormat overlayFormat{OverlayFormat::none};  // annotations written next to each input image
+    int previewSize{0};                     // above 0 writes an annotated <name>_preview.jpg of this size
+    int thumbnailSize{0};                   // above 0 writes a thumbnail of every coin of at most this size
+};
+
+
+// One image as it moves through the pipeline
+struct PipelineImage {
+    std::string name;       // file name without directories
+    std::string path;       // path the image was read from
+    cv::Mat source;         // decoded image, released after detection unless it is still needed
+    cv::Mat output;         // annotated image, empty unless writeImages or keepImages. At most
+                            // maxSourceDimension on a side for a tiled scan.
+    cv::Size detectedSize;  // size of source after it was resized for detection
+    std::vector<CoinDetection> detections;
+    DetectionQuality quality;   // quality the image was detected at, see adaptiveQuality.h
+};
+
+
+/*-------------------------------- isInputImage --------------------------------
+ * Precondition:  None
+ * Postcondition: Returns true if path names a file the pipeline reads, which 
+ *                is any file with the extension ".jpg", ".jpeg" or ".png" in
+ *                any case.
+ */
+bool isInputImage(const std::string &path);
+
+
+/*------------------------------- outputFileName -------------------------------
+ * Precondition:  imgName has an extension.
+ * Postcondition: Returns imgName with "_output" inserted before its 
+ *                extension.
+ */
+std::string outputFileName(const std::string &imgName);
+
+
+/*-------------------------------- runPipeline ---------------------------------
+ * Precondition:  inputPath is an input image or a directory. detector 
+ *                classifies on workerPool. Must not be called from a task of
+ *                workerPool.
+ * Postcondition: Every input image has been decoded, resized the way 
+ *                CoinDetector resizes it and passed to detector. If 
+ *                settings.writeImages is set its annotated image is written
+ *                to settings.outputDirectory, and its overlay, preview and
+ *                coin thumbnails as settings asks. Once it is written the
+ *                detector's summary of the image, every line prefixed with 
+ *                its name, is printed on the calling thread. If onFinished 
+ *                is set it is then called there with the image and its
+ *                detections, and the image stays in flight until onFinished
+ *                returns. source and output are 
+ *                only still decoded if settings.keepImages is set. Returns 
+ *                the number of images processed.
+ */
+int runPipeline(const std::string &inputPath, WorkerPool &workerPool, const CoinDetector &detector,
+                const PipelineSettings &settings, const std::function<void(PipelineImage &)> &onFinished);
+
+#endif
@@ -0,0 +1,63 @@
+//==============================================================================
+// Image Utilities
+//------------------------------------------------------------------------------
+// Small image helpers shared by findCoins and the TemplateBank. Each function
+// is implemented in the source file of the same name.
+//==============================================================================
+
+#ifndef IMAGE_UTILITIES_H
+#define IMAGE_UTILITIES_H
+
+#include "opencv2/core.hpp"
+
+
+/*----------------------------- findNumberOfEdges ------------------------------ 
+ * Precondition:  edgeImage must be a single channel, binary image with edges a 
+ *                value of 255 and non-edges as 0.
+ * Postcondition: The number of edge pixels are counted and the sum is returned
+ *                as an int.
+ */
+int findNumberOfEdges(const cv::Mat &edgeImage);
+
+
+/*------------------------------ resizeSourceImage -----------------------------
+ * Precondition:  None
+ * Postcondition: If sourceImg row or col is greater than maxDim, The larger 
+ *                dimension of the sourceImg will be resized to the maxDim size 
+ *                and the smaller dimension will be scaled proportionally and the
+ *                resulting image will be assigned to the outputImg.
+ */
+void resizeSourceImage(cv::Mat sourceImg, cv::Mat &outputImg, const unsigned int maxDim);
+
+
+/*------------------------------- createEdgeImage ------------------------------
+ * Precondition:  colorImg is a 3 channel BGR image with rows and cols greater 
+ *                than 0.
+ * Postcondition: edgeImg is assigned the single channel Canny edge image of 
+ *                colorImg, after it has been converted to grayscale and blurred 
+ *                three times with a 3x3 Gaussian kernel. Patches and templates 
+ *                both go through this function so their edges are comparable.
+ */
+void createEdgeImage(const cv::Mat &colorImg, cv::Mat &edgeImg);
+
+
+/*----------------------------- countMatchingEdges -----------------------------
+ * Precondition:  templateEdges and patchEdges are single channel images of the
+ *                same size.
+ * Postcondition: Returns the number of pixels that are edges (greater than 0)
+ *                in both images. This is the byte-per-pixel reference for the 
+ *                packed kernel in packedEdgeImage.h.
+ */
+int countMatchingEdges(const cv::Mat &templateEdges, const cv::Mat &patchEdges);
+
+
+/*----------------------------- downsampleEdgeImage ----------------------------
+ * Precondition:  edgeImg is a single channel 8-bit image.
+ * Postcondition: coarseImg is assigned a CV_8UC1 image of half the rows and 
+ *                cols (rounded up) where each pixel is 255 if any pixel of the
+ *                2x2 block of edgeImg it covers is an edge, and 0 otherwise. 
+ *                Edges that are off by a pixel still overlap at this size.
+ */
+void downsampleEdgeImage(const cv::Mat &edgeImg, cv::Mat &coarseImg);
+
+#endif
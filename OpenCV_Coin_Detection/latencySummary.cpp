@@ -0,0 +1,32 @@
+#include <algorithm>
+
+#include "latencySummary.h"
+
+
+/* summarizeLatencies
+ * Precondition: None
+ * Postcondition: Returns the count, mean, percentiles and maximum of latenciesMs.
+ */
+LatencySummary summarizeLatencies(std::vector<double> latenciesMs) {
+    LatencySummary summary;
+    summary.count = latenciesMs.size();
+    if (latenciesMs.empty()) {
+        return summary;
+    }
+
+    double totalMs = 0.0;
+    for (double latency : latenciesMs) {
+        totalMs += latency;
+    }
+    std::sort(latenciesMs.begin(), latenciesMs.end());
+    auto percentile = [&](double fraction) {
+        return latenciesMs[std::min(latenciesMs.size() - 1, (size_t) (fraction * latenciesMs.size()))];
+    };
+
+    summary.meanMs = totalMs / latenciesMs.size();
+    summary.p50Ms = percentile(0.50);
+    summary.p95Ms = percentile(0.95);
+    summary.p99Ms = percentile(0.99);
+    summary.maxMs = latenciesMs.back();
+    return summary;
+}
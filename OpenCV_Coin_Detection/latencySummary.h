@@ -0,0 +1,34 @@
+//==============================================================================
+// LatencySummary
+//------------------------------------------------------------------------------
+// Mean, percentiles and worst case of a set of latencies, shared by the video
+// stream, the detection server and its client when they report how long 
+// frames or requests took.
+//==============================================================================
+
+#ifndef LATENCY_SUMMARY_H
+#define LATENCY_SUMMARY_H
+
+#include <cstddef>
+#include <vector>
+
+
+struct LatencySummary {
+    size_t count{0};
+    double meanMs{0.0};
+    double p50Ms{0.0};
+    double p95Ms{0.0};
+    double p99Ms{0.0};
+    double maxMs{0.0};
+};
+
+
+/*------------------------------ summarizeLatencies ----------------------------
+ * Precondition:  None
+ * Postcondition: Returns the count, mean, 50th, 95th and 99th percentile and 
+ *                maximum of latenciesMs, all 0 if it is empty. Percentiles are
+ *                the nearest sample at or above the rank.
+ */
+LatencySummary summarizeLatencies(std::vector<double> latenciesMs);
+
+#endif
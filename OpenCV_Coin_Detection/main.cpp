@@ -15,12 +15,15 @@
 //         quarter).
 //      5. Report on the total value of the coins in the image.
 //
-// This program will read in all ".jpg" images which are contained in the "Test 
-// Images" directory local to the program. Any images you do not wish to run 
-// should be put into the "Additional Images" folder in the "Test Images" 
-// directory. After the input images are processed, the corresponding output 
+// This program will read in all ".jpg", ".jpeg" and ".png" images which are 
+// contained in the "Test Images" directory local to the program. Any images 
+// you do not wish to run should be put into the "Additional Images" folder in
+// the "Test Images" directory. After the input images are processed, the corresponding output 
 // images will be saved to the "Output Images" directory local to the program
-// and displayed to the screen.
+// and displayed to the screen. Run with --headless to skip the display and 
+// write a detection record per image instead, or with --video to follow the
+// coins through a video file or camera stream, or with --serve to keep the
+// templates loaded and answer local clients (see programOptions.h).
 //------------------------------------------------------------------------------
 // Project Pre-conditions:
 //   -- Must be compiled using C++ 17 standard in order to use std::filesystem.
@@ -41,54 +44,27 @@
 //==============================================================================
 
 #include <iostream>
-#include <iomanip>
-#include <map>
 #include <filesystem>
-#include <thread>
+#include <fstream>
 
-#include "opencv2/imgcodecs.hpp"
 #include "opencv2/highgui.hpp"
-#include "opencv2/imgproc.hpp"
 
-
-/*----------------------------- findNumberOfEdges ------------------------------ 
- * Precondition:  edgeImage must be a single channel, binary image with edges a 
- *                value of 255 and non-edges as 0.
- * Postcondition: The number of edge pixels are counted and the sum is returned
- *                as an int.
- */
-int findNumberOfEdges(cv::Mat& edgeImage);
-
-
-/*------------------------------ resizeSourceImage -----------------------------
- * Precondition:  None
- * Postcondition: If sourceImg row or col is greater than maxDim, The larger 
- *                dimension of the sourceImg will be resized to the maxDim size 
- *                and the smaller dimension will be scaled proportionally and the
- *                resulting image will be assigned to the outputImg.
- */
-void resizeSourceImage(cv::Mat sourceImg, cv::Mat &outputImg, const unsigned int maxDim);
-
-
-/*---------------------------------- findCoins ---------------------------------
- * Precondition:  A valid sourceImg is provided which has rows and cols greater 
- *                than 0. A directory must be called "Template Images" where 8 
- *                images must exist serving as the template images (Two images 
- *                for each type of coin (Quarter, Dime, Nickle, Penny) one for 
- *                heads and one for tails). The 8 images must have the following
- *                names: dimeHeads.jpg, dimeTails.jpg, nickelHeads.jpg, 
- *                nickelTails.jpg, pennyHeads.jpg, pennyTails.jpg, 
- *                quarterHeads.jpg, quarterTails.jpg.
- * Postcondition: All the elliptical objects in the sourceImg will be enclosed in
- *                a red ellipse on the outputImg. The elliptical objects which 
- *                are deemed to be coins will have a green bounding rectangle 
- *                drawn on the outputImg along with text labeling what type of 
- *                coin it is, whether its heads or tails up, and the percentage
- *                of closest match it was to the matched template. Lastly, the 
- *                image will include the estimated value of the coins at the top
- *                of the output image.
- */
-void findCoins(cv::Mat &sourceImg, cv::Mat &outputImg);
+#include "annotationOverlay.h"
+#include "batchedClassifier.h"
+#include "candidateClassifier.h"
+#include "classifierTools.h"
+#include "coinDetector.h"
+#include "detectionClient.h"
+#include "detectionRecord.h"
+#include "detectionServer.h"
+#include "featureClassifier.h"
+#include "imagePipeline.h"
+#include "programOptions.h"
+#include "stageTrace.h"
+#include "syntheticScene.h"
+#include "templateBank.h"
+#include "videoStream.h"
+#include "workerPool.h"
 
 
 // Global constants, local directories
@@ -108,443 +84,206 @@ const std::string templateDirectory{"Template Images/"};
  *                heads and one for tails.
  * Postcondition: The function will go through every file that is not a directory
  *                in the local "Test Images" directory and read all the ones 
- *                which have a ".jpg" extension. Then it will call the findCoins 
- *                function on each ".jpg" image which was read in. Once this has 
- *                been done for all the images in the "Test Images" directory, 
- *                both the source image and the corresponding processed output 
- *                image showing the coins will be displayed to the screen one at
- *                a time. After all images are displayed, the outputs image will 
- *                be saved to the local "Output Images" directory with the same 
- *                name as the input image it was generated from with the text 
- *                "_output" appended to it before the ".jpg" extension.
+ *                which have a ".jpg" extension, a few at a time. It will call 
+ *                detect the coins in each ".jpg" image as it is read in. 
+ *                As soon as an image is done, its output image will be saved to
+ *                the local "Output Images" directory with the same name as the
+ *                input image it was generated from with the text "_output" 
+ *                appended to it before the ".jpg" extension, and both the 
+ *                source image and the corresponding processed output image 
+ *                showing the coins will be displayed to the screen. With 
+ *                --headless nothing is displayed, and with --report (or 
+ *                --headless) one record per image of the coins found is 
+ *                written to the report file. With --video the frames of a 
+ *                video file or camera are processed instead, tracking coins
+ *                from frame to frame, and a record is written per frame. With
+ *                --serve the program answers detection requests on a Unix 
+ *                domain socket until stopped, and with --send it sends the 
+ *                input images to such a server instead. With --overlay the
+ *                annotations are written next to each input image in place
+ *                of the output image, and --render-overlays draws them later.
  */
 int main(int argc, char *argv[]) {
 
-    // inputPath to .jpg file or dir containing .jpg file(s)
-    std::string inputPath;
-
-    // if no arguments are provided, default to inputDirectory
-    if (argc == 1) {
-        inputPath = inputDirectory;
-
-    } else {    // else, inputPath is the first argument provided
-        std::cout << "argv: " << argv[1] << std::endl;
-        inputPath = argv[1];
+    // if no input path is provided, default to inputDirectory
+    ProgramOptions options;
+    options.inputPath = inputDirectory;
+    if (!parseProgramOptions(argc, argv, options)) {
+        return -1;
     }
-    std::cout << "The input Path is: " << inputPath << std::endl;
-
-    std::map<std::string, cv::Mat> sourceImgs;  // map to store input images
-    std::map<std::string, cv::Mat> outputImgs;  // map to store output images
 
-    // if inputPath is to directory
-    if (std::filesystem::is_directory(inputPath)) {
-        // go through each entry in the inputPath directory
-        for (const auto &entry : std::filesystem::directory_iterator(inputPath)) {
+    // time every stage of the run if asked, written out and summarized once everything below has finished
+    StageTraceSession traceSession(options.tracePath);
 
-            // if the entry is a jpg file
-            if (entry.path().extension() == ".jpg") {
+    // inputPath to .jpg, .jpeg or .png file or dir containing them, unused when streaming a video
+    const std::string &inputPath = options.inputPath;
+    const bool streaming = !options.videoSource.empty();
+    const bool serving = !options.server.socketPath.empty();
+    if (!streaming && !serving && options.syntheticVideoPath.empty()) {
+        std::cout << "The input Path is: " << inputPath << std::endl;
 
-                // trim '/' from name file name
-                std::string imgName = entry.path().string();
-                auto slashPos = static_cast<int>(imgName.find_last_of("/\\"));
-                imgName = imgName.substr(slashPos + 1);
-
-                // read image into sourceImgs map
-                sourceImgs[imgName] = cv::imread(entry.path().string());
-            }
+        if (!std::filesystem::is_directory(inputPath) && !isInputImage(inputPath)) {
+            std::cout << "Please provide path to jpg, jpeg or png image or dir containing them" << std::endl;
+            return -1;
         }
+    }
 
-        // if inputPath is to file and file is a .jpg
-    } else if (inputPath.find(".jpg") != std::string::npos) {
-
-        std::string imgName = inputPath;
-        // trim '/' from name
-        auto slashPos = (int)imgName.find_last_of("/\\");
-        imgName = imgName.substr(slashPos + 1);
+    // send the input images to a running server instead of loading the templates here
+    if (!options.sendSocketPath.empty()) {
+        return runDetectionClient(options.sendSocketPath, inputPath, options.client);
+    }
 
-        sourceImgs[imgName] = cv::imread(inputPath);
+    // draw the overlays written by an earlier --overlay=json run, without detecting or loading the templates
+    if (options.renderOverlays) {
+        int rendered = renderOverlays(inputPath, outputDirectory, options.pipeline.previewSize,
+                                      options.pipeline.thumbnailSize);
+        std::cout << "Rendered " << rendered << " overlays" << std::endl;
+        return rendered > 0 ? 0 : -1;
+    }
 
-    } else {
-        std::cout << "Please provide path to jpg image or dir containing jpg(s)" << std::endl;
+    // map the compiled templates, or decode the templates and precompute their edge maps once, shared by every thread
+    const TemplateBank templateBank(templateDirectory);
+    if (!templateBank.loaded()) {
+        std::cout << "Could not read the 8 template images from " << templateDirectory << std::endl;
         return -1;
     }
+    std::cout << "Templates: " << templateBank.sourceDescription() << std::endl;
 
+    // write a video of known coins to test the stream mode offline
+    if (!options.syntheticVideoPath.empty()) {
+        if (!writeSyntheticVideo(options.syntheticVideoPath, templateBank, 300)) {
+            std::cout << "Could not write " << options.syntheticVideoPath << std::endl;
+            return -1;
+        }
+        std::cout << "Wrote synthetic video " << options.syntheticVideoPath << std::endl;
+        return 0;
+    }
 
-    // vector to store threads
-    std::vector<std::thread> processingThreads;
-
-    // for each input image in sourImgs map
-    for (auto &img : sourceImgs) {
-
-        // start findCoins method on a new thread
-        std::thread t(findCoins, std::ref(img.second), std::ref(outputImgs[img.first]));
+    // fixed number of worker threads shared by the per-image and per-contour tasks
+    WorkerPool workerPool(options.numThreads);
 
-        // move thread to the threads vector
-        processingThreads.push_back(std::move(t));
+    // write every candidate's crop, labelled by template matching, for training the feature classifier
+    if (!options.exportCropsDirectory.empty()) {
+        return exportCandidateCrops(workerPool, templateBank, options.detection, inputPath,
+                                    options.exportCropsDirectory) ? 0 : -1;
     }
 
-    // wait for all the threads from processingThreads vector to finish
-    for (std::thread &t : processingThreads) {
-        if (t.joinable())
-            t.join();
+    // load the trained feature classifier once, shared by every thread
+    std::shared_ptr<FeatureClassifier> featureClassifier;
+    if (options.featureClassifier || options.compareClassifiers) {
+        const std::string modelPath = options.classifierModelPath.empty() ? templateDirectory + featureModelFileName
+                                                                          : options.classifierModelPath;
+        featureClassifier = std::make_shared<FeatureClassifier>();
+        std::string problem;
+        if (!featureClassifier->load(modelPath, problem)) {
+            std::cout << "Could not load the feature classifier: " << problem << ". Train one with ClassifierTrainer"
+                      << std::endl;
+            return -1;
+        }
+        std::cout << "Classifier: " << featureClassifier->name() << " from " << modelPath << std::endl;
     }
 
-    // names windows for the source and output images
-    cv::namedWindow("sourceImg", cv::WINDOW_NORMAL);
-    cv::namedWindow("outImg", cv::WINDOW_NORMAL);
-
-    std::string outImgFileName;
-    int nameExtention;
-
-    // for ever image in outputImgs, write outputImg to local Output Images directory and
-    // display outputImg and corresponding sourceImg
-    for (auto &outImg : outputImgs) {
-
-        cv::resizeWindow("sourceImg", outImg.second.cols / 2, outImg.second.rows / 2);
-        cv::imshow("sourceImg", sourceImgs[outImg.first]);
-
-        cv::resizeWindow("outImg", outImg.second.cols / 2, outImg.second.rows / 2);
-        cv::imshow("outImg", outImg.second);
-
-        outImgFileName = outImg.first;
-        nameExtention = (int)outImgFileName.find(".jpg");
-        outImgFileName.insert(nameExtention, "_output");
-        imwrite(outputDirectory + outImgFileName, outImg.second);
-
-        cv::waitKey();
+    // time classifying the input images' candidates in batches, or by their features, against template matching
+    if (options.compareBatched || options.compareClassifiers) {
+        DetectionSettings packed = options.detection;
+        packed.matcher = MatcherType::packed;
+        packed.compareMatchers = false;
+        const TemplateMatchClassifier templateMatching(templateBank, options.compareBatched ? packed
+                                                                                              : options.detection);
+        bool compared = true;
+        if (options.compareBatched) {
+            DetectionSettings batched = packed;
+            batched.matcher = MatcherType::batched;
+            compared = compareClassifiers(workerPool, packed, inputPath, templateMatching,
+                                          BatchedClassifier(templateBank, batched));
+        }
+        if (options.compareClassifiers && compared) {
+            compared = compareClassifiers(workerPool, options.detection, inputPath, templateMatching,
+                                          *featureClassifier);
+        }
+        return compared ? 0 : -1;
     }
-    return 0;
-}
-
-
-
-
 
-/*---------------------------------- findCoins ---------------------------------
- * Precondition:  A valid sourceImg is provided which has rows and cols greater
- *                than 0. A directory must be called "Template Images" where 8
- *                images must exist serving as the template images (Two images
- *                for each type of coin (Quarter, Dime, Nickle, Penny) one for
- *                heads and one for tails). The 8 images must have the following
- *                names: dimeHeads.jpg, dimeTails.jpg, nickelHeads.jpg,
- *                nickelTails.jpg, pennyHeads.jpg, pennyTails.jpg,
- *                quarterHeads.jpg, quarterTails.jpg.
- * Postcondition: All the elliptical objects in the sourceImg will be enclosed in
- *                a red ellipse on the outputImg. The elliptical objects which
- *                are deemed to be coins will have a green bounding rectangle
- *                drawn on the outputImg along with text labeling what type of
- *                coin it is, whether its heads or tails up, and the percentage
- *                of closest match it was to the matched template. Lastly, the
- *                image will include the estimated value of the coins at the top
- *                of the output image.
- */
-void findCoins(cv::Mat &sourceImg, cv::Mat &outputImg) {
-
-    // Constants
-    const int cannyThreshold{25};
-    const int cannyThreshold2 = cannyThreshold * 2;
-
-    const double ellipseAreaThreshold{0.997};
-    const int minAreaOfCircle{750};
-
-    const int numOfTimeToBlur{6};
-    const int blurKernelSize{5};
-
-    const int numberOfTemplates{8};
-
-    // resize sourceImg to have max dimention of 2500 pixels
-    resizeSourceImage(sourceImg.clone(), sourceImg, 2500);
-
-    // clone sourceImg to outputImg
-    outputImg = sourceImg.clone();
-
-    // Coin Templates
-    int pennyHeads = 0, pennyTails = 1, nickelHeads = 2, nickelTails = 3,
-            dimeHeads = 4, dimeTails = 5, quarterHeads = 6, quarterTails = 7;
-
-    cv::Mat templateImage[numberOfTemplates]{};
-    templateImage[pennyHeads] = cv::imread(templateDirectory + "pennyHeads.jpg");
-    templateImage[pennyTails] = cv::imread(templateDirectory + "pennyTails.jpg");
-    templateImage[nickelHeads] = cv::imread(templateDirectory + "nickelHeads.jpg");
-    templateImage[nickelTails] = cv::imread(templateDirectory + "nickelTails.jpg");
-    templateImage[dimeHeads] = cv::imread(templateDirectory + "dimeHeads.jpg");
-    templateImage[dimeTails] = cv::imread(templateDirectory + "dimeTails.jpg");
-    templateImage[quarterHeads] = cv::imread(templateDirectory + "quarterHeads.jpg");
-    templateImage[quarterTails] = cv::imread(templateDirectory + "quarterTails.jpg");
-
-    int coinTypeCount[numberOfTemplates] = {0};
-
-    /*------------------------- Step 1: BLUR_&_CANNY -------------------------*/
-
-    //1.1 - crease grayscale image from sourceImg
-    cv::Mat sourceImgGray;
-    cvtColor(sourceImg, sourceImgGray, cv::COLOR_BGR2GRAY);
-
-    //1.2 - Blur the Image to reduce noise
-    for (int i = 0; i < numOfTimeToBlur; i++) {
-        cv::GaussianBlur(sourceImgGray, sourceImgGray, cv::Size(blurKernelSize, blurKernelSize), 2.0, 2.0);
+    std::shared_ptr<const CandidateClassifier> classifier;
+    if (options.featureClassifier) {
+        classifier = featureClassifier;
     }
+    const CoinDetector detector(templateBank, workerPool, options.detection, classifier);
 
-    //1.3 - Canny Edge detection
-    cv::Mat sourceImgCanny;
-    Canny(sourceImgGray, sourceImgCanny, cannyThreshold, cannyThreshold2);
-
-    //1.4 - Dilate Canny Image
-    cv::Mat dilationKernel = getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3), cv::Point(1, 1));
-    cv::dilate(sourceImgCanny, sourceImgCanny, dilationKernel);
-
-    //1.5 - Find contours from edges
-    std::vector<std::vector<cv::Point>> contours;
-    findContours(sourceImgCanny, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-    /*cv::namedWindow("Canny", cv::WINDOW_NORMAL);
-    cv::resizeWindow("Canny", cv::Size(sourceImg.cols / 2, sourceImg.rows / 2));
-    imshow("Canny", sourceImgCanny);
-    cv::waitKey();*/
-
-    // create image where contours will be filled solid with color
-    cv::Mat contourFilledWithColorImg = sourceImg.clone();
+    // keep the templates and workers warm and answer local clients until stopped
+    if (serving) {
+        return runDetectionServer(detector, options.server);
+    }
 
-    /*------------ Step 2: Cycle through each Detected Contour ---------------*/
-    for (int currentContour = 0; currentContour < contours.size(); currentContour++) {
+    // headless runs always leave a record of what was found
+    if (options.headless && options.reportPath.empty()) {
+        options.reportPath = outputDirectory + "detections.jsonl";
+    }
 
-        // If contour has less than 5 points or area is less than threshold, skip
-        if (contours[currentContour].size() < 5 || (contourArea(contours[currentContour]) <= minAreaOfCircle)) {
-            continue;
+    // open the file receiving one detection record per image
+    std::ofstream report;
+    RecordFormat reportFormat = recordFormatFor(options.reportPath);
+    if (!options.reportPath.empty()) {
+        report.open(options.reportPath);
+        if (!report) {
+            std::cout << "Could not open report file " << options.reportPath << std::endl;
+            return -1;
         }
+        writeRecordHeader(report, reportFormat);
+    }
 
-        //2.1 - Create Shapes to Enclose the Contour
-        //  Get Bounding Rectangle around Contour
-        cv::Rect_<int> boundingRectVals = boundingRect(contours[currentContour]);
-        cv::Point p1(boundingRectVals.x, boundingRectVals.y);
-        cv::Point p2(boundingRectVals.x + boundingRectVals.width, boundingRectVals.y + boundingRectVals.height);
-
-        //  Find enclosing ellipse of contour
-        cv::RotatedRect ellipse = cv::fitEllipse(contours[currentContour]);
-        double areaOfMinEnclosingEllipse = (ellipse.size.height / 2.0 * ellipse.size.width / 2.0 * CV_PI);
-        double ellipseAreaRatio = contourArea(contours[currentContour]) / areaOfMinEnclosingEllipse;
-
-        //  Skip contour if it does not fit well in an enclosing ellipse
-        if (ellipseAreaRatio < ellipseAreaThreshold || ellipseAreaRatio > (1 - ellipseAreaThreshold) + 1) {
-            continue;
+    // names windows for the source and output images
+    if (!options.headless) {
+        if (!streaming) {
+            cv::namedWindow("sourceImg", cv::WINDOW_NORMAL);
         }
+        cv::namedWindow("outImg", cv::WINDOW_NORMAL);
+    }
 
-        // Draw red enclosing ellipse around contour on outputImg
-        cv::ellipse(outputImg, ellipse, cv::Scalar(0, 0, 255), 3, cv::LINE_AA);
-
-        /*-------------------------Step 3: Get Patch Around the Contour------------------------*/
-
-        // create patch image the same size as Bounding Rectangle around Contour
-        cv::Mat patch(boundingRectVals.height, boundingRectVals.width, CV_8UC3, cv::Scalar(0, 0, 0));
+    // follow the coins through every frame of a video or camera, showing each annotated frame until q or Esc
+    if (streaming) {
+        options.stream.annotate = !options.headless;
+        int framesProcessed = runVideoStream(options.videoSource, workerPool, templateBank, options.detection,
+                                             options.stream, [&](StreamFrame &frame) {
 
-        // fill contour with color cv::Scalar(111, 222, 121) on contourFilledWithColorImg to ignore background
-        cv::ellipse(contourFilledWithColorImg, ellipse, cv::Scalar(111, 222, 121), cv::FILLED, cv::LINE_AA);
+            if (report.is_open()) {
+                writeDetectionRecord(report, reportFormat, "frame_" + std::to_string(frame.index), frame.frame.size(),
+                                     frame.detections);
+            }
+            if (options.headless) {
+                return true;
+            }
 
-        // create filled patch image used to ignore background when extracting coin from image
-        cv::Mat patchFilled = patch.clone();
+            cv::resizeWindow("outImg", frame.output.cols / 2, frame.output.rows / 2);
+            cv::imshow("outImg", frame.output);
 
-        // Extract object found by the contour and store it in a patch
-        for (int sourceRow = boundingRectVals.y, patchRow = 0; patchRow < patch.rows; sourceRow++, patchRow++) {
-            for (int sourceCol = boundingRectVals.x, patchCol = 0; patchCol < patch.cols; sourceCol++, patchCol++) {
-                patchFilled.at<cv::Vec3b>(patchRow, patchCol) = contourFilledWithColorImg.at<cv::Vec3b>(sourceRow,
-                                                                                                        sourceCol);
+            int key = cv::waitKey(1);
+            return key != 'q' && key != 27;
+        });
+        return framesProcessed < 0 ? -1 : 0;
+    }
 
-                //Only take area enclosed by the ellipse, not the background by comparing with patchFilled 
-                if (patchFilled.at<cv::Vec3b>(patchRow, patchCol)[0] == 111 &&
-                    patchFilled.at<cv::Vec3b>(patchRow, patchCol)[1] == 222 &&
-                    patchFilled.at<cv::Vec3b>(patchRow, patchCol)[2] == 121) {
+    // stream every image through decode, the detector and writing to the local Output Images directory, then
+    // record and display each outputImg and corresponding sourceImg as soon as it has been written
+    options.pipeline.outputDirectory = outputDirectory;
+    options.pipeline.keepImages = !options.headless;
+    runPipeline(inputPath, workerPool, detector, options.pipeline, [&](PipelineImage &image) {
 
-                    patch.at<cv::Vec3b>(patchRow, patchCol) = sourceImg.at<cv::Vec3b>(sourceRow, sourceCol);
-                }
-            }
+        if (report.is_open()) {
+            writeDetectionRecord(report, reportFormat, image.name, image.detectedSize, image.detections,
+                                 options.detection.timeBudgetMs > 0.0 ? &image.quality : nullptr);
         }
-        /*cv::namedWindow("Patch", cv::WINDOW_NORMAL);
-        cv::resizeWindow("Patch", patch.cols * 2, patch.rows * 2);
-        imshow("Patch", patch);
-        cv::imwrite("patch.jpg", patch);
-        cv::waitKey();*/
-
-
-        /*---------------------------Step 4: Compare to Template Coins-------------------------*/
-        // 4.1 - Create edge image of patch
-        cv::Mat patchEdges;
-        cv::cvtColor(patch, patchEdges, cv::COLOR_BGR2GRAY);
-        GaussianBlur(patchEdges, patchEdges, cv::Size(3, 3), 2.0, 2.0);
-        GaussianBlur(patchEdges, patchEdges, cv::Size(3, 3), 2.0, 2.0);
-        GaussianBlur(patchEdges, patchEdges, cv::Size(3, 3), 2.0, 2.0);
-        Canny(patchEdges, patchEdges, 20, 40);
-
-        /*cv::namedWindow("patchedges", cv::WINDOW_NORMAL);
-        cv::resizeWindow("patchedges", patchEdges.rows * 2, patchEdges.cols * 2);
-        imshow("patchedges", patchEdges);
-        cv::imwrite("patchEdges.jpg", patchEdges);
-        cv::waitKey();*/
-
-        // 4.2 - Calculate ratio of edges to non-edges for the patch
-        int numPatchEdges = findNumberOfEdges(patchEdges);
-        double percentEdges = ((double) numPatchEdges / ((double) patchEdges.rows * (double) patchEdges.cols)) * 100;
-
-        // 4.3 - Loop through the template array to compare each template to the current patch
-        double coinMatchPercent[numberOfTemplates] = {0.0}; //Percentage of edges that match between patch and template
-        for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
-
-            //  4.3.1 - Resize template coin to match scale of patch
-            cv::Mat resizedCoin;
-            double ratio = (double)patch.cols / templateImage[currentCoin].cols;
-            int width = patch.cols;
-            int height = patch.rows;
-
-            cv::Size_<int> dim = cv::Size(width, height);
-            cv::resize(templateImage[currentCoin], resizedCoin, dim, ratio, ratio, cv::INTER_AREA);
-
-            //  4.3.2 - Create an edge image for the current template coin
-            cv::Mat templateEdges;
-            cv::cvtColor(resizedCoin, templateEdges, cv::COLOR_BGR2GRAY);
-            GaussianBlur(templateEdges, templateEdges, cv::Size(3, 3), 2.0, 2.0);
-            GaussianBlur(templateEdges, templateEdges, cv::Size(3, 3), 2.0, 2.0);
-            GaussianBlur(templateEdges, templateEdges, cv::Size(3, 3), 2.0, 2.0);
-            Canny(templateEdges, templateEdges, 20, 40);
-            int numTemplateEdges = findNumberOfEdges(templateEdges);
-
-            //  4.3.3 - Try every rotation of template image and count the number of matching edges
-            const int degreeIncrement = 5;
-            const int matchCountSize = 360 / degreeIncrement;
-            int rotationMatchCount[matchCountSize] = {0};
-            cv::Mat rotatedTemplate;
-
-            for (int degrees = 0, countIndex = 0;
-                 degrees < 360 && countIndex < matchCountSize; degrees += degreeIncrement, countIndex++) {
-                cv::Mat rotationMat = cv::getRotationMatrix2D(cv::Point(templateEdges.cols / 2,
-                                                                        templateEdges.rows / 2), degrees, 1.0);
-
-                cv::warpAffine(templateEdges, rotatedTemplate, rotationMat, templateEdges.size());
-
-                // Check for match between the patch and the current rotation of the template
-                for (int r = 0; r < rotatedTemplate.rows; r++) {
-                    for (int c = 0; c < rotatedTemplate.cols; c++) {
-                        //If there is an edge in the template image, check for a match in the patch
-                        if (rotatedTemplate.at<uchar>(r, c) > 0) {
-                            //If corresponding pixel in the patch is also an edge, increment the count
-                            if (patchEdges.at<uchar>(r, c) > 0) {
-                                rotationMatchCount[countIndex]++;
-                            }
-                        }
-                    }
-                }
-
-                //Find the percentage of matching edges for this rotation
-                double rotationMatchPercent =
-                        ((double) rotationMatchCount[countIndex] / (double) numTemplateEdges) * 100.0;
-
-                if (rotationMatchPercent > coinMatchPercent[currentCoin]) {
-                    //Save the highest percentage of matches
-                    coinMatchPercent[currentCoin] = rotationMatchPercent;
-                }
-            }
+        if (options.headless) {
+            return;
         }
 
-        /*-----------------------Step 5: Determine which template gave the best match----------------------*/
-        //Find which coin type and orientation (heads/tails) gave the best match count
-        double percentMatchingEdges = 0.0;
-        int bestTemplateMatch = 0;
-        for (int voteIndex = 0; voteIndex < numberOfTemplates; voteIndex++) {
-            if (coinMatchPercent[voteIndex] > percentMatchingEdges) {
-                percentMatchingEdges = coinMatchPercent[voteIndex];
-                bestTemplateMatch = voteIndex;
-            }
-        }
+        cv::resizeWindow("sourceImg", image.output.cols / 2, image.output.rows / 2);
+        cv::imshow("sourceImg", image.source);
 
-        // if more than 38% of the edges match, then its a coin
-        if (percentMatchingEdges > 38.0) {
-
-            /*-------------------Step 6: Determine which type of Coin it is-------------------------*/
-            std::cout << "Patch Closest to ";
-            std::string coinName = "Coin";
-            switch (bestTemplateMatch) {
-                case 0:
-                    coinName = "Penny (Heads Up)";
-                    coinTypeCount[pennyHeads]++;
-                    break;
-                case 1:
-                    coinName = "Penny (Tails Up)";
-                    coinTypeCount[pennyTails]++;
-                    break;
-                case 2:
-                    coinName = "Nickel (Heads Up)";
-                    coinTypeCount[nickelHeads]++;
-                    break;
-                case 3:
-                    coinName = "Nickel (Tails Up)";
-                    coinTypeCount[nickelTails]++;
-                    break;
-                case 4:
-                    coinName = "Dime (Heads Up)";
-                    coinTypeCount[dimeHeads]++;
-                    break;
-                case 5:
-                    coinName = "Dime (Tails Up)";
-                    coinTypeCount[dimeTails]++;
-                    break;
-                case 6:
-                    coinName = "Quarter (Heads Up)";
-                    coinTypeCount[quarterHeads]++;
-                    break;
-                case 7:
-                    coinName = "Quarter (Tails Up)";
-                    coinTypeCount[quarterTails]++;
-                    break;
-            }
-            std::cout << coinName << " with " << percentMatchingEdges << "% matching edges" << std::endl;
-            /*cv::namedWindow("Patch", cv::WINDOW_NORMAL);
-            cv::resizeWindow("Patch", patch.cols * 2, patch.rows * 2);
-            imshow("Patch", patch);
-            cv::waitKey();*/
-
-
-            /*----------------Step 7: Draw Identifying Shapes and Annotate Findings----------------*/
-            // Draw enclosing rectangle
-            cv::rectangle(outputImg, p1, p2, cv::Scalar(0, 255, 0), 2, cv::LINE_AA);
-
-            // Write Annotation for Object Identification
-            cv::Point textOrigin(p1.x, p2.y + 30);
-            cv::putText(outputImg, coinName, textOrigin, cv::FONT_HERSHEY_SIMPLEX, 1.0,
-                        cv::Scalar(0, 0, 0), 4);
-            cv::putText(outputImg, coinName, textOrigin, cv::FONT_HERSHEY_SIMPLEX, 1.0,
-                        cv::Scalar(255, 255, 255), 2);
-
-            std::stringstream ss;
-            ss << percentMatchingEdges << "% Match";
-            std::string percentMatch = ss.str();
-
-            cv::Point matchTextOrigin(p1.x, p2.y + 60);
-            cv::putText(outputImg, percentMatch, matchTextOrigin, cv::FONT_HERSHEY_SIMPLEX, 1.0,
-                        cv::Scalar(0, 0, 0), 4);
-
-            cv::putText(outputImg, percentMatch, matchTextOrigin, cv::FONT_HERSHEY_SIMPLEX, 1.0,
-                        cv::Scalar(255, 255, 255), 2);
-        }
-    }
+        cv::resizeWindow("outImg", image.output.cols / 2, image.output.rows / 2);
+        cv::imshow("outImg", image.output);
 
-    // Determine value of the collection
-    double valueOfCollection = 0.0;
-    valueOfCollection += (coinTypeCount[pennyHeads] * 0.01);
-    valueOfCollection += (coinTypeCount[pennyTails] * 0.01);
-    valueOfCollection += (coinTypeCount[nickelHeads] * 0.05);
-    valueOfCollection += (coinTypeCount[nickelTails] * 0.05);
-    valueOfCollection += (coinTypeCount[dimeHeads] * 0.10);
-    valueOfCollection += (coinTypeCount[dimeTails] * 0.10);
-    valueOfCollection += (coinTypeCount[quarterHeads] * 0.25);
-    valueOfCollection += (coinTypeCount[quarterTails] * 0.25);
-
-    std::stringstream ss;
-    ss << "Total Value of Collection: $" << std::setprecision(2) << std::fixed << valueOfCollection;
-    std::string collectionValue = ss.str();
-
-    cv::Point textOrigin(30, 60);
-    cv::putText(outputImg, collectionValue, textOrigin, cv::FONT_HERSHEY_SIMPLEX, 2.0,
-                cv::Scalar(0, 0, 0), 6);
-    cv::putText(outputImg, collectionValue, textOrigin, cv::FONT_HERSHEY_SIMPLEX, 2.0,
-                cv::Scalar(100, 255, 0), 2);
-
-    return;
-}
\ No newline at end of file
+        cv::waitKey();
+    });
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile() : mappedData(nullptr), mappedSize(0) {}
+
+
+/* ~MappedFile
+ * Precondition: Nothing still points into the mapping.
+ * Postcondition: The file is unmapped.
+ */
+MappedFile::~MappedFile() {
+    if (mappedData == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mappedData);
+#else
+    munmap((void *) mappedData, mappedSize);
+#endif
+}
+
+
+/* open
+ * Precondition: Nothing is mapped yet.
+ * Postcondition: Maps the whole file at path read-only. Returns false if it cannot be opened, is empty or cannot be
+ *                mapped.
+ */
+bool MappedFile::open(const std::string &path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The view keeps the mapping and the file open, so both handles can be closed straight away
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr) {
+        return false;
+    }
+    mappedData = (const unsigned char *) view;
+    mappedSize = (size_t) fileSize.QuadPart;
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat fileStatus;
+    if (fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0) {
+        close(file);
+        return false;
+    }
+
+    // The mapping keeps the file open, so the descriptor can be closed straight away
+    void *view = mmap(nullptr, (size_t) fileStatus.st_size, PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    mappedData = (const unsigned char *) view;
+    mappedSize = (size_t) fileStatus.st_size;
+#endif
+    return true;
+}
+
+
+const unsigned char *MappedFile::data() const {
+    return mappedData;
+}
+
+
+size_t MappedFile::size() const {
+    return mappedSize;
+}
@@ -0,0 +1,46 @@
+//==============================================================================
+// MappedFile
+//------------------------------------------------------------------------------
+// A whole file mapped read-only into memory, with mmap on POSIX systems and a
+// file mapping on Windows. Pages are loaded by the operating system when they
+// are first read and are shared with every other process mapping the same 
+// file, so several short-lived detectors reading one compiled template bank 
+// hold a single copy of it.
+//==============================================================================
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+
+class MappedFile {
+public:
+    MappedFile();
+
+    /*-------------------------------- ~MappedFile -----------------------------
+     * Precondition:  Nothing still points into the mapping.
+     * Postcondition: The file is unmapped.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /*----------------------------------- open ---------------------------------
+     * Precondition:  Nothing is mapped yet.
+     * Postcondition: Maps the file at path read-only and returns true. Returns
+     *                false if it does not exist, is empty or cannot be mapped.
+     */
+    bool open(const std::string &path);
+
+    const unsigned char *data() const;
+    size_t size() const;
+
+private:
+    const unsigned char *mappedData;
+    size_t mappedSize;
+};
+
+#endif
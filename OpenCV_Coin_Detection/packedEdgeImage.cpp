@@ -0,0 +1,291 @@
+#include "packedEdgeImage.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PACKED_EDGE_X86
+#include <immintrin.h>
+#endif
+
+// GCC and Clang only emit vector instructions in functions marked for them,
+// MSVC allows the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512vpopcntdq")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+
+/* PackedEdgeImage
+ * Precondition: None
+ * Postcondition: Creates an empty packed image.
+ */
+PackedEdgeImage::PackedEdgeImage() : numRows(0), numCols(0), rowWords(0), totalWords(0), externalWords(nullptr) {}
+
+
+/* PackedEdgeImage
+ * Precondition: edgeImage is a single channel 8-bit image.
+ * Postcondition: Creates a packed image with a bit set for every non-zero pixel of edgeImage.
+ */
+PackedEdgeImage::PackedEdgeImage(const cv::Mat &edgeImage) : PackedEdgeImage() {
+    pack(edgeImage);
+}
+
+
+/* PackedEdgeImage
+ * Precondition: packedWords holds numWordsFor(rows, cols) words laid out by pack and outlives the packed image.
+ * Postcondition: Creates a packed image reading packedWords in place.
+ */
+PackedEdgeImage::PackedEdgeImage(int rows, int cols, const uint64_t *packedWords) : PackedEdgeImage() {
+    numRows = rows;
+    numCols = cols;
+    rowWords = (numCols + 63) / 64;
+    totalWords = numWordsFor(rows, cols);
+    externalWords = packedWords;
+}
+
+
+/* pack
+ * Precondition: edgeImage is a single channel 8-bit image.
+ * Postcondition: The packed image holds one bit per pixel of edgeImage, rows starting on word boundaries.
+ */
+void PackedEdgeImage::pack(const cv::Mat &edgeImage) {
+    numRows = edgeImage.rows;
+    numCols = edgeImage.cols;
+    rowWords = (numCols + 63) / 64;
+    totalWords = numWordsFor(numRows, numCols);
+    words.assign(totalWords, 0);
+    externalWords = nullptr;
+
+    for (int r = 0; r < numRows; r++) {
+        const uchar *pixel = edgeImage.ptr<uchar>(r);
+        uint64_t *word = &words[(size_t) r * rowWords];
+        for (int c = 0; c < numCols; c++) {
+            if (pixel[c] > 0) {
+                word[c >> 6] |= (uint64_t) 1 << (c & 63);
+            }
+        }
+    }
+}
+
+
+/* unpack
+ * Precondition: None
+ * Postcondition: edgeImage is assigned a CV_8UC1 image with 255 for every set bit and 0 elsewhere.
+ */
+void PackedEdgeImage::unpack(cv::Mat &edgeImage) const {
+    edgeImage.create(numRows, numCols, CV_8UC1);
+    for (int r = 0; r < numRows; r++) {
+        uchar *pixel = edgeImage.ptr<uchar>(r);
+        const uint64_t *word = row(r);
+        for (int c = 0; c < numCols; c++) {
+            pixel[c] = ((word[c >> 6] >> (c & 63)) & 1) ? 255 : 0;
+        }
+    }
+}
+
+
+int PackedEdgeImage::rows() const {
+    return numRows;
+}
+
+
+int PackedEdgeImage::cols() const {
+    return numCols;
+}
+
+
+int PackedEdgeImage::wordsPerRow() const {
+    return rowWords;
+}
+
+
+size_t PackedEdgeImage::numWords() const {
+    return totalWords;
+}
+
+
+size_t PackedEdgeImage::numWordsFor(int rows, int cols) {
+    size_t rowWords = ((size_t) cols + 63) / 64;
+    return ((size_t) rows * rowWords + wordAlignment - 1) / wordAlignment * wordAlignment;
+}
+
+
+size_t PackedEdgeImage::capacity() const {
+    return words.capacity();
+}
+
+
+const uint64_t *PackedEdgeImage::data() const {
+    return externalWords ? externalWords : words.data();
+}
+
+
+const uint64_t *PackedEdgeImage::row(int r) const {
+    return data() + (size_t) r * rowWords;
+}
+
+
+/*------------------------------ Matching Kernels ------------------------------
+ * Each kernel returns the number of set bits in (a AND b) over numWords words.
+ * numWords is always a multiple of PackedEdgeImage::wordAlignment.
+ */
+typedef int (*PopcountAndKernel)(const uint64_t *a, const uint64_t *b, size_t numWords);
+
+
+static int popcountAndScalar(const uint64_t *a, const uint64_t *b, size_t numWords) {
+    int count = 0;
+    for (size_t i = 0; i < numWords; i++) {
+#if defined(__GNUC__) || defined(__clang__)
+        count += __builtin_popcountll(a[i] & b[i]);
+#else
+        uint64_t x = a[i] & b[i];
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        count += (int) ((x * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+    return count;
+}
+
+
+#ifdef PACKED_EDGE_X86
+
+// Counts bits per nibble with a shuffle lookup table, then sums bytes with SAD
+TARGET_AVX2 static int popcountAndAvx2(const uint64_t *a, const uint64_t *b, size_t numWords) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+    __m256i total = _mm256_setzero_si256();
+
+    for (size_t i = 0; i < numWords; i += 4) {
+        __m256i v = _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (a + i)),
+                                     _mm256_loadu_si256((const __m256i *) (b + i)));
+        __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, lowNibbles));
+        __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibbles));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256((__m256i *) lanes, total);
+    return (int) (lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+
+
+TARGET_AVX512 static int popcountAndAvx512(const uint64_t *a, const uint64_t *b, size_t numWords) {
+    __m512i total = _mm512_setzero_si512();
+    for (size_t i = 0; i < numWords; i += 8) {
+        __m512i v = _mm512_and_si512(_mm512_loadu_si512((const void *) (a + i)),
+                                     _mm512_loadu_si512((const void *) (b + i)));
+        total = _mm512_add_epi64(total, _mm512_popcnt_epi64(v));
+    }
+
+    // Summed through memory like the AVX2 kernel: GCC 12's _mm512_reduce_add_epi64 warns -Wuninitialized at -O2
+    alignas(64) uint64_t lanes[8];
+    _mm512_store_si512((void *) lanes, total);
+    return (int) (lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7]);
+}
+
+#endif
+
+
+/* kernelFunction
+ * Precondition: kernel is supported (popcountKernelSupported).
+ * Postcondition: Returns the function that implements kernel.
+ */
+static PopcountAndKernel kernelFunction(PopcountKernel kernel) {
+#ifdef PACKED_EDGE_X86
+    if (kernel == PopcountKernel::avx512) {
+        return popcountAndAvx512;
+    }
+    if (kernel == PopcountKernel::avx2) {
+        return popcountAndAvx2;
+    }
+#endif
+    return popcountAndScalar;
+}
+
+
+/* popcountKernelSupported
+ * Precondition: None
+ * Postcondition: Returns true if kernel was compiled in and the running CPU supports it.
+ */
+bool popcountKernelSupported(PopcountKernel kernel) {
+    switch (kernel) {
+#ifdef PACKED_EDGE_X86
+        case PopcountKernel::avx512:
+            return cv::checkHardwareSupport(CV_CPU_AVX_512VPOPCNTDQ);
+        case PopcountKernel::avx2:
+            return cv::checkHardwareSupport(CV_CPU_AVX2);
+#endif
+        case PopcountKernel::scalar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+/* selectKernel
+ * Precondition: None
+ * Postcondition: Returns the widest kernel the running CPU supports.
+ */
+static PopcountKernel selectKernel() {
+    if (popcountKernelSupported(PopcountKernel::avx512)) {
+        return PopcountKernel::avx512;
+    }
+    if (popcountKernelSupported(PopcountKernel::avx2)) {
+        return PopcountKernel::avx2;
+    }
+    return PopcountKernel::scalar;
+}
+
+
+/* countMatchingEdges
+ * Precondition: templateEdges and patchEdges have the same rows and cols.
+ * Postcondition: Returns the number of pixels that are edges in both images.
+ */
+int countMatchingEdges(const PackedEdgeImage &templateEdges, const PackedEdgeImage &patchEdges) {
+    return countMatchingEdges(templateEdges, patchEdges, 0, templateEdges.rows());
+}
+
+
+/* countWithKernel
+ * Precondition: As the row range countMatchingEdges.
+ * Postcondition: Returns the number of pixels in rows [firstRow, endRow) that are edges in both images, counted
+ *                by kernel.
+ */
+static int countWithKernel(PopcountAndKernel kernel, const PackedEdgeImage &templateEdges,
+                           const PackedEdgeImage &patchEdges, int firstRow, int endRow) {
+    CV_Assert(templateEdges.rows() == patchEdges.rows() && templateEdges.cols() == patchEdges.cols());
+
+    // The last block runs on into the zero padding, so every range is a whole number of kernel steps
+    size_t firstWord = (size_t) firstRow * templateEdges.wordsPerRow();
+    size_t endWord = endRow >= templateEdges.rows() ? templateEdges.numWords()
+                                                     : (size_t) endRow * templateEdges.wordsPerRow();
+    return kernel(templateEdges.data() + firstWord, patchEdges.data() + firstWord, endWord - firstWord);
+}
+
+
+/* countMatchingEdges
+ * Precondition: templateEdges and patchEdges have the same rows and cols. firstRow is a multiple of rowBlock and 
+ *               endRow is a multiple of rowBlock or rows().
+ * Postcondition: Returns the number of pixels in rows [firstRow, endRow) that are edges in both images.
+ */
+int countMatchingEdges(const PackedEdgeImage &templateEdges, const PackedEdgeImage &patchEdges, int firstRow,
+                       int endRow) {
+    static const PopcountAndKernel kernel = kernelFunction(selectKernel());
+    return countWithKernel(kernel, templateEdges, patchEdges, firstRow, endRow);
+}
+
+
+/* countMatchingEdges
+ * Precondition: As the row range countMatchingEdges, and kernel is supported.
+ * Postcondition: Returns the number of pixels in rows [firstRow, endRow) that are edges in both images, counted
+ *                by kernel.
+ */
+int countMatchingEdges(const PackedEdgeImage &templateEdges, const PackedEdgeImage &patchEdges, int firstRow,
+                       int endRow, PopcountKernel kernel) {
+    return countWithKernel(kernelFunction(kernel), templateEdges, patchEdges, firstRow, endRow);
+}
@@ -0,0 +1,148 @@
+//==============================================================================
+// PackedEdgeImage
+//------------------------------------------------------------------------------
+// A binary edge image stored one bit per pixel, 64 pixels to a word. Every row
+// starts on a word boundary and the buffer is padded with zero words to a 
+// multiple of 512 bits, so two images of the same size can be compared as two
+// flat word arrays by a vector kernel without any tail handling.
+//
+// countMatchingEdges ANDs two packed images and counts the set bits. It uses an
+// AVX-512 or AVX2 kernel when the CPU supports one and a scalar popcount loop 
+// otherwise. The byte-per-pixel loop it replaces is kept in imageUtilities.h 
+// as a reference. Each kernel can also be asked for by name (PopcountKernel), 
+// so the tests check all of them against that reference.
+//==============================================================================
+
+#ifndef PACKED_EDGE_IMAGE_H
+#define PACKED_EDGE_IMAGE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+
+class PackedEdgeImage {
+public:
+
+    /*------------------------------ PackedEdgeImage ---------------------------
+     * Precondition:  None
+     * Postcondition: Creates an empty packed image with 0 rows and 0 cols.
+     */
+    PackedEdgeImage();
+
+    /*------------------------------ PackedEdgeImage ---------------------------
+     * Precondition:  edgeImage is a single channel 8-bit image.
+     * Postcondition: Creates a packed image with a bit set for every pixel of 
+     *                edgeImage greater than 0.
+     */
+    explicit PackedEdgeImage(const cv::Mat &edgeImage);
+
+    /*------------------------------ PackedEdgeImage ---------------------------
+     * Precondition:  packedWords holds rows x cols bits laid out the way pack
+     *                lays them out, padded to a multiple of wordAlignment 
+     *                words, and outlives the packed image.
+     * Postcondition: Creates a packed image that reads packedWords in place, 
+     *                such as edge maps in a memory mapped file. Nothing is 
+     *                copied.
+     */
+    PackedEdgeImage(int rows, int cols, const uint64_t *packedWords);
+
+    /*------------------------------------ pack --------------------------------
+     * Precondition:  edgeImage is a single channel 8-bit image.
+     * Postcondition: Replaces the contents with the bits of edgeImage, reusing
+     *                the existing buffer when it is large enough.
+     */
+    void pack(const cv::Mat &edgeImage);
+
+    /*----------------------------------- unpack -------------------------------
+     * Precondition:  None
+     * Postcondition: edgeImage is assigned a CV_8UC1 image with 255 for every 
+     *                set bit and 0 elsewhere.
+     */
+    void unpack(cv::Mat &edgeImage) const;
+
+    int rows() const;
+    int cols() const;
+    int wordsPerRow() const;
+
+    // Total words in the buffer including padding, always a multiple of 8
+    size_t numWords() const;
+
+    // Total words an image of rows x cols packs into
+    static size_t numWordsFor(int rows, int cols);
+
+    // Words pack can fill without reallocating the buffer
+    size_t capacity() const;
+
+    const uint64_t *data() const;
+    const uint64_t *row(int r) const;
+
+    // Number of words the buffer is padded to a multiple of (512 bits)
+    static const int wordAlignment{8};
+
+    // Rows per block counted by the row range countMatchingEdges. Any 8 rows 
+    // span a multiple of wordAlignment words, so each block stays aligned.
+    static const int rowBlock{8};
+
+private:
+    int numRows;
+    int numCols;
+    int rowWords;
+    size_t totalWords;
+    std::vector<uint64_t> words;
+    const uint64_t *externalWords;      // words read in place, nullptr when the image owns its words
+};
+
+
+// The kernels countMatchingEdges can run, narrowest first
+enum class PopcountKernel {
+    scalar,
+    avx2,
+    avx512
+};
+
+
+/*--------------------------- popcountKernelSupported --------------------------
+ * Precondition:  None
+ * Postcondition: Returns true if kernel was compiled in and the running CPU 
+ *                has the instructions it needs. scalar is always supported.
+ */
+bool popcountKernelSupported(PopcountKernel kernel);
+
+
+/*----------------------------- countMatchingEdges -----------------------------
+ * Precondition:  templateEdges and patchEdges have the same rows and cols.
+ * Postcondition: Returns the number of pixels that are edges in both images.
+ */
+int countMatchingEdges(const PackedEdgeImage &templateEdges, const PackedEdgeImage &patchEdges);
+
+
+/*----------------------------- countMatchingEdges -----------------------------
+ * Precondition:  templateEdges and patchEdges have the same rows and cols. 
+ *                firstRow is a multiple of rowBlock, and endRow is a multiple
+ *                of rowBlock or is rows().
+ * Postcondition: Returns the number of pixels in rows [firstRow, endRow) that
+ *                are edges in both images.
+ */
+int countMatchingEdges(const PackedEdgeImage &templateEdges, const PackedEdgeImage &patchEdges, int firstRow,
+                       int endRow);
+
+
+/*----------------------------- countMatchingEdges -----------------------------
+ * Precondition:  As the row range countMatchingEdges, and kernel is supported
+ *                (popcountKernelSupported).
+ * Postcondition: Returns the same count as the row range countMatchingEdges,
+ *                counted by kernel instead of the widest supported kernel.
+ */
+int countMatchingEdges(const PackedEdgeImage &templateEdges, const PackedEdgeImage &patchEdges, int firstRow,
+                       int endRow, PopcountKernel kernel);
+
+
+/*----------------------------- findNumberOfEdges ------------------------------
+ * Precondition:  None
+ * Postcondition: Returns the number of set bits (edge pixels) in edgeImage.
+ */
+int findNumberOfEdges(const PackedEdgeImage &edgeImage);
+
+#endif
@@ -0,0 +1,76 @@
+#include "opencv2/imgproc.hpp"
+
+#include "polarMatcher.h"
+#include "imageUtilities.h"
+
+
+/* createPolarSpectrum
+ * Precondition: edgeImage is a square single channel edge image and centre lies inside it.
+ * Postcondition: spectrum is assigned the row-wise DFT of the polar image of edgeImage, one row per radius.
+ */
+void createPolarSpectrum(const cv::Mat &edgeImage, cv::Point2f centre, bool weightByRadius, cv::Mat &spectrum) {
+    const int radiusBins = std::max(1, edgeImage.cols / 2);
+
+    // Rows of the polar image are angles and columns are radii
+    cv::Mat polar;
+    cv::warpPolar(edgeImage, polar, cv::Size(radiusBins, polarAngleBins), centre, edgeImage.cols / 2.0,
+                  cv::INTER_LINEAR | cv::WARP_POLAR_LINEAR);
+
+    // Transpose so each row is one ring around the full circle, then correlate the rings
+    cv::Mat rings;
+    cv::transpose(polar, rings);
+    rings.convertTo(rings, CV_32F, 1.0 / 255.0);
+
+    if (weightByRadius) {
+        for (int r = 0; r < rings.rows; r++) {
+            float *ring = rings.ptr<float>(r);
+            for (int c = 0; c < rings.cols; c++) {
+                ring[c] *= (float) (r + 0.5);
+            }
+        }
+    }
+    cv::dft(rings, spectrum, cv::DFT_ROWS);
+}
+
+
+/* matchTemplatePolar
+ * Precondition: scale belongs to a loaded TemplateBank, patchSpectrum was created from patchEdges without weighting.
+ * Postcondition: Returns the best 1 degree rotation of the template and its exact percentage of matching edges.
+ */
+TemplateMatch matchTemplatePolar(const TemplateBank::Scale &scale, int templateIndex, const cv::Mat &patchSpectrum,
+                                 const cv::Mat &patchEdges) {
+
+    // Correlate every ring of the patch with the same ring of the template. The DFT is linear, so the rings
+    // can be summed in the frequency domain and a single inverse DFT gives the score for all 360 shifts.
+    cv::Mat product, summedRings, correlation;
+    cv::mulSpectrums(patchSpectrum, scale.polarSpectra[templateIndex], product, cv::DFT_ROWS, true);
+    cv::reduce(product, summedRings, 0, cv::REDUCE_SUM);
+    cv::dft(summedRings, correlation, cv::DFT_INVERSE | cv::DFT_REAL_OUTPUT | cv::DFT_SCALE);
+
+    // correlation[s] scores a patch shifted by s degrees against the template, which is the template 
+    // rotated by -s degrees in the direction used by cv::getRotationMatrix2D
+    cv::Point bestShift;
+    cv::minMaxLoc(correlation, nullptr, nullptr, nullptr, &bestShift);
+    int bestDegrees = (polarAngleBins - bestShift.x) % polarAngleBins;
+
+    // Measure the exact percentage at the peak and its two neighbours, since the polar resampling blurs 
+    // the edges slightly and the true best angle can sit one bin away
+    TemplateMatch bestMatch;
+    const cv::Mat &templateEdges = scale.edges[templateIndex];
+    cv::Mat rotatedTemplate;
+    for (int offset = -1; offset <= 1; offset++) {
+        int degrees = (bestDegrees + offset + polarAngleBins) % polarAngleBins;
+        cv::Mat rotationMat = cv::getRotationMatrix2D(cv::Point(templateEdges.cols / 2, templateEdges.rows / 2),
+                                                      degrees, 1.0);
+        cv::warpAffine(templateEdges, rotatedTemplate, rotationMat, templateEdges.size());
+
+        int rotationMatchCount = countMatchingEdges(rotatedTemplate, patchEdges);
+        double rotationMatchPercent = ((double) rotationMatchCount / (double) scale.numEdges[templateIndex]) * 100.0;
+
+        if (rotationMatchPercent > bestMatch.percent) {
+            bestMatch.percent = rotationMatchPercent;
+            bestMatch.degrees = degrees;
+        }
+    }
+    return bestMatch;
+}
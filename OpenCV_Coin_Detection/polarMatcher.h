@@ -0,0 +1,52 @@
+//==============================================================================
+// Polar Matcher
+//------------------------------------------------------------------------------
+// A rotation-invariant alternative to trying every stored rotation of a 
+// template. Both the patch and the template edge images are resampled into 
+// polar coordinates around the coin centre, one row per radius and one column 
+// per degree, so rotating a coin becomes a circular shift along each row. The 
+// match score at every one of the 360 shifts then comes from a single circular
+// cross-correlation computed with the DFT.
+//
+// The correlation only locates the best angle. The percentage reported is the
+// exact edge count at that angle, so it is on the same scale as the brute 
+// force matcher in templateMatcher.h.
+//==============================================================================
+
+#ifndef POLAR_MATCHER_H
+#define POLAR_MATCHER_H
+
+#include "opencv2/core.hpp"
+
+#include "templateBank.h"
+#include "templateMatcher.h"
+
+
+// Angular resolution of the polar images, one bin per degree
+const int polarAngleBins{360};
+
+
+/*---------------------------- createPolarSpectrum -----------------------------
+ * Precondition:  edgeImage is a square single channel edge image and centre 
+ *                lies inside it.
+ * Postcondition: spectrum is assigned the row-wise DFT (CCS packed) of the 
+ *                polar image of edgeImage around centre, with edgeImage.cols/2
+ *                radius rows and polarAngleBins angle columns. When 
+ *                weightByRadius is true each row is scaled by its radius so the
+ *                correlation approximates an area integral over the coin.
+ */
+void createPolarSpectrum(const cv::Mat &edgeImage, cv::Point2f centre, bool weightByRadius, cv::Mat &spectrum);
+
+
+/*----------------------------- matchTemplatePolar -----------------------------
+ * Precondition:  scale belongs to a loaded TemplateBank, patchEdges is a 
+ *                scale.size x scale.size edge image and patchSpectrum was 
+ *                created from it by createPolarSpectrum without weighting.
+ * Postcondition: Returns the best 1 degree rotation of template templateIndex 
+ *                found by circular cross-correlation, with the exact 
+ *                percentage of matching edges at that rotation.
+ */
+TemplateMatch matchTemplatePolar(const TemplateBank::Scale &scale, int templateIndex, const cv::Mat &patchSpectrum,
+                                 const cv::Mat &patchEdges);
+
+#endif
@@ -0,0 +1,289 @@
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "programOptions.h"
+
+
+// Largest count parseCount accepts for a setting that is stored or used as an int
+const unsigned int maxIntCount{(unsigned int) INT_MAX};
+
+
+/* parseCount
+ * Precondition: None
+ * Postcondition: Assigns value to count and returns true if value is a non-negative whole number no greater than
+ *                maxCount. count is unchanged otherwise.
+ */
+static bool parseCount(const std::string &value, unsigned int &count, unsigned int maxCount = UINT_MAX) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    // strtoull reports overflow in errno where stoul would throw, and the range check keeps the cast from wrapping
+    errno = 0;
+    unsigned long long parsed = std::strtoull(value.c_str(), nullptr, 10);
+    if (errno == ERANGE || parsed > maxCount) {
+        return false;
+    }
+    count = (unsigned int) parsed;
+    return true;
+}
+
+
+/* parseNumber
+ * Precondition: None
+ * Postcondition: Assigns value to number and returns true if value is a non-negative decimal number that fits in a
+ *                double. number is unchanged otherwise.
+ */
+static bool parseNumber(const std::string &value, double &number) {
+    if (value.empty() || value.find_first_not_of("0123456789.") != std::string::npos ||
+        value.find('.') != value.rfind('.') || value == ".") {
+        return false;
+    }
+    errno = 0;
+    double parsed = std::strtod(value.c_str(), nullptr);
+    if (errno == ERANGE || !std::isfinite(parsed)) {
+        return false;
+    }
+    number = parsed;
+    return true;
+}
+
+
+/* parseProgramOptions
+ * Precondition: argv holds argc arguments as passed to main.
+ * Postcondition: options is filled in from the arguments. Returns false if an argument is not recognized.
+ */
+bool parseProgramOptions(int argc, char *argv[], ProgramOptions &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+
+        if (argument.rfind("--", 0) != 0) {
+            options.inputPath = argument;
+
+        } else if (argument == "--matcher=packed") {
+            options.detection.matcher = MatcherType::packed;
+
+        } else if (argument == "--matcher=reference") {
+            options.detection.matcher = MatcherType::reference;
+
+        } else if (argument == "--matcher=polar") {
+            options.detection.matcher = MatcherType::polar;
+
+        } else if (argument == "--matcher=coarse") {
+            options.detection.matcher = MatcherType::coarseToFine;
+
+        } else if (argument == "--matcher=batched") {
+            options.detection.matcher = MatcherType::batched;
+
+        } else if (argument == "--matcher=chamfer") {
+            options.detection.matcher = MatcherType::chamfer;
+
+        } else if (argument == "--compare-matchers") {
+            options.detection.compareMatchers = true;
+
+        } else if (argument.rfind("--batch-size=", 0) == 0) {
+            unsigned int batchSize = 0;
+            if (!parseCount(argument.substr(13), batchSize, maxIntCount) || batchSize == 0) {
+                std::cout << "Invalid batch size: " << argument << std::endl;
+                return false;
+            }
+            options.detection.batchSize = (int) batchSize;
+
+        } else if (argument == "--compare-batched") {
+            options.compareBatched = true;
+
+        } else if (argument == "--classifier=templates") {
+            options.featureClassifier = false;
+
+        } else if (argument == "--classifier=features") {
+            options.featureClassifier = true;
+
+        } else if (argument.rfind("--classifier-model=", 0) == 0 && argument.size() > 19) {
+            options.classifierModelPath = argument.substr(19);
+
+        } else if (argument == "--compare-classifiers") {
+            options.compareClassifiers = true;
+
+        } else if (argument.rfind("--export-crops=", 0) == 0 && argument.size() > 15) {
+            options.exportCropsDirectory = argument.substr(15);
+            if (options.exportCropsDirectory.back() != '/' && options.exportCropsDirectory.back() != '\\') {
+                options.exportCropsDirectory += '/';
+            }
+
+        } else if (argument.rfind("--pyramid-levels=", 0) == 0) {
+            unsigned int levels = 0;
+            if (!parseCount(argument.substr(17), levels) || levels > 4) {
+                std::cout << "Invalid pyramid levels, expected 0 to 4: " << argument << std::endl;
+                return false;
+            }
+            options.detection.pyramidLevels = (int) levels;
+
+        } else if (argument.rfind("--blur-sigma=", 0) == 0) {
+            if (!parseNumber(argument.substr(13), options.detection.blurSigma)) {
+                std::cout << "Invalid blur sigma: " << argument << std::endl;
+                return false;
+            }
+
+        } else if (argument == "--compare-detection") {
+            options.detection.compareDetection = true;
+
+        } else if (argument.rfind("--tile-size=", 0) == 0) {
+            unsigned int tileSize = 0;
+            if (!parseCount(argument.substr(12), tileSize, maxIntCount) || (tileSize > 0 && tileSize < 256)) {
+                std::cout << "Invalid tile size, expected 0 or at least 256: " << argument << std::endl;
+                return false;
+            }
+            options.detection.tileSize = (int) tileSize;
+
+        } else if (argument.rfind("--tile-overlap=", 0) == 0) {
+            unsigned int tileOverlap = 0;
+            if (!parseCount(argument.substr(15), tileOverlap, maxIntCount)) {
+                std::cout << "Invalid tile overlap: " << argument << std::endl;
+                return false;
+            }
+            options.detection.tileOverlap = (int) tileOverlap;
+
+        } else if (argument == "--size-prior") {
+            options.detection.sizePrior = true;
+
+        } else if (argument.rfind("--time-budget=", 0) == 0) {
+            if (!parseNumber(argument.substr(14), options.detection.timeBudgetMs) ||
+                options.detection.timeBudgetMs < 0.0) {
+                std::cout << "Invalid time budget, expected milliseconds: " << argument << std::endl;
+                return false;
+            }
+
+        } else if (argument.rfind("--threads=", 0) == 0) {
+            if (!parseCount(argument.substr(10), options.numThreads, maxIntCount)) {
+                std::cout << "Invalid thread count: " << argument << std::endl;
+                return false;
+            }
+
+        } else if (argument.rfind("--max-in-flight=", 0) == 0) {
+            if (!parseCount(argument.substr(16), options.pipeline.maxImagesInFlight) ||
+                options.pipeline.maxImagesInFlight == 0) {
+                std::cout << "Invalid image count: " << argument << std::endl;
+                return false;
+            }
+
+        } else if (argument.rfind("--decoders=", 0) == 0) {
+            if (!parseCount(argument.substr(11), options.pipeline.numDecoders) || options.pipeline.numDecoders == 0) {
+                std::cout << "Invalid decoder count: " << argument << std::endl;
+                return false;
+            }
+
+        } else if (argument.rfind("--encoders=", 0) == 0) {
+            if (!parseCount(argument.substr(11), options.pipeline.numEncoders) || options.pipeline.numEncoders == 0) {
+                std::cout << "Invalid encoder count: " << argument << std::endl;
+                return false;
+            }
+
+        } else if (argument == "--headless") {
+            options.headless = true;
+
+        } else if (argument.rfind("--report=", 0) == 0 && argument.size() > 9) {
+            options.reportPath = argument.substr(9);
+
+        } else if (argument.rfind("--trace=", 0) == 0 && argument.size() > 8) {
+            options.tracePath = argument.substr(8);
+
+        } else if (argument == "--no-images") {
+            options.pipeline.writeImages = false;
+
+        } else if (argument.rfind("--overlay=", 0) == 0) {
+            std::string format = argument.substr(10);
+            if (format == "svg") {
+                options.pipeline.overlayFormat = OverlayFormat::svg;
+            } else if (format == "json") {
+                options.pipeline.overlayFormat = OverlayFormat::json;
+            } else {
+                std::cout << "Unknown overlay format, expected svg or json: " << argument << std::endl;
+                return false;
+            }
+            // The overlay replaces the annotated image
+            options.pipeline.writeImages = false;
+
+        } else if (argument.rfind("--previews=", 0) == 0) {
+            unsigned int previewSize = 0;
+            if (!parseCount(argument.substr(11), previewSize, maxIntCount)) {
+                std::cout << "Invalid preview size: " << argument << std::endl;
+                return false;
+            }
+            options.pipeline.previewSize = (int) previewSize;
+
+        } else if (argument.rfind("--thumbnails=", 0) == 0) {
+            unsigned int thumbnailSize = 0;
+            if (!parseCount(argument.substr(13), thumbnailSize, maxIntCount)) {
+                std::cout << "Invalid thumbnail size: " << argument << std::endl;
+                return false;
+            }
+            options.pipeline.thumbnailSize = (int) thumbnailSize;
+
+        } else if (argument == "--render-overlays") {
+            options.renderOverlays = true;
+
+        } else if (argument.rfind("--video=", 0) == 0 && argument.size() > 8) {
+            options.videoSource = argument.substr(8);
+
+        } else if (argument.rfind("--video-output=", 0) == 0 && argument.size() > 15) {
+            options.stream.outputPath = argument.substr(15);
+
+        } else if (argument.rfind("--write-synthetic-video=", 0) == 0 && argument.size() > 24) {
+            options.syntheticVideoPath = argument.substr(24);
+
+        } else if (argument.rfind("--serve=", 0) == 0 && argument.size() > 8) {
+            options.server.socketPath = argument.substr(8);
+
+        } else if (argument.rfind("--max-queued=", 0) == 0) {
+            if (!parseCount(argument.substr(13), options.server.maxQueuedRequests) ||
+                options.server.maxQueuedRequests == 0) {
+                std::cout << "Invalid queue length: " << argument << std::endl;
+                return false;
+            }
+
+        } else if (argument.rfind("--handlers=", 0) == 0) {
+            if (!parseCount(argument.substr(11), options.server.numHandlers) || options.server.numHandlers == 0) {
+                std::cout << "Invalid handler count: " << argument << std::endl;
+                return false;
+            }
+
+        } else if (argument.rfind("--max-clients=", 0) == 0) {
+            if (!parseCount(argument.substr(14), options.server.maxClients, maxIntCount) ||
+                options.server.maxClients == 0) {
+                std::cout << "Invalid client count: " << argument << std::endl;
+                return false;
+            }
+
+        } else if (argument.rfind("--send=", 0) == 0 && argument.size() > 7) {
+            options.sendSocketPath = argument.substr(7);
+
+        } else if (argument == "--send-paths") {
+            options.client.sendPaths = true;
+
+        } else if (argument.rfind("--connections=", 0) == 0) {
+            if (!parseCount(argument.substr(14), options.client.numConnections) ||
+                options.client.numConnections == 0) {
+                std::cout << "Invalid connection count: " << argument << std::endl;
+                return false;
+            }
+
+        } else if (argument.rfind("--repeat=", 0) == 0) {
+            if (!parseCount(argument.substr(9), options.client.repeat) || options.client.repeat == 0) {
+                std::cout << "Invalid repeat count: " << argument << std::endl;
+                return false;
+            }
+
+        } else {
+            std::cout << "Unrecognized option: " << argument << std::endl;
+            return false;
+        }
+    }
+
+    if (options.detection.tileSize > 0 && options.detection.tileOverlap >= options.detection.tileSize) {
+        std::cout << "The tile overlap must be smaller than the tile size" << std::endl;
+        return false;
+    }
+    return true;
+}
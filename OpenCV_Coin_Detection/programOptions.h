@@ -0,0 +1,90 @@
+//==============================================================================
+// Program Options
+//------------------------------------------------------------------------------
+// Command line parsing for main. The first argument that does not start with 
+// "--" is the input path, every other argument is an option:
+//
+//      --matcher=packed|reference|polar|coarse|batched|chamfer  how patches are compared
+//      --compare-matchers                  check every patch against brute force
+//      --batch-size=N                      patches per matrix product when batched
+//      --compare-batched                   time batched against per patch matching
+//      --classifier=templates|features     how candidates are classified
+//      --classifier-model=FILE             trained feature classifier to load
+//      --compare-classifiers               time features against template matching
+//      --export-crops=DIR                  write labelled candidate crops and exit
+//      --pyramid-levels=N                  find contours on a cv::pyrDown level
+//      --blur-sigma=S                      single blur used instead of six
+//      --compare-detection                 check the pyramid level against full size
+//      --tile-size=N                       full resolution tiles instead of 2500 px
+//      --tile-overlap=N                    pixels shared by neighbouring tiles
+//      --size-prior                        only match the coin types a candidate's size fits
+//      --time-budget=MS                    adapt quality to detect each image in MS
+//      --threads=N                         worker threads, default one per core
+//      --max-in-flight=N                   images held in memory at once
+//      --decoders=N                        threads reading images
+//      --encoders=N                        threads writing output images
+//      --headless                          never open a window
+//      --report=FILE                       detection records, CSV if FILE ends in .csv
+//      --no-images                         skip writing annotated images
+//      --overlay=svg|json                  annotations next to each image instead
+//      --previews=N                        annotated previews of N pixels
+//      --thumbnails=N                      a thumbnail of every coin of N pixels
+//      --render-overlays                   draw the JSON overlays of the inputs and exit
+//      --trace=FILE                        Chrome trace of every stage, see stageTrace.h
+//      --video=FILE|CAMERA                 process a video or camera stream
+//      --video-output=FILE                 write the annotated stream
+//      --write-synthetic-video=FILE        write a test video and exit
+//      --serve=SOCKET                      answer requests on a Unix domain socket
+//      --max-queued=N                      requests waiting for the server's handlers
+//      --handlers=N                        requests the server detects at once
+//      --max-clients=N                     connections the server accepts at once
+//      --send=SOCKET                       send the input images to a server
+//      --send-paths                        send image paths instead of their bytes
+//      --connections=N                     connections the client sends on at once
+//      --repeat=N                          times the client sends every image
+//==============================================================================
+
+#ifndef PROGRAM_OPTIONS_H
+#define PROGRAM_OPTIONS_H
+
+#include <string>
+
+#include "detectionClient.h"
+#include "detectionServer.h"
+#include "detectionSettings.h"
+#include "imagePipeline.h"
+#include "videoStream.h"
+
+
+struct ProgramOptions {
+    std::string inputPath;              // image file or directory containing image file(s)
+    DetectionSettings detection;
+    unsigned int numThreads{0};         // worker pool size, 0 for one per hardware thread
+    PipelineSettings pipeline;
+    bool headless{false};               // never touch HighGUI
+    std::string reportPath;             // detection records, none if empty
+    std::string tracePath;              // Chrome trace of the run's stages, none if empty
+    std::string videoSource;            // video file or camera index, stills are processed if empty
+    StreamSettings stream;
+    std::string syntheticVideoPath;     // write a synthetic conveyor video here instead of detecting
+    bool renderOverlays{false};         // draw the inputs' JSON overlays instead of detecting
+    bool compareBatched{false};         // compare batched with per patch template matching instead of detecting
+    bool featureClassifier{false};      // classify candidates with the trained FeatureClassifier
+    std::string classifierModelPath;    // model of the FeatureClassifier, the template directory's if empty
+    bool compareClassifiers{false};     // compare the FeatureClassifier with template matching instead of detecting
+    std::string exportCropsDirectory;   // write the input images' candidate crops here instead of detecting
+    ServerSettings server;              // serve detections on server.socketPath if it is set
+    std::string sendSocketPath;         // send the input images to the server listening here if set
+    ClientSettings client;
+};
+
+
+/*---------------------------- parseProgramOptions -----------------------------
+ * Precondition:  argv holds argc arguments as passed to main.
+ * Postcondition: options is filled in from the arguments, keeping its current
+ *                value for anything not given. Returns false and prints the 
+ *                problem to std::cout if an argument is not recognized.
+ */
+bool parseProgramOptions(int argc, char *argv[], ProgramOptions &options);
+
+#endif
@@ -1,6 +1,8 @@
 #include "opencv2/imgcodecs.hpp"
 #include "opencv2/imgproc.hpp"
 
+#include "imageUtilities.h"
+
 /* resizeSourceImage
  * Precondition: None
  * Postcondition: If sourceImg row or col is greater than maxDim, The larger dimension of the sourceImg will be resized
@@ -8,7 +10,7 @@
  *                will be assigned to the outputImg.
  */
 void resizeSourceImage(cv::Mat sourceImg, cv::Mat &outputImg, const unsigned int maxDim) {
-    if (sourceImg.rows > maxDim || sourceImg.cols > maxDim) {
+    if ((unsigned int) sourceImg.rows > maxDim || (unsigned int) sourceImg.cols > maxDim) {
         double ratio;
 
         if (sourceImg.rows > sourceImg.cols) {
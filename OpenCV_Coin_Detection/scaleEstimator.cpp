@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cmath>
+
+#include "scaleEstimator.h"
+#include "stageTrace.h"
+
+
+/* majorAxis
+ * Precondition: None
+ * Postcondition: Returns the longer axis of candidate's ellipse in pixels, its diameter seen at any tilt.
+ */
+static double majorAxis(const CoinDetection &candidate) {
+    return std::max(candidate.ellipse.size.width, candidate.ellipse.size.height);
+}
+
+
+/* estimateSceneScale
+ * Precondition: candidates were found in one image by Step 2.
+ * Postcondition: Returns the scale most candidates agree on, found only if it is not ambiguous.
+ */
+ScaleEstimate estimateSceneScale(const std::vector<CoinDetection> &candidates) {
+    ScaleEstimate estimate;
+
+    std::vector<double> logDiameters;
+    for (const CoinDetection &candidate : candidates) {
+        if (majorAxis(candidate) > 0.0) {
+            logDiameters.push_back(std::log(majorAxis(candidate)));
+        }
+    }
+    estimate.numCandidates = (int) logDiameters.size();
+    if (estimate.numCandidates < minSupportingCandidates) {
+        return estimate;
+    }
+
+    // Heads and tails of a coin share a diameter, so each coin type is tried once
+    double logCoins[numberOfTemplates / 2];
+    for (int coinType = 0; coinType < numberOfTemplates / 2; coinType++) {
+        logCoins[coinType] = std::log(coinDiametersMm[coinType * 2]);
+    }
+
+    // Candidates within fitTolerance of some coin at logScale (log pixels per mm), and the mean of their offsets
+    auto support = [&](double logScale, double &meanOffset) {
+        int supporting = 0;
+        double offsetSum = 0.0;
+        for (double logDiameter : logDiameters) {
+            double bestOffset = fitTolerance + 1.0;
+            for (double logCoin : logCoins) {
+                double offset = logDiameter - logScale - logCoin;
+                if (std::abs(offset) < std::abs(bestOffset)) {
+                    bestOffset = offset;
+                }
+            }
+            if (std::abs(bestOffset) <= fitTolerance) {
+                supporting++;
+                offsetSum += bestOffset;
+            }
+        }
+        meanOffset = supporting > 0 ? offsetSum / supporting : 0.0;
+        return supporting;
+    };
+
+    // Every candidate taken as every coin type proposes a scale
+    std::vector<std::pair<double, int>> proposals;
+    double bestLogScale = 0.0;
+    int bestSupporting = 0;
+    for (double logDiameter : logDiameters) {
+        for (double logCoin : logCoins) {
+            double meanOffset = 0.0;
+            double logScale = logDiameter - logCoin;
+            int supporting = support(logScale, meanOffset);
+            proposals.emplace_back(logScale, supporting);
+            if (supporting > bestSupporting) {
+                bestSupporting = supporting;
+                bestLogScale = logScale + meanOffset;
+            }
+        }
+    }
+
+    // The best scale explained by a different assignment of coin types
+    for (const std::pair<double, int> &proposal : proposals) {
+        if (std::abs(proposal.first - bestLogScale) > 2.0 * fitTolerance) {
+            estimate.rivalSupporting = std::max(estimate.rivalSupporting, proposal.second);
+        }
+    }
+
+    estimate.pixelsPerMm = std::exp(bestLogScale);
+    estimate.supporting = bestSupporting;
+    estimate.found = bestSupporting >= minSupportingCandidates &&
+                     estimate.rivalSupporting < bestSupporting * ambiguityRatio;
+    return estimate;
+}
+
+
+/* countTemplates
+ * Precondition: None
+ * Postcondition: Returns the number of bits of mask set below numberOfTemplates.
+ */
+int countTemplates(unsigned int mask) {
+    int count = 0;
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        count += (mask >> currentCoin) & 1u;
+    }
+    return count;
+}
+
+
+/* plausibleTemplates
+ * Precondition: scale was estimated from the image candidate was found in.
+ * Postcondition: Returns the templates of the coin types candidate's diameter fits at scale, or allTemplates.
+ */
+unsigned int plausibleTemplates(const ScaleEstimate &scale, const CoinDetection &candidate) {
+    if (!scale.found || majorAxis(candidate) <= 0.0) {
+        return allTemplates;
+    }
+
+    double logDiameterMm = std::log(majorAxis(candidate) / scale.pixelsPerMm);
+    unsigned int mask = 0;
+    for (int coinType = 0; coinType < numberOfTemplates / 2; coinType++) {
+        if (std::abs(logDiameterMm - std::log(coinDiametersMm[coinType * 2])) <= pruneTolerance) {
+            // Both faces of the coin
+            mask |= 3u << (coinType * 2);
+        }
+    }
+    return mask == 0 ? allTemplates : mask;
+}
+
+
+/* applySizePrior
+ * Precondition: candidates were found in one image and have not been classified.
+ * Postcondition: Every candidate's plausibleTemplates is set from the scale estimated from all of them.
+ */
+ScaleEstimate applySizePrior(std::vector<CoinDetection> &candidates) {
+    ScaleEstimate scale = estimateSceneScale(candidates);
+    for (CoinDetection &candidate : candidates) {
+        candidate.plausibleTemplates = plausibleTemplates(scale, candidate);
+        TRACE_COUNT(TraceCounter::templatesPruned, numberOfTemplates - countTemplates(candidate.plausibleTemplates));
+    }
+    return scale;
+}
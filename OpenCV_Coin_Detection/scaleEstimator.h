@@ -0,0 +1,91 @@
+//==============================================================================
+// Scale Estimator
+//------------------------------------------------------------------------------
+// A size prior for Step 4. US coins have fixed diameters, so once the scale
+// of a scene is known the size of a candidate's ellipse rules out most coin
+// types before any template is compared (--size-prior, coinDiametersMm):
+//
+//      dime 17.91 mm < penny 19.05 mm < nickel 21.21 mm < quarter 24.26 mm
+//
+// estimateSceneScale clusters the major axes of every candidate of an image
+// in log space: each candidate, taken as each coin type in turn, proposes a
+// scale in pixels per millimetre, and the proposal under which the most
+// candidates land within fitTolerance of some coin diameter wins. A tray of
+// mixed coins pins the scale down; a tray of one coin type does not (all
+// quarters fit a scale just as well as all nickels), so when a clearly
+// different scale explains nearly as many candidates the estimate is
+// ambiguous and every type is kept.
+//
+// With a scale, applySizePrior leaves each candidate only the types within
+// pruneTolerance of its diameter, typically one or two of the four, and the
+// matchers skip the other templates. A candidate that fits no type at that
+// scale keeps all of them, in case the scale does not apply to it.
+//==============================================================================
+
+#ifndef SCALE_ESTIMATOR_H
+#define SCALE_ESTIMATOR_H
+
+#include <vector>
+
+#include "coinDetection.h"
+#include "templateBank.h"
+
+
+// Largest log ratio between a candidate's diameter and a coin's for the candidate to support a scale. Smaller
+// than the 6% between a dime and a penny, the closest two coins.
+const double fitTolerance{0.03};
+
+// Largest log ratio between a candidate's diameter and a coin's for that coin type to be kept
+const double pruneTolerance{0.06};
+
+// A scale needs this many supporting candidates, and a different scale supported by this share of as many makes
+// the estimate ambiguous
+const int minSupportingCandidates{3};
+const double ambiguityRatio{0.8};
+
+
+struct ScaleEstimate {
+    bool found{false};          // false if there were too few candidates or the scale is ambiguous
+    double pixelsPerMm{0.0};    // scale of the best proposal, even if it was not found
+    int supporting{0};          // candidates that fit a coin diameter at that scale
+    int rivalSupporting{0};     // most candidates supporting a clearly different scale
+    int numCandidates{0};
+};
+
+
+/*------------------------------ estimateSceneScale ----------------------------
+ * Precondition:  candidates were found in one image by Step 2 of findCoins.
+ * Postcondition: Returns the scale of the image in pixels per millimetre,
+ *                with found set only if enough candidates agree on it and no
+ *                clearly different scale explains nearly as many of them.
+ */
+ScaleEstimate estimateSceneScale(const std::vector<CoinDetection> &candidates);
+
+
+/*------------------------------ plausibleTemplates ----------------------------
+ * Precondition:  scale was estimated from the image candidate was found in.
+ * Postcondition: Returns the mask of templates (bit t for CoinTemplate t)
+ *                whose coin diameter is within pruneTolerance of candidate's
+ *                at scale, or allTemplates if scale was not found or no coin
+ *                fits.
+ */
+unsigned int plausibleTemplates(const ScaleEstimate &scale, const CoinDetection &candidate);
+
+
+/*-------------------------------- countTemplates ------------------------------
+ * Precondition:  None
+ * Postcondition: Returns the number of templates in mask.
+ */
+int countTemplates(unsigned int mask);
+
+
+/*-------------------------------- applySizePrior ------------------------------
+ * Precondition:  candidates were found in one image by Step 2 and have not
+ *                been classified.
+ * Postcondition: Estimates the scale of the image and sets the
+ *                plausibleTemplates of every candidate from it. Returns the
+ *                estimate.
+ */
+ScaleEstimate applySizePrior(std::vector<CoinDetection> &candidates);
+
+#endif
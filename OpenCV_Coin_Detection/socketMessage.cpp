@@ -0,0 +1,136 @@
+#include <cstring>
+
+#include "socketMessage.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+
+#ifndef _WIN32
+
+/* readFully
+ * Precondition: socketFd is a connected stream socket.
+ * Postcondition: Reads exactly size bytes into data, retrying short and interrupted reads. Returns false at the end
+ *                of the stream or on error.
+ */
+static bool readFully(int socketFd, char *data, size_t size) {
+    while (size > 0) {
+        ssize_t received = recv(socketFd, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= (size_t) received;
+    }
+    return true;
+}
+
+
+/* writeFully
+ * Precondition: socketFd is a connected stream socket.
+ * Postcondition: Writes all size bytes of data, retrying short and interrupted writes. Returns false on error.
+ */
+static bool writeFully(int socketFd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(socketFd, data, size, 0);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= (size_t) sent;
+    }
+    return true;
+}
+
+
+/* readMessage
+ * Precondition: socketFd is a connected stream socket.
+ * Postcondition: Reads one length-prefixed message into payload. Returns false if none could be read.
+ */
+bool readMessage(int socketFd, std::string &payload) {
+    unsigned char header[4];
+    if (!readFully(socketFd, (char *) header, sizeof(header))) {
+        return false;
+    }
+    uint32_t size = (uint32_t) header[0] << 24 | (uint32_t) header[1] << 16 | (uint32_t) header[2] << 8 | header[3];
+    if (size > maxMessageSize) {
+        return false;
+    }
+    payload.resize(size);
+    return size == 0 || readFully(socketFd, &payload[0], size);
+}
+
+
+/* writeMessage
+ * Precondition: socketFd is a connected stream socket and payload is at most maxMessageSize bytes.
+ * Postcondition: Writes payload with its length prefix. Returns false if the write failed.
+ */
+bool writeMessage(int socketFd, const std::string &payload) {
+    uint32_t size = (uint32_t) payload.size();
+    unsigned char header[4] = {(unsigned char) (size >> 24), (unsigned char) (size >> 16),
+                               (unsigned char) (size >> 8), (unsigned char) size};
+    return writeFully(socketFd, (const char *) header, sizeof(header)) &&
+           writeFully(socketFd, payload.data(), payload.size());
+}
+
+
+/* connectToServer
+ * Precondition: None
+ * Postcondition: Returns a socket connected to socketPath, or -1.
+ */
+int connectToServer(const std::string &socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    int socketFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketFd < 0) {
+        return -1;
+    }
+    if (connect(socketFd, (const sockaddr *) &address, sizeof(address)) != 0) {
+        close(socketFd);
+        return -1;
+    }
+    return socketFd;
+}
+
+
+/* closeSocket
+ * Precondition: socketFd is an open socket.
+ * Postcondition: The socket is closed.
+ */
+void closeSocket(int socketFd) {
+    close(socketFd);
+}
+
+#else
+
+// Unix domain sockets are only served on POSIX systems
+bool readMessage(int, std::string &) {
+    return false;
+}
+
+bool writeMessage(int, const std::string &) {
+    return false;
+}
+
+int connectToServer(const std::string &) {
+    return -1;
+}
+
+void closeSocket(int) {}
+
+#endif
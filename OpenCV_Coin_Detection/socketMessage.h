@@ -0,0 +1,68 @@
+//==============================================================================
+// Socket Messages
+//------------------------------------------------------------------------------
+// The protocol the detection server and its client speak over a Unix domain
+// socket. Every message, in either direction, is a 4 byte big-endian payload
+// length followed by the payload.
+//
+// A request payload starts with one byte giving its kind:
+//      'I'  the rest of the payload is an encoded image (JPEG, PNG, ...)
+//      'P'  the rest of the payload is the path of an image on the server
+//      'S'  server statistics, nothing follows
+//
+// The response to an image is its detection record as one line of JSON (see
+// detectionRecord.h). The response to 'S' is a JSON object with the number 
+// of requests served and their latency percentiles. A request that fails is
+// answered with {"error": "..."}, and the connection stays open for the next
+// request unless the message itself could not be read.
+//==============================================================================
+
+#ifndef SOCKET_MESSAGE_H
+#define SOCKET_MESSAGE_H
+
+#include <cstdint>
+#include <string>
+
+
+// Request kinds, the first byte of a request payload
+const char imageRequest{'I'};
+const char pathRequest{'P'};
+const char statsRequest{'S'};
+
+// Messages longer than this are refused and the connection closed
+const uint32_t maxMessageSize{64u << 20};
+
+
+/*--------------------------------- readMessage --------------------------------
+ * Precondition:  socketFd is a connected stream socket.
+ * Postcondition: Reads one message and stores its payload. Returns false if 
+ *                the peer closed the connection, the read failed or the 
+ *                message is longer than maxMessageSize.
+ */
+bool readMessage(int socketFd, std::string &payload);
+
+
+/*--------------------------------- writeMessage -------------------------------
+ * Precondition:  socketFd is a connected stream socket and payload is at most
+ *                maxMessageSize bytes.
+ * Postcondition: Writes payload as one message. Returns false if the write 
+ *                failed.
+ */
+bool writeMessage(int socketFd, const std::string &payload);
+
+
+/*------------------------------ connectToServer -------------------------------
+ * Precondition:  None
+ * Postcondition: Returns a socket connected to the Unix domain socket at 
+ *                socketPath, or -1 if it cannot be reached.
+ */
+int connectToServer(const std::string &socketPath);
+
+
+/*--------------------------------- closeSocket --------------------------------
+ * Precondition:  socketFd was returned by connectToServer or accepted.
+ * Postcondition: The socket is closed.
+ */
+void closeSocket(int socketFd);
+
+#endif
@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "stageTrace.h"
+#include "detectionRecord.h"
+
+
+const char *const traceStageNames[(int) TraceStage::numberOfStages] = {
+        "task", "decode", "detect", "grayAndBlur", "canny", "findContours", "ellipseFilter", "patchExtraction",
+        "templatePreparation", "rotationSweep", "featureExtraction", "annotation", "encode"
+};
+
+const char *const traceCounterNames[(int) TraceCounter::numberOfCounters] = {
+        "contoursFound", "contoursTooSmall", "contoursNotElliptical", "templateAngleEvaluations", "templatesPruned",
+        "coinsAccepted"
+};
+
+// Events kept per thread for the trace file; the summary still counts the stages recorded after this many
+const size_t maxEventsPerThread{1000000};
+
+std::atomic<bool> StageTrace::recordingFlag{false};
+
+
+// One timed stage on one thread, in nanoseconds since the session started
+struct TraceEvent {
+    int64_t startNs;
+    int64_t durationNs;
+    TraceStage stage;
+};
+
+// Totals of one stage on one thread
+struct StageTotals {
+    long long calls{0};
+    int64_t totalNs{0};
+    int64_t maxNs{0};
+};
+
+// Everything one thread recorded. Only its own thread adds to it, the mutex orders that against the session
+// reading it.
+struct ThreadTrace {
+    std::mutex mutex;
+    int id{0};
+    std::string name;
+    std::vector<TraceEvent> events;
+    long long droppedEvents{0};
+    StageTotals totals[(int) TraceStage::numberOfStages];
+    int64_t busyNs{0};      // time in outermost stages
+    int depth{0};           // stages being timed right now, only touched by the owning thread
+};
+
+static std::mutex registryMutex;
+static std::vector<std::shared_ptr<ThreadTrace>> registry;
+static thread_local std::shared_ptr<ThreadTrace> threadTrace;
+
+static std::chrono::steady_clock::time_point sessionStart;
+static std::chrono::steady_clock::time_point sessionEnd;
+static std::atomic<long long> counters[(int) TraceCounter::numberOfCounters];
+
+
+/* thisThread
+ * Precondition: None
+ * Postcondition: Returns the calling thread's trace, registering it as "thread N" the first time.
+ */
+static ThreadTrace &thisThread() {
+    if (!threadTrace) {
+        threadTrace = std::make_shared<ThreadTrace>();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        threadTrace->id = (int) registry.size();
+        threadTrace->name = "thread " + std::to_string(threadTrace->id);
+        registry.push_back(threadTrace);
+    }
+    return *threadTrace;
+}
+
+
+/* nowNs
+ * Precondition: None
+ * Postcondition: Returns the nanoseconds since the session started.
+ */
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                sessionStart).count();
+}
+
+
+/* nameThread
+ * Precondition: None
+ * Postcondition: The calling thread's trace is labelled name.
+ */
+void StageTrace::nameThread(const std::string &name) {
+    ThreadTrace &trace = thisThread();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    trace.name = name;
+}
+
+
+/* count
+ * Precondition: None
+ * Postcondition: amount is added to counter while recording.
+ */
+void StageTrace::count(TraceCounter counter, long long amount) {
+    if (recording()) {
+        counters[(int) counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+}
+
+
+/* ScopedStageTimer
+ * Precondition: None
+ * Postcondition: Starts timing stage while recording.
+ */
+ScopedStageTimer::ScopedStageTimer(TraceStage stage) : stage(stage) {
+    if (StageTrace::recording()) {
+        active = true;
+        thisThread().depth++;
+        startNs = nowNs();
+    }
+}
+
+
+/* next
+ * Precondition: Called on the creating thread.
+ * Postcondition: The current stage is recorded and stage is timed from now.
+ */
+void ScopedStageTimer::next(TraceStage nextStage) {
+    stop();
+    stage = nextStage;
+    if (StageTrace::recording()) {
+        active = true;
+        thisThread().depth++;
+        startNs = nowNs();
+    }
+}
+
+
+/* ~ScopedStageTimer
+ * Precondition: Destroyed on the creating thread.
+ * Postcondition: The current stage is recorded.
+ */
+ScopedStageTimer::~ScopedStageTimer() {
+    stop();
+}
+
+
+/* stop
+ * Precondition: Called on the creating thread.
+ * Postcondition: If a stage is being timed it is added to the thread's events and totals, and no longer timed.
+ */
+void ScopedStageTimer::stop() {
+    if (!active) {
+        return;
+    }
+    active = false;
+
+    int64_t durationNs = nowNs() - startNs;
+    ThreadTrace &trace = thisThread();
+    bool outermost = --trace.depth == 0;
+
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    if (trace.events.size() < maxEventsPerThread) {
+        trace.events.push_back(TraceEvent{startNs, durationNs, stage});
+    } else {
+        trace.droppedEvents++;
+    }
+    StageTotals &totals = trace.totals[(int) stage];
+    totals.calls++;
+    totals.totalNs += durationNs;
+    totals.maxNs = std::max(totals.maxNs, durationNs);
+    if (outermost) {
+        trace.busyNs += durationNs;
+    }
+}
+
+
+/* StageTraceSession
+ * Precondition: No other session exists.
+ * Postcondition: Recording starts with time 0 now, unless tracePath is empty.
+ */
+StageTraceSession::StageTraceSession(const std::string &tracePath) : tracePath(tracePath) {
+    if (tracePath.empty()) {
+        return;
+    }
+#if !COIN_TRACING
+    std::cout << "Tracing was left out of this build (COIN_TRACING is 0), " << tracePath << " will have no stages"
+              << std::endl;
+#endif
+    TRACE_THREAD_NAME("main");
+    for (std::atomic<long long> &counter : counters) {
+        counter = 0;
+    }
+    sessionStart = std::chrono::steady_clock::now();
+    StageTrace::recordingFlag = true;
+}
+
+
+/* ~StageTraceSession
+ * Precondition: Every thread that recorded stages has finished them.
+ * Postcondition: Recording stops, the trace is written to tracePath and the summary printed.
+ */
+StageTraceSession::~StageTraceSession() {
+    if (tracePath.empty()) {
+        return;
+    }
+    StageTrace::recordingFlag = false;
+    sessionEnd = std::chrono::steady_clock::now();
+
+    if (writeChromeTrace(tracePath)) {
+        std::cout << "Wrote trace " << tracePath << std::endl;
+    } else {
+        std::cout << "Could not write trace " << tracePath << std::endl;
+    }
+    printSummary(std::cout);
+}
+
+
+/* printSummary
+ * Precondition: None
+ * Postcondition: The per stage totals over every thread, each thread's busy share of the session and the counters
+ *                are written to out.
+ */
+void StageTraceSession::printSummary(std::ostream &out) const {
+    const int numStages = (int) TraceStage::numberOfStages;
+    double sessionMs = std::chrono::duration<double, std::milli>(
+            (StageTrace::recording() ? std::chrono::steady_clock::now() : sessionEnd) - sessionStart).count();
+
+    StageTotals stages[numStages];
+    std::lock_guard<std::mutex> registryLock(registryMutex);
+    for (const std::shared_ptr<ThreadTrace> &trace : registry) {
+        std::lock_guard<std::mutex> lock(trace->mutex);
+        for (int stage = 0; stage < numStages; stage++) {
+            stages[stage].calls += trace->totals[stage].calls;
+            stages[stage].totalNs += trace->totals[stage].totalNs;
+            stages[stage].maxNs = std::max(stages[stage].maxNs, trace->totals[stage].maxNs);
+        }
+    }
+
+    out << std::fixed << std::setprecision(1)
+        << "Trace of " << sessionMs << " ms" << std::endl
+        << std::left << std::setw(22) << "Stage" << std::right << std::setw(10) << "calls" << std::setw(14)
+        << "total ms" << std::setw(12) << "mean us" << std::setw(12) << "max us" << std::endl;
+    for (int stage = 0; stage < numStages; stage++) {
+        if (stages[stage].calls == 0) {
+            continue;
+        }
+        out << std::left << std::setw(22) << traceStageNames[stage] << std::right
+            << std::setw(10) << stages[stage].calls
+            << std::setw(14) << stages[stage].totalNs / 1e6
+            << std::setw(12) << stages[stage].totalNs / 1e3 / stages[stage].calls
+            << std::setw(12) << stages[stage].maxNs / 1e3 << std::endl;
+    }
+
+    // Outermost stages only, so a worker's busy share is the time it spent running tasks
+    out << std::left << std::setw(22) << "Thread" << std::right << std::setw(10) << "busy %" << std::setw(14)
+        << "busy ms" << std::endl;
+    for (const std::shared_ptr<ThreadTrace> &trace : registry) {
+        std::lock_guard<std::mutex> lock(trace->mutex);
+        if (trace->busyNs == 0) {
+            continue;
+        }
+        out << std::left << std::setw(22) << trace->name << std::right
+            << std::setw(10) << trace->busyNs / 1e4 / std::max(sessionMs, 1e-9)
+            << std::setw(14) << trace->busyNs / 1e6;
+        if (trace->droppedEvents > 0) {
+            out << "  (" << trace->droppedEvents << " events left out of the trace)";
+        }
+        out << std::endl;
+    }
+    out.unsetf(std::ios::floatfield);
+
+    for (int counter = 0; counter < (int) TraceCounter::numberOfCounters; counter++) {
+        out << traceCounterNames[counter] << ": " << counters[counter].load() << std::endl;
+    }
+}
+
+
+/* writeChromeTrace
+ * Precondition: None
+ * Postcondition: Every recorded event, thread name and the counters are written to path as trace_event JSON.
+ */
+bool StageTraceSession::writeChromeTrace(const std::string &path) const {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    // Timestamps are in microseconds, kept to the nanosecond
+    file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+    bool first = true;
+    auto separate = [&] {
+        file << (first ? "" : ",\n");
+        first = false;
+    };
+
+    int64_t lastNs = 0;
+    std::lock_guard<std::mutex> registryLock(registryMutex);
+    for (const std::shared_ptr<ThreadTrace> &trace : registry) {
+        std::lock_guard<std::mutex> lock(trace->mutex);
+        if (trace->events.empty()) {
+            continue;
+        }
+        separate();
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << trace->id
+             << ",\"args\":{\"name\":" << jsonString(trace->name) << "}}";
+        for (const TraceEvent &event : trace->events) {
+            separate();
+            file << "{\"name\":\"" << traceStageNames[(int) event.stage] << "\",\"cat\":\"coins\",\"ph\":\"X\""
+                 << ",\"pid\":1,\"tid\":" << trace->id << ",\"ts\":" << event.startNs / 1e3
+                 << ",\"dur\":" << event.durationNs / 1e3 << "}";
+            lastNs = std::max(lastNs, event.startNs + event.durationNs);
+        }
+    }
+
+    // The counters are totals for the run, shown once at its end
+    separate();
+    file << "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":" << lastNs / 1e3 << ",\"args\":{";
+    for (int counter = 0; counter < (int) TraceCounter::numberOfCounters; counter++) {
+        file << (counter == 0 ? "" : ",") << "\"" << traceCounterNames[counter] << "\":" << counters[counter].load();
+    }
+    file << "}}" << std::endl << "]}" << std::endl;
+    return (bool) file;
+}
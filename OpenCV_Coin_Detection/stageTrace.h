@@ -0,0 +1,188 @@
+//==============================================================================
+// StageTrace
+//------------------------------------------------------------------------------
+// Scoped timers and counters for the stages of findCoins and the pipeline
+// around it, for finding where the time of a run goes. Each thread records
+// into its own buffer, so timing a stage costs two clock reads and no shared
+// lock, and only one atomic load when no trace is being recorded:
+//
+//      TRACE_STAGE(stepTimer, TraceStage::canny);     // times to end of scope
+//      TRACE_NEXT_STAGE(stepTimer, TraceStage::findContours);
+//      TRACE_COUNT(TraceCounter::contoursFound, contours.size());
+//
+// Nothing is recorded until a StageTraceSession is started (--trace=FILE).
+// When it ends it writes every timed stage as a Chrome trace_event JSON file,
+// viewable in chrome://tracing or Perfetto with one row per named thread, and
+// prints the calls and time of each stage, how busy each thread was and the
+// counters. A thread's busy time counts only its outermost stages, so the
+// "task" stage of the WorkerPool shows each worker's utilization.
+//
+// Build with COIN_TRACING defined as 0 to compile every timer and counter
+// out; --trace then only reports that tracing was left out of the build.
+//==============================================================================
+
+#ifndef STAGE_TRACE_H
+#define STAGE_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#ifndef COIN_TRACING
+#define COIN_TRACING 1
+#endif
+
+
+enum class TraceStage {
+    task = 0,               // a WorkerPool task
+    decode,                 // reading and decoding an input image
+    detect,                 // CoinDetector::detect on one image or batch
+    grayAndBlur,            // Step 1 up to Canny
+    canny,                  // Step 1 Canny and dilation
+    findContours,           // Step 1 cv::findContours
+    ellipseFilter,          // Step 2
+    patchExtraction,        // Step 3
+    templatePreparation,    // Step 4 resize, edge image and packing of the patch
+    rotationSweep,          // Step 4 comparison with every template and rotation
+    featureExtraction,      // FeatureClassifier features and prediction
+    annotation,             // Step 7
+    encode,                 // encoding and writing an output image
+    numberOfStages
+};
+
+enum class TraceCounter {
+    contoursFound = 0,
+    contoursTooSmall,           // fewer than 5 points or not larger than minAreaOfCircle
+    contoursNotElliptical,      // outside ellipseAreaThreshold
+    templateAngleEvaluations,   // full size template x rotation edge counts
+    templatesPruned,            // templates the size prior ruled out, summed over the candidates
+    coinsAccepted,
+    numberOfCounters
+};
+
+// Names used in the trace file and the summary, indexed by TraceStage and TraceCounter
+extern const char *const traceStageNames[(int) TraceStage::numberOfStages];
+extern const char *const traceCounterNames[(int) TraceCounter::numberOfCounters];
+
+
+class StageTrace {
+public:
+
+    /*---------------------------------- recording -----------------------------
+     * Precondition:  None
+     * Postcondition: Returns true while a StageTraceSession is recording.
+     */
+    static bool recording() {
+        return recordingFlag.load(std::memory_order_acquire);
+    }
+
+    /*---------------------------------- nameThread ----------------------------
+     * Precondition:  None
+     * Postcondition: The calling thread is shown as name in the trace and the
+     *                summary, instead of "thread N".
+     */
+    static void nameThread(const std::string &name);
+
+    /*------------------------------------ count -------------------------------
+     * Precondition:  None
+     * Postcondition: Adds amount to counter if a trace is being recorded.
+     */
+    static void count(TraceCounter counter, long long amount);
+
+private:
+    friend class ScopedStageTimer;
+    friend class StageTraceSession;
+
+    static std::atomic<bool> recordingFlag;
+};
+
+
+class ScopedStageTimer {
+public:
+
+    /*------------------------------ ScopedStageTimer --------------------------
+     * Precondition:  None
+     * Postcondition: Starts timing stage on the calling thread if a trace is
+     *                being recorded.
+     */
+    explicit ScopedStageTimer(TraceStage stage);
+
+    /*------------------------------------ next --------------------------------
+     * Precondition:  Called on the thread that created the timer.
+     * Postcondition: Records the stage timed so far and starts timing stage.
+     */
+    void next(TraceStage stage);
+
+    /*------------------------------ ~ScopedStageTimer -------------------------
+     * Precondition:  Destroyed on the thread that created it.
+     * Postcondition: Records the stage being timed.
+     */
+    ~ScopedStageTimer();
+
+    ScopedStageTimer(const ScopedStageTimer &) = delete;
+    ScopedStageTimer &operator=(const ScopedStageTimer &) = delete;
+
+private:
+    void stop();
+
+    TraceStage stage;
+    int64_t startNs{0};
+    bool active{false};
+};
+
+
+class StageTraceSession {
+public:
+
+    /*------------------------------ StageTraceSession -------------------------
+     * Precondition:  No other session exists.
+     * Postcondition: Starts recording every stage and counter if tracePath is
+     *                not empty, otherwise does nothing.
+     */
+    explicit StageTraceSession(const std::string &tracePath);
+
+    /*----------------------------- ~StageTraceSession -------------------------
+     * Precondition:  Every thread that recorded stages has finished them.
+     * Postcondition: Stops recording, writes the Chrome trace to tracePath and
+     *                prints the summary to std::cout.
+     */
+    ~StageTraceSession();
+
+    /*-------------------------------- printSummary ----------------------------
+     * Precondition:  None
+     * Postcondition: Writes the calls, total, mean and longest time of every
+     *                stage, the busy time of every thread and the counters
+     *                recorded so far to out.
+     */
+    void printSummary(std::ostream &out) const;
+
+    /*------------------------------ writeChromeTrace --------------------------
+     * Precondition:  None
+     * Postcondition: Writes every stage recorded so far as a complete ("X")
+     *                trace_event, with the thread names and the final counter
+     *                values, to path. Returns false if it cannot be written.
+     */
+    bool writeChromeTrace(const std::string &path) const;
+
+    StageTraceSession(const StageTraceSession &) = delete;
+    StageTraceSession &operator=(const StageTraceSession &) = delete;
+
+private:
+    std::string tracePath;
+};
+
+
+#if COIN_TRACING
+#define TRACE_STAGE(timer, stage) ScopedStageTimer timer(stage)
+#define TRACE_NEXT_STAGE(timer, stage) timer.next(stage)
+#define TRACE_COUNT(counter, amount) StageTrace::count(counter, (long long) (amount))
+#define TRACE_THREAD_NAME(name) StageTrace::nameThread(name)
+#else
+#define TRACE_STAGE(timer, stage) ((void) 0)
+#define TRACE_NEXT_STAGE(timer, stage) ((void) 0)
+#define TRACE_COUNT(counter, amount) ((void) 0)
+#define TRACE_THREAD_NAME(name) ((void) sizeof(name))     // not evaluated, only keeps its operands used
+#endif
+
+#endif
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cmath>
+
+#include "opencv2/imgproc.hpp"
+#include "opencv2/videoio.hpp"
+
+#include "syntheticScene.h"
+
+
+/* drawSyntheticCoin
+ * Precondition: templateBank has been loaded.
+ * Postcondition: The coin's template is drawn on scene as a disc centred on centre, clipped to scene.
+ */
+void drawSyntheticCoin(const TemplateBank &templateBank, const SyntheticCoin &coin, cv::Point2f centre,
+                       cv::Mat &scene) {
+
+    int diameter = std::max(1, (int) std::round(coin.diameter));
+    cv::Mat coinImg;
+    cv::resize(templateBank.templateImage(coin.templateIndex), coinImg, cv::Size(diameter, diameter), 0, 0,
+               cv::INTER_AREA);
+
+    cv::Point2f coinCentre(diameter / 2.0f, diameter / 2.0f);
+    cv::Mat rotation = cv::getRotationMatrix2D(coinCentre, coin.angle, 1.0);
+    cv::warpAffine(coinImg, coinImg, rotation, coinImg.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+    if (coin.brightness != 1.0f) {
+        coinImg.convertTo(coinImg, -1, coin.brightness, 0.0);
+    }
+
+    cv::Mat mask(diameter, diameter, CV_8UC1, cv::Scalar(0));
+    cv::circle(mask, cv::Point(diameter / 2, diameter / 2), diameter / 2, cv::Scalar(255), cv::FILLED, cv::LINE_AA);
+
+    // Clip the coin's square to the scene
+    cv::Rect coinRect((int) std::round(centre.x) - diameter / 2, (int) std::round(centre.y) - diameter / 2,
+                      diameter, diameter);
+    cv::Rect visible = coinRect & cv::Rect(0, 0, scene.cols, scene.rows);
+    if (visible.area() == 0) {
+        return;
+    }
+    cv::Rect inCoin(visible.x - coinRect.x, visible.y - coinRect.y, visible.width, visible.height);
+    cv::Mat sceneRegion = scene(visible);
+    coinImg(inCoin).copyTo(sceneRegion, mask(inCoin));
+}
+
+
+/* renderSyntheticScene
+ * Precondition: templateBank has been loaded and the diameters are fractions between 0 and 1.
+ * Postcondition: Returns the scene drawn from settings.seed, and the coins placed in it.
+ */
+cv::Mat renderSyntheticScene(const TemplateBank &templateBank, const SceneSettings &settings,
+                             std::vector<SyntheticCoin> &coins) {
+    const int placementAttempts{100};
+    cv::RNG rng(settings.seed);
+
+    // Plain background of a random muted colour
+    cv::Mat scene(settings.size, CV_8UC3, cv::Scalar(rng.uniform(40, 140), rng.uniform(40, 140),
+                                                     rng.uniform(40, 140)));
+
+    // Place each coin at a random free spot, leaving a gap so neighbouring contours stay apart
+    const float shorterSide = (float) std::min(settings.size.width, settings.size.height);
+    const float quarterDiameter = settings.trueScale ? shorterSide * rng.uniform(settings.minDiameter,
+                                                                                 settings.maxDiameter) : 0.0f;
+    coins.clear();
+    for (int coinIndex = 0; coinIndex < settings.numCoins; coinIndex++) {
+        SyntheticCoin coin{rng.uniform(0, numberOfTemplates), cv::Point2f(0.0f, 0.0f),
+                           shorterSide * rng.uniform(settings.minDiameter, settings.maxDiameter),
+                           rng.uniform(0.0f, 360.0f), cv::Point2f(0.0f, 0.0f), rng.uniform(0.7f, 1.25f)};
+
+        // Every coin at the scale of the scene's quarter, give or take 1%
+        if (settings.trueScale) {
+            coin.diameter = quarterDiameter * (float) (coinDiametersMm[coin.templateIndex] /
+                                                       coinDiametersMm[quarterHeads]) * rng.uniform(0.99f, 1.01f);
+        }
+
+        for (int attempt = 0; attempt < placementAttempts; attempt++) {
+            float radius = coin.diameter / 2.0f;
+            coin.centre = cv::Point2f(rng.uniform(radius + 2.0f, settings.size.width - radius - 2.0f),
+                                      rng.uniform(radius + 2.0f, settings.size.height - radius - 2.0f));
+            bool free = std::none_of(coins.begin(), coins.end(), [&](const SyntheticCoin &placed) {
+                cv::Point2f offset = placed.centre - coin.centre;
+                float gap = 0.1f * std::max(placed.diameter, coin.diameter) + 4.0f;
+                return std::sqrt(offset.x * offset.x + offset.y * offset.y) <
+                       (placed.diameter + coin.diameter) / 2.0f + gap;
+            });
+            if (free) {
+                drawSyntheticCoin(templateBank, coin, coin.centre, scene);
+                coins.push_back(coin);
+                break;
+            }
+        }
+    }
+
+    // Light falling off in a random direction across the whole scene, coins included, plus sensor noise
+    float lightAngle = rng.uniform(0.0f, (float) (2.0 * CV_PI));
+    cv::Point2f lightDirection(std::cos(lightAngle), std::sin(lightAngle));
+    cv::Point2f sceneCentre(settings.size.width / 2.0f, settings.size.height / 2.0f);
+    float halfDiagonal = std::sqrt(sceneCentre.x * sceneCentre.x + sceneCentre.y * sceneCentre.y);
+
+    cv::Mat noise(settings.size, CV_32FC3);
+    rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0.0), cv::Scalar::all(settings.noise));
+    for (int row = 0; row < scene.rows; row++) {
+        cv::Vec3b *pixel = scene.ptr<cv::Vec3b>(row);
+        const cv::Vec3f *pixelNoise = noise.ptr<cv::Vec3f>(row);
+        for (int col = 0; col < scene.cols; col++) {
+            float along = ((col - sceneCentre.x) * lightDirection.x + (row - sceneCentre.y) * lightDirection.y) /
+                          halfDiagonal;
+            float gain = 1.0f + settings.lighting * along / 2.0f;
+            for (int channel = 0; channel < 3; channel++) {
+                pixel[col][channel] = cv::saturate_cast<uchar>(pixel[col][channel] * gain + pixelNoise[col][channel]);
+            }
+        }
+    }
+    return scene;
+}
+
+
+/* writeSyntheticVideo
+ * Precondition: templateBank has been loaded.
+ * Postcondition: Writes numFrames frames of a synthetic conveyor to path. Returns false if it could not be opened.
+ */
+bool writeSyntheticVideo(const std::string &path, const TemplateBank &templateBank, int numFrames,
+                         cv::Size frameSize) {
+
+    cv::VideoWriter writer(path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30.0, frameSize);
+    if (!writer.isOpened()) {
+        return false;
+    }
+
+    // Coins keep roughly the diameter ratios of real US coins
+    const float quarter = frameSize.height / 5.0f;
+    const float diameters[numberOfTemplates / 2] = {quarter * 0.78f, quarter * 0.87f, quarter * 0.74f, quarter};
+
+    // Top row lies still, bottom row moves to the right and wraps around
+    std::vector<SyntheticCoin> coins;
+    for (int i = 0; i < numberOfTemplates / 2; i++) {
+        int templateIndex = i * 2 + (i % 2);
+        coins.push_back({templateIndex, cv::Point2f(frameSize.width * (i + 1) / 5.0f, frameSize.height * 0.3f),
+                         diameters[i], 30.0f * i, cv::Point2f(0.0f, 0.0f)});
+    }
+    for (int i = 0; i < 3; i++) {
+        int templateIndex = (i * 3 + 1) % numberOfTemplates;
+        coins.push_back({templateIndex, cv::Point2f(frameSize.width * i / 3.0f, frameSize.height * 0.72f),
+                         diameters[templateIndex / 2], 75.0f * i, cv::Point2f(frameSize.width / 240.0f, 0.0f)});
+    }
+
+    cv::Mat frame(frameSize, CV_8UC3);
+    for (int frameIndex = 0; frameIndex < numFrames; frameIndex++) {
+        frame.setTo(cv::Scalar(70, 80, 85));
+
+        for (const SyntheticCoin &coin : coins) {
+            cv::Point2f centre = coin.centre + coin.velocity * (float) frameIndex;
+
+            // Moving coins leave on the right and come back in on the left
+            float span = frameSize.width + coin.diameter;
+            centre.x = std::fmod(centre.x + coin.diameter / 2.0f, span);
+            if (centre.x < 0) {
+                centre.x += span;
+            }
+            centre.x -= coin.diameter / 2.0f;
+
+            drawSyntheticCoin(templateBank, coin, centre, frame);
+        }
+        writer.write(frame);
+    }
+    return true;
+}
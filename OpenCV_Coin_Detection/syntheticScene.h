@@ -0,0 +1,87 @@
+//==============================================================================
+// SyntheticScene
+//------------------------------------------------------------------------------
+// Draws coins made from the template images onto a plain background, so the 
+// program can be run offline on scenes whose contents are known. The 
+// synthetic conveyor video has a row of coins lying still and a row of coins
+// moving across the frame and wrapping around, which exercises both the 
+// reuse of tracked classifications and the classification of new coins.
+//
+// renderSyntheticScene draws still scenes for the benchmarks 
+// (coinBenchmark.cpp): a number of coins at random sizes, rotations and 
+// brightnesses, not touching, on a background with uneven lighting and 
+// sensor noise. Every random choice comes from the scene's seed, so the same
+// settings always give the same image on every machine.
+//==============================================================================
+
+#ifndef SYNTHETIC_SCENE_H
+#define SYNTHETIC_SCENE_H
+
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "templateBank.h"
+
+
+struct SyntheticCoin {
+    int templateIndex;          // template drawn, a CoinTemplate
+    cv::Point2f centre;         // centre in the first frame
+    float diameter;
+    float angle;                // rotation of the template in degrees
+    cv::Point2f velocity;       // pixels moved per frame
+    float brightness{1.0f};     // gain applied to the template's pixels
+};
+
+
+struct SceneSettings {
+    cv::Size size{1920, 1080};
+    int numCoins{12};
+    unsigned int seed{1};
+    float minDiameter{0.06f};   // smallest coin, as a fraction of the shorter side
+    float maxDiameter{0.18f};   // largest coin, as a fraction of the shorter side
+    bool trueScale{false};      // coins keep the size ratios of real US coins, at one random scale per scene
+    float lighting{0.25f};      // largest change in brightness across the scene from uneven lighting
+    float noise{4.0f};          // standard deviation of the sensor noise in grey levels
+};
+
+
+/*------------------------------ drawSyntheticCoin -----------------------------
+ * Precondition:  templateBank has been loaded.
+ * Postcondition: The template of coin, resized to its diameter and rotated by
+ *                its angle, and scaled by its brightness, is drawn on scene as
+ *                a disc centred on centre. Any part of the disc outside scene
+ *                is clipped.
+ */
+void drawSyntheticCoin(const TemplateBank &templateBank, const SyntheticCoin &coin, cv::Point2f centre,
+                       cv::Mat &scene);
+
+
+/*---------------------------- renderSyntheticScene ----------------------------
+ * Precondition:  templateBank has been loaded. 0 < settings.minDiameter <= 
+ *                settings.maxDiameter < 1.
+ * Postcondition: Returns a settings.size BGR image of up to settings.numCoins
+ *                coins, each a random template at a random diameter, angle and
+ *                brightness (or with settings.trueScale, at the diameter of
+ *                its coin at a random scale for the scene), placed wholly 
+ *                inside the image and apart from 
+ *                every other coin, under a lighting gradient and noise. coins
+ *                holds the coins drawn, fewer than asked if no free place was
+ *                found for the rest. The same settings always give the same 
+ *                image and coins.
+ */
+cv::Mat renderSyntheticScene(const TemplateBank &templateBank, const SceneSettings &settings,
+                             std::vector<SyntheticCoin> &coins);
+
+
+/*----------------------------- writeSyntheticVideo ----------------------------
+ * Precondition:  templateBank has been loaded.
+ * Postcondition: Writes numFrames frames of a synthetic conveyor to path as an
+ *                MJPG video at 30 frames per second. Returns false if the 
+ *                video could not be opened for writing.
+ */
+bool writeSyntheticVideo(const std::string &path, const TemplateBank &templateBank, int numFrames,
+                         cv::Size frameSize = cv::Size(1280, 720));
+
+#endif
@@ -0,0 +1,210 @@
+#include <cmath>
+
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include "templateBank.h"
+#include "chamferMatcher.h"
+#include "imageUtilities.h"
+#include "polarMatcher.h"
+
+
+const char *const templateFileNames[numberOfTemplates] = {
+        "pennyHeads.jpg", "pennyTails.jpg", "nickelHeads.jpg", "nickelTails.jpg",
+        "dimeHeads.jpg", "dimeTails.jpg", "quarterHeads.jpg", "quarterTails.jpg"
+};
+
+const char *const coinNames[numberOfTemplates] = {
+        "Penny (Heads Up)", "Penny (Tails Up)", "Nickel (Heads Up)", "Nickel (Tails Up)",
+        "Dime (Heads Up)", "Dime (Tails Up)", "Quarter (Heads Up)", "Quarter (Tails Up)"
+};
+
+const double coinValues[numberOfTemplates] = {0.01, 0.01, 0.05, 0.05, 0.10, 0.10, 0.25, 0.25};
+
+const double coinDiametersMm[numberOfTemplates] = {19.05, 19.05, 21.21, 21.21, 17.91, 17.91, 24.26, 24.26};
+
+
+/* TemplateBank
+ * Precondition: templateDirectory contains the 8 images named in templateFileNames.
+ * Postcondition: The templates and edge maps are mapped from an up to date compiled file if useCompiledFile is set
+ *                and there is one, otherwise every template is read once and its edge maps are built at each
+ *                quantized size and rotation.
+ */
+TemplateBank::TemplateBank(const std::string &templateDirectory, int minSize, int maxSize, double sizeStep,
+                           int degreeIncrement, bool useCompiledFile)
+        : rotationStep(degreeIncrement), smallestSize(minSize), largestSize(maxSize), sizeRatio(sizeStep) {
+
+    readSourceChecksums(templateDirectory);
+
+    std::string problem;
+    if (useCompiledFile) {
+        std::string compiledPath = templateDirectory + compiledTemplateFileName;
+        if (loadCompiledFile(compiledPath, problem)) {
+            source = "mapped " + compiledPath;
+            return;
+        }
+    } else {
+        problem = "compiled file not used";
+    }
+    source = problem + ", decoded the template images";
+
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        templateImages[currentCoin] = cv::imread(templateDirectory + templateFileNames[currentCoin]);
+        if (templateImages[currentCoin].empty()) {
+            return;
+        }
+    }
+
+    // Build the ladder of quantized sizes, always ending with maxSize
+    std::vector<int> sizes;
+    for (double size = minSize; size < maxSize; size *= sizeStep) {
+        int roundedSize = (int) std::round(size);
+        if (sizes.empty() || roundedSize > sizes.back()) {
+            sizes.push_back(roundedSize);
+        }
+    }
+    if (sizes.empty() || sizes.back() != maxSize) {
+        sizes.push_back(maxSize);
+    }
+
+    scales.resize(sizes.size());
+    for (int currentScale = 0; currentScale < (int) sizes.size(); currentScale++) {
+        scales[currentScale].size = sizes[currentScale];
+        scales[currentScale].numRowBlocks =
+                (sizes[currentScale] + PackedEdgeImage::rowBlock - 1) / PackedEdgeImage::rowBlock;
+    }
+    const int rotationCount = numRotations();
+
+    // Every (scale, template) pair is independent, so build them in parallel
+    cv::parallel_for_(cv::Range(0, (int) sizes.size() * numberOfTemplates), [&](const cv::Range &range) {
+        for (int job = range.start; job < range.end; job++) {
+            Scale &scale = scales[job / numberOfTemplates];
+            int currentCoin = job % numberOfTemplates;
+
+            //  Resize template coin to the quantized patch size and create its edge image
+            cv::Mat resizedCoin;
+            cv::resize(templateImages[currentCoin], resizedCoin, cv::Size(scale.size, scale.size), 0, 0,
+                       cv::INTER_AREA);
+
+            cv::Mat templateEdges;
+            createEdgeImage(resizedCoin, templateEdges);
+            scale.numEdges[currentCoin] = findNumberOfEdges(templateEdges);
+            scale.edges[currentCoin] = templateEdges;
+
+            //  Polar spectrum around the rotation centre for the polar matcher
+            createPolarSpectrum(templateEdges, cv::Point2f((float) (templateEdges.cols / 2),
+                                                           (float) (templateEdges.rows / 2)),
+                                true, scale.polarSpectra[currentCoin]);
+
+            //  Store every rotation of the template edge image, packed one bit per pixel, along with the
+            //  downsampled rotation and its edge count per block of rows for the coarse-to-fine matcher
+            cv::Mat coarseTemplate;
+            downsampleEdgeImage(templateEdges, coarseTemplate);
+            scale.coarseNumEdges[currentCoin] = findNumberOfEdges(coarseTemplate);
+
+            std::vector<PackedEdgeImage> &rotations = scale.rotations[currentCoin];
+            std::vector<PackedEdgeImage> &coarseRotations = scale.coarseRotations[currentCoin];
+            rotations.resize(rotationCount);
+            coarseRotations.resize(rotationCount);
+            scale.remainingEdges[currentCoin] = cv::Mat::zeros(rotationCount, scale.numRowBlocks + 1, CV_32SC1);
+
+            //  The edge pixels of every rotation, one list after another, for the chamfer matcher
+            const bool listEdgePoints = scale.size <= chamferStride;
+            std::vector<uint16_t> edgePoints;
+            std::vector<int> edgePointStarts(1, 0);
+
+            cv::Mat rotatedTemplate;
+            for (int countIndex = 0; countIndex < rotationCount; countIndex++) {
+                cv::Mat rotationMat = cv::getRotationMatrix2D(cv::Point(templateEdges.cols / 2,
+                                                                        templateEdges.rows / 2),
+                                                              countIndex * rotationStep, 1.0);
+                cv::warpAffine(templateEdges, rotatedTemplate, rotationMat, templateEdges.size());
+                rotations[countIndex].pack(rotatedTemplate);
+
+                downsampleEdgeImage(rotatedTemplate, coarseTemplate);
+                coarseRotations[countIndex].pack(coarseTemplate);
+
+                if (listEdgePoints) {
+                    appendEdgePoints(rotatedTemplate, edgePoints);
+                    edgePointStarts.push_back((int) edgePoints.size());
+                }
+
+                int *remaining = scale.remainingEdges[currentCoin].ptr<int>(countIndex);
+                for (int block = scale.numRowBlocks - 1; block >= 0; block--) {
+                    int firstRow = block * PackedEdgeImage::rowBlock;
+                    int endRow = std::min(firstRow + PackedEdgeImage::rowBlock, scale.size);
+                    remaining[block] = remaining[block + 1] + countMatchingEdges(rotations[countIndex],
+                                                                                  rotations[countIndex],
+                                                                                  firstRow, endRow);
+                }
+            }
+            if (listEdgePoints) {
+                scale.edgePoints[currentCoin] = cv::Mat(edgePoints, true);
+                scale.edgePointStarts[currentCoin] = cv::Mat(edgePointStarts, true);
+            }
+        }
+    });
+}
+
+
+/* loaded
+ * Precondition: None
+ * Postcondition: Returns true if all 8 templates were read.
+ */
+bool TemplateBank::loaded() const {
+    return !scales.empty();
+}
+
+
+/* nearestScale
+ * Precondition: loaded() is true and patchSize is greater than 0.
+ * Postcondition: Returns the Scale whose size has the smallest ratio difference to patchSize.
+ */
+const TemplateBank::Scale &TemplateBank::nearestScale(int patchSize) const {
+    int bestScale = 0;
+    double bestDistance = std::abs(std::log((double) patchSize / scales[0].size));
+    for (int currentScale = 1; currentScale < (int) scales.size(); currentScale++) {
+        double distance = std::abs(std::log((double) patchSize / scales[currentScale].size));
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            bestScale = currentScale;
+        }
+    }
+    return scales[bestScale];
+}
+
+
+/* degreeIncrement
+ * Precondition: None
+ * Postcondition: Returns the angle between consecutive rotations.
+ */
+int TemplateBank::degreeIncrement() const {
+    return rotationStep;
+}
+
+
+/* numRotations
+ * Precondition: None
+ * Postcondition: Returns the number of rotations stored per template.
+ */
+int TemplateBank::numRotations() const {
+    return 360 / rotationStep;
+}
+
+
+/* templateImage
+ * Precondition: 0 <= templateIndex < numberOfTemplates
+ * Postcondition: Returns the decoded template image.
+ */
+const cv::Mat &TemplateBank::templateImage(int templateIndex) const {
+    return templateImages[templateIndex];
+}
+
+
+/* sourceDescription
+ * Precondition: None
+ * Postcondition: Returns which compiled file was mapped, or why none was.
+ */
+const std::string &TemplateBank::sourceDescription() const {
+    return source;
+}
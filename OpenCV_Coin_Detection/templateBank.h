@@ -0,0 +1,193 @@
+//==============================================================================
+// TemplateBank
+//------------------------------------------------------------------------------
+// Holds the 8 template coin images together with their edge maps, precomputed
+// once at a ladder of quantized patch sizes and at every rotation tried by the
+// matcher. The edge maps are stored bit-packed (see packedEdgeImage.h). 
+// findCoins resizes each patch to the nearest size in the ladder and compares
+// it against these edge maps instead of rebuilding them per contour.
+//
+// A TemplateBank is never modified after it is constructed, so one instance 
+// can be shared read-only by every thread processing an image.
+//
+// Building the edge maps means decoding the templates and resizing, edge 
+// detecting and rotating each of them hundreds of times, which dominates the
+// start of a short run. TemplateCompiler (templateCompiler.cpp) saves a built
+// bank to a versioned binary file in the template directory. The constructor 
+// maps that file read-only and reads the edge maps in place instead, so they 
+// are shared by every thread and by every process that maps the same file. 
+// The file is ignored, and the bank built from the images, when it is 
+// missing, corrupt (its checksum does not match), made by another file 
+// version or with other sizes and rotations, or stale (a template image has 
+// changed since it was compiled).
+//==============================================================================
+
+#ifndef TEMPLATE_BANK_H
+#define TEMPLATE_BANK_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "mappedFile.h"
+#include "packedEdgeImage.h"
+
+
+// Coin Templates
+const int numberOfTemplates{8};
+
+enum CoinTemplate {
+    pennyHeads = 0, pennyTails, nickelHeads, nickelTails,
+    dimeHeads, dimeTails, quarterHeads, quarterTails
+};
+
+// Mask of templates with bit t set for CoinTemplate t, used to skip coin types ruled out by the size prior
+const unsigned int allTemplates{(1u << numberOfTemplates) - 1};
+
+// File name, label and value in dollars of each template, indexed by CoinTemplate
+extern const char *const templateFileNames[numberOfTemplates];
+extern const char *const coinNames[numberOfTemplates];
+extern const double coinValues[numberOfTemplates];
+
+// Diameter in millimetres of the coin of each template, indexed by CoinTemplate
+extern const double coinDiametersMm[numberOfTemplates];
+
+// Compiled bank looked for in the template directory
+const char compiledTemplateFileName[] = "templates.bank";
+
+
+class TemplateBank {
+public:
+
+    // Edge maps of every template at one quantized patch size
+    struct Scale {
+        int size{0};                                                 // side length of the square edge maps
+        int numEdges[numberOfTemplates]{};                           // edge pixels in the unrotated template
+        cv::Mat edges[numberOfTemplates];                            // unrotated edge image, CV_8UC1
+        std::vector<PackedEdgeImage> rotations[numberOfTemplates];   // [template][k] is rotated k * degreeIncrement
+        cv::Mat polarSpectra[numberOfTemplates];                     // radius weighted, see polarMatcher.h
+
+        // For the coarse-to-fine matcher, see coarseToFineMatcher.h
+        int coarseNumEdges[numberOfTemplates]{};                     // edge pixels in the unrotated coarse template
+        std::vector<PackedEdgeImage> coarseRotations[numberOfTemplates];  // rotations downsampled 2x
+        cv::Mat remainingEdges[numberOfTemplates];                   // CV_32SC1, (k, b) is the edge pixels of
+                                                                     // rotation k in row blocks >= b
+        int numRowBlocks{0};                                         // blocks of PackedEdgeImage::rowBlock rows
+
+        // For the chamfer matcher, see chamferMatcher.h. Empty for sizes above chamferStride.
+        cv::Mat edgePoints[numberOfTemplates];                       // CV_16UC1 column, the edge pixel offsets of
+                                                                     // every rotation in turn
+        cv::Mat edgePointStarts[numberOfTemplates];                  // CV_32SC1 column of numRotations() + 1,
+                                                                     // rotation k is points [k] to [k + 1]
+    };
+
+    /*------------------------------- TemplateBank -----------------------------
+     * Precondition:  templateDirectory contains the 8 images named in 
+     *                templateFileNames. 0 < minSize <= maxSize, sizeStep > 1 and
+     *                degreeIncrement divides 360.
+     * Postcondition: Each template is read once. For every size from minSize to
+     *                maxSize growing by a factor of sizeStep, the template is 
+     *                resized to size x size, its edge image is created and then 
+     *                rotated by every multiple of degreeIncrement, and its 
+     *                polar spectrum and the edge points of every rotation are
+     *                stored for the polar and chamfer matchers. If any 
+     *                template cannot be read, loaded() returns false and no 
+     *                scales are built. If useCompiledFile is set and 
+     *                templateDirectory holds an up to date compiled file made
+     *                with the same sizes and rotations, the templates and 
+     *                edge maps are mapped from it instead.
+     */
+    explicit TemplateBank(const std::string &templateDirectory, int minSize = 32, int maxSize = 256,
+                          double sizeStep = 1.15, int degreeIncrement = 5, bool useCompiledFile = true);
+
+    /*----------------------------------- loaded -------------------------------
+     * Precondition:  None
+     * Postcondition: Returns true if all 8 templates were read successfully.
+     */
+    bool loaded() const;
+
+    /*-------------------------------- nearestScale ----------------------------
+     * Precondition:  loaded() is true and patchSize is greater than 0.
+     * Postcondition: Returns the precomputed Scale whose size is closest to 
+     *                patchSize, measured as a ratio so that small and large 
+     *                patches are treated alike.
+     */
+    const Scale &nearestScale(int patchSize) const;
+
+    /*------------------------------ degreeIncrement ---------------------------
+     * Precondition:  None
+     * Postcondition: Returns the angle in degrees between consecutive rotations.
+     */
+    int degreeIncrement() const;
+
+    /*-------------------------------- numRotations ----------------------------
+     * Precondition:  None
+     * Postcondition: Returns the number of rotations stored per template.
+     */
+    int numRotations() const;
+
+    /*------------------------------- templateImage ----------------------------
+     * Precondition:  0 <= templateIndex < numberOfTemplates
+     * Postcondition: Returns the decoded colour template image.
+     */
+    const cv::Mat &templateImage(int templateIndex) const;
+
+    /*------------------------------------ save --------------------------------
+     * Precondition:  loaded() is true.
+     * Postcondition: Writes the templates and every edge map, with the sizes,
+     *                rotations, file version, a checksum of each template 
+     *                image file and a checksum of the data, to path. The file
+     *                is written beside path and renamed over it, so processes
+     *                mapping the old file are not disturbed. Returns false if
+     *                it cannot be written.
+     */
+    bool save(const std::string &path) const;
+
+    /*----------------------------- sourceDescription --------------------------
+     * Precondition:  None
+     * Postcondition: Returns how the bank was loaded: which compiled file was
+     *                mapped, or why none was and the images were decoded.
+     */
+    const std::string &sourceDescription() const;
+
+private:
+
+    /*--------------------------- readSourceChecksums --------------------------
+     * Precondition:  None
+     * Postcondition: sourceChecksums holds a checksum of every template image
+     *                file in templateDirectory, and sourceFound whether it 
+     *                could be read.
+     */
+    void readSourceChecksums(const std::string &templateDirectory);
+
+    /*----------------------------- loadCompiledFile ---------------------------
+     * Precondition:  readSourceChecksums has run. smallestSize, largestSize,
+     *                sizeRatio and rotationStep are set.
+     * Postcondition: Maps the compiled bank at path and fills in the template
+     *                images and scales from it, returning true. Returns false
+     *                with the reason in problem, leaving the bank unloaded, if
+     *                the file is missing, corrupt, stale or was made with 
+     *                other settings.
+     */
+    bool loadCompiledFile(const std::string &path, std::string &problem);
+
+    cv::Mat templateImages[numberOfTemplates];
+    std::vector<Scale> scales;
+    int rotationStep;
+
+    // Sizes the scales were built with, kept so a compiled file can be checked against them
+    int smallestSize;
+    int largestSize;
+    double sizeRatio;
+
+    uint64_t sourceChecksums[numberOfTemplates]{};
+    bool sourceFound[numberOfTemplates]{};
+
+    std::shared_ptr<MappedFile> mappedFile;     // compiled bank the edge maps are read from, if any
+    std::string source;
+};
+
+#endif
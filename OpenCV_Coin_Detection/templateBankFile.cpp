@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "templateBank.h"
+
+
+// Bump whenever the edge maps (createEdgeImage, the rotations, the polar spectra, the edge points) or the layout
+// below change, so files compiled by an older build are rebuilt instead of read
+const uint32_t compiledTemplateVersion{4};
+
+const char compiledTemplateMagic[8] = {'C', 'O', 'I', 'N', 'B', 'A', 'N', 'K'};
+
+// Arrays start on a cache line, which is also the alignment the packed kernels prefer
+const size_t arrayAlignment{64};
+
+
+// Start of a compiled bank. Multi-byte values are stored in the byte order of the machine that compiled the file.
+struct CompiledTemplateHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;                            // sizeof(CompiledTemplateHeader), catches other struct layouts
+    int32_t minSize;
+    int32_t maxSize;
+    double sizeStep;
+    int32_t degreeIncrement;
+    int32_t numScales;
+    uint64_t sourceChecksums[numberOfTemplates];    // checksum of each template image file it was built from
+    uint64_t payloadSize;                           // bytes after payloadOffset
+    uint64_t payloadChecksum;
+};
+
+// The data follows the header at this offset
+const size_t payloadOffset{256};
+static_assert(sizeof(CompiledTemplateHeader) <= payloadOffset, "header must fit before the payload");
+
+
+/* checksumBytes
+ * Precondition: data points to size readable bytes.
+ * Postcondition: Returns a 64-bit FNV-1a style checksum of the bytes, taken a word at a time so checking a whole
+ *                bank stays a small part of loading it.
+ */
+static uint64_t checksumBytes(const unsigned char *data, size_t size) {
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t checksum = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        checksum = (checksum ^ word) * prime;
+    }
+    for (; i < size; i++) {
+        checksum = (checksum ^ data[i]) * prime;
+    }
+    return checksum;
+}
+
+
+// Appends the parts of a compiled bank to a byte buffer
+struct BankWriter {
+    std::vector<unsigned char> bytes;
+
+    void putBytes(const void *data, size_t size, size_t alignment) {
+        bytes.resize((bytes.size() + alignment - 1) / alignment * alignment, 0);
+        const unsigned char *first = (const unsigned char *) data;
+        bytes.insert(bytes.end(), first, first + size);
+    }
+
+    void putInt(int32_t value) {
+        putBytes(&value, sizeof(value), sizeof(value));
+    }
+
+    void putMat(const cv::Mat &mat) {
+        cv::Mat continuous = mat.isContinuous() ? mat : mat.clone();
+        putInt(continuous.rows);
+        putInt(continuous.cols);
+        putInt(continuous.type());
+        putBytes(continuous.data, continuous.total() * continuous.elemSize(), arrayAlignment);
+    }
+
+    void putPacked(const PackedEdgeImage &packed) {
+        putInt(packed.rows());
+        putInt(packed.cols());
+        putBytes(packed.data(), packed.numWords() * sizeof(uint64_t), arrayAlignment);
+    }
+};
+
+
+// Reads the parts of a compiled bank in place, in the order BankWriter appended them
+struct BankReader {
+    const unsigned char *data;
+    size_t size;
+    size_t offset;
+    bool failed;
+
+    const unsigned char *takeBytes(size_t count, size_t alignment) {
+        size_t start = (offset + alignment - 1) / alignment * alignment;
+        if (failed || start > size || count > size - start) {
+            failed = true;
+            return nullptr;
+        }
+        offset = start + count;
+        return data + start;
+    }
+
+    int32_t takeInt() {
+        int32_t value = 0;
+        const unsigned char *bytes = takeBytes(sizeof(value), sizeof(value));
+        if (bytes != nullptr) {
+            std::memcpy(&value, bytes, sizeof(value));
+        }
+        return value;
+    }
+
+    // A Mat header over the file, nothing is copied
+    cv::Mat takeMat() {
+        int rows = takeInt();
+        int cols = takeInt();
+        int type = takeInt();
+        if (failed || rows < 0 || cols < 0 || type < 0 || CV_MAT_CN(type) > 4) {
+            failed = true;
+            return cv::Mat();
+        }
+        size_t elemSize = (size_t) CV_MAT_CN(type) * CV_ELEM_SIZE1(type);
+        const unsigned char *bytes = takeBytes((size_t) rows * cols * elemSize, arrayAlignment);
+        return bytes == nullptr ? cv::Mat() : cv::Mat(rows, cols, type, (void *) bytes);
+    }
+
+    PackedEdgeImage takePacked() {
+        int rows = takeInt();
+        int cols = takeInt();
+        if (failed || rows < 0 || cols < 0) {
+            failed = true;
+            return PackedEdgeImage();
+        }
+        const unsigned char *bytes = takeBytes(PackedEdgeImage::numWordsFor(rows, cols) * sizeof(uint64_t),
+                                               arrayAlignment);
+        return bytes == nullptr ? PackedEdgeImage() : PackedEdgeImage(rows, cols, (const uint64_t *) bytes);
+    }
+};
+
+
+/* edgePointsValid
+ * Precondition: None
+ * Postcondition: Returns true if starts and points are both empty, or if starts is a CV_32SC1 column of
+ *                rotationCount + 1 rising offsets from 0 to the length of points, a CV_16UC1 column.
+ */
+static bool edgePointsValid(const cv::Mat &starts, const cv::Mat &points, int rotationCount) {
+    if (starts.empty()) {
+        return points.empty();
+    }
+    if (starts.type() != CV_32SC1 || starts.rows != rotationCount + 1 || starts.cols != 1 ||
+        (!points.empty() && (points.type() != CV_16UC1 || points.cols != 1))) {
+        return false;
+    }
+    const int *offsets = starts.ptr<int>();
+    for (int countIndex = 0; countIndex < rotationCount; countIndex++) {
+        if (offsets[countIndex] > offsets[countIndex + 1]) {
+            return false;
+        }
+    }
+    return offsets[0] == 0 && (size_t) offsets[rotationCount] == points.total();
+}
+
+
+/* readSourceChecksums
+ * Precondition: None
+ * Postcondition: sourceChecksums holds the checksum of every template image file that could be read.
+ */
+void TemplateBank::readSourceChecksums(const std::string &templateDirectory) {
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        std::ifstream file(templateDirectory + templateFileNames[currentCoin], std::ios::binary);
+        sourceFound[currentCoin] = (bool) file;
+        if (!file) {
+            continue;
+        }
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        sourceChecksums[currentCoin] = checksumBytes(bytes.data(), bytes.size());
+    }
+}
+
+
+/* loadCompiledFile
+ * Precondition: readSourceChecksums has run and the size settings are set.
+ * Postcondition: Returns true with the templates and scales read in place from the mapped file at path, or false
+ *                with the reason in problem.
+ */
+bool TemplateBank::loadCompiledFile(const std::string &path, std::string &problem) {
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    if (!file->open(path)) {
+        problem = "no compiled templates at " + path;
+        return false;
+    }
+
+    CompiledTemplateHeader header;
+    if (file->size() < payloadOffset) {
+        problem = path + " is truncated";
+        return false;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, compiledTemplateMagic, sizeof(header.magic)) != 0 ||
+        header.headerSize != sizeof(CompiledTemplateHeader)) {
+        problem = path + " is not a compiled template bank";
+        return false;
+    }
+    if (header.version != compiledTemplateVersion) {
+        problem = path + " is version " + std::to_string(header.version) + ", expected " +
+                  std::to_string(compiledTemplateVersion);
+        return false;
+    }
+    if (header.minSize != smallestSize || header.maxSize != largestSize || header.sizeStep != sizeRatio ||
+        header.degreeIncrement != rotationStep || header.numScales <= 0) {
+        problem = path + " was compiled with other sizes or rotations";
+        return false;
+    }
+
+    // A missing image cannot make the file stale, so a directory holding only the compiled file still loads
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        if (sourceFound[currentCoin] && header.sourceChecksums[currentCoin] != sourceChecksums[currentCoin]) {
+            problem = path + " is stale, " + templateFileNames[currentCoin] + " changed since it was compiled";
+            return false;
+        }
+    }
+
+    if (header.payloadSize != file->size() - payloadOffset ||
+        checksumBytes(file->data() + payloadOffset, (size_t) header.payloadSize) != header.payloadChecksum) {
+        problem = path + " is corrupt";
+        return false;
+    }
+
+    /*------------------ Read the templates and every scale in place ------------------*/
+    BankReader reader{file->data(), file->size(), payloadOffset, false};
+    cv::Mat images[numberOfTemplates];
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        images[currentCoin] = reader.takeMat();
+    }
+
+    const int rotationCount = numRotations();
+    std::vector<Scale> mappedScales(header.numScales);
+    for (Scale &scale : mappedScales) {
+        scale.size = reader.takeInt();
+        scale.numRowBlocks = reader.takeInt();
+
+        for (int currentCoin = 0; currentCoin < numberOfTemplates && !reader.failed; currentCoin++) {
+            scale.numEdges[currentCoin] = reader.takeInt();
+            scale.coarseNumEdges[currentCoin] = reader.takeInt();
+            scale.edges[currentCoin] = reader.takeMat();
+            scale.polarSpectra[currentCoin] = reader.takeMat();
+
+            scale.remainingEdges[currentCoin] = reader.takeMat();
+            const cv::Mat &remaining = scale.remainingEdges[currentCoin];
+            if (remaining.rows != rotationCount || remaining.cols != scale.numRowBlocks + 1 ||
+                remaining.type() != CV_32SC1) {
+                reader.failed = true;
+            }
+
+            scale.edgePointStarts[currentCoin] = reader.takeMat();
+            scale.edgePoints[currentCoin] = reader.takeMat();
+            if (!edgePointsValid(scale.edgePointStarts[currentCoin], scale.edgePoints[currentCoin], rotationCount)) {
+                reader.failed = true;
+            }
+
+            scale.rotations[currentCoin].reserve(rotationCount);
+            scale.coarseRotations[currentCoin].reserve(rotationCount);
+            for (int countIndex = 0; countIndex < rotationCount; countIndex++) {
+                scale.rotations[currentCoin].push_back(reader.takePacked());
+            }
+            for (int countIndex = 0; countIndex < rotationCount; countIndex++) {
+                scale.coarseRotations[currentCoin].push_back(reader.takePacked());
+            }
+        }
+    }
+    if (reader.failed || reader.offset != file->size()) {
+        problem = path + " is corrupt";
+        return false;
+    }
+
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        templateImages[currentCoin] = images[currentCoin];
+    }
+    scales = std::move(mappedScales);
+    mappedFile = file;
+    return true;
+}
+
+
+/* save
+ * Precondition: loaded() is true.
+ * Postcondition: The templates and every scale are written to path, replacing it. Returns false if they cannot be.
+ */
+bool TemplateBank::save(const std::string &path) const {
+    BankWriter writer;
+    writer.bytes.resize(payloadOffset, 0);
+
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        writer.putMat(templateImages[currentCoin]);
+    }
+    for (const Scale &scale : scales) {
+        writer.putInt(scale.size);
+        writer.putInt(scale.numRowBlocks);
+
+        for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+            writer.putInt(scale.numEdges[currentCoin]);
+            writer.putInt(scale.coarseNumEdges[currentCoin]);
+            writer.putMat(scale.edges[currentCoin]);
+            writer.putMat(scale.polarSpectra[currentCoin]);
+
+            writer.putMat(scale.remainingEdges[currentCoin]);
+
+            writer.putMat(scale.edgePointStarts[currentCoin]);
+            writer.putMat(scale.edgePoints[currentCoin]);
+
+            for (const PackedEdgeImage &rotation : scale.rotations[currentCoin]) {
+                writer.putPacked(rotation);
+            }
+            for (const PackedEdgeImage &rotation : scale.coarseRotations[currentCoin]) {
+                writer.putPacked(rotation);
+            }
+        }
+    }
+
+    CompiledTemplateHeader header{};
+    std::memcpy(header.magic, compiledTemplateMagic, sizeof(header.magic));
+    header.version = compiledTemplateVersion;
+    header.headerSize = sizeof(CompiledTemplateHeader);
+    header.minSize = smallestSize;
+    header.maxSize = largestSize;
+    header.sizeStep = sizeRatio;
+    header.degreeIncrement = rotationStep;
+    header.numScales = (int32_t) scales.size();
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        header.sourceChecksums[currentCoin] = sourceChecksums[currentCoin];
+    }
+    header.payloadSize = writer.bytes.size() - payloadOffset;
+    header.payloadChecksum = checksumBytes(writer.bytes.data() + payloadOffset, (size_t) header.payloadSize);
+    std::memcpy(writer.bytes.data(), &header, sizeof(header));
+
+    // Write beside path and rename, so a process mapping the old file keeps reading it undisturbed
+    std::string partialPath = path + ".partial";
+    {
+        std::ofstream file(partialPath, std::ios::binary | std::ios::trunc);
+        file.write((const char *) writer.bytes.data(), (std::streamsize) writer.bytes.size());
+        if (!file) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(partialPath, path, error);
+    if (error) {
+        std::filesystem::remove(partialPath, error);
+        return false;
+    }
+    return true;
+}
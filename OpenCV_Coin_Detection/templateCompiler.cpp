@@ -0,0 +1,54 @@
+//==============================================================================
+// Template Compiler
+//------------------------------------------------------------------------------
+// Offline tool that builds the TemplateBank from the 8 template images once 
+// and saves it, so the detector can map the edge maps at start up instead of
+// decoding the images and rebuilding them (see templateBank.h). Run it again
+// whenever a template image changes; until then the detector notices the 
+// compiled file is stale and falls back to the images.
+//
+// Usage: TemplateCompiler [templateDirectory] [outputFile]
+//
+// templateDirectory defaults to "Template Images/" and outputFile to the 
+// compiled file the detector looks for in it.
+//==============================================================================
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "templateBank.h"
+
+
+/*------------------------------------ main ------------------------------------
+ * Precondition:  The template directory holds the 8 images named in 
+ *                templateFileNames.
+ * Postcondition: The compiled template bank is written to the output file. 
+ *                Returns -1 if the images cannot be read or the file cannot 
+ *                be written.
+ */
+int main(int argc, char *argv[]) {
+
+    std::string templateDirectory = argc > 1 ? argv[1] : "Template Images/";
+    if (!templateDirectory.empty() && templateDirectory.back() != '/' && templateDirectory.back() != '\\') {
+        templateDirectory += '/';
+    }
+    const std::string outputFile = argc > 2 ? argv[2] : templateDirectory + compiledTemplateFileName;
+
+    // Always build from the images, never from a compiled file that may be stale. The sizes and rotations are
+    // the TemplateBank defaults the detector loads with
+    const TemplateBank templateBank(templateDirectory, 32, 256, 1.15, 5, false);
+    if (!templateBank.loaded()) {
+        std::cout << "Could not read the 8 template images from " << templateDirectory << std::endl;
+        return -1;
+    }
+
+    if (!templateBank.save(outputFile)) {
+        std::cout << "Could not write " << outputFile << std::endl;
+        return -1;
+    }
+    std::cout << "Compiled " << numberOfTemplates << " templates at " << templateBank.numRotations()
+              << " rotations into " << outputFile << " (" << std::filesystem::file_size(outputFile) << " bytes)"
+              << std::endl;
+    return 0;
+}
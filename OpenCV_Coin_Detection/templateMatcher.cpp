@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#include "templateMatcher.h"
+#include "imageUtilities.h"
+#include "polarMatcher.h"
+#include "coarseToFineMatcher.h"
+#include "chamferMatcher.h"
+
+
+/* matchTemplateRotations
+ * Precondition: scale belongs to templateBank and patchEdges was packed from a scale.size x scale.size edge image.
+ * Postcondition: Returns the best percentage of matching edges and its rotation for template templateIndex, over
+ *                every angleStep-th rotation.
+ */
+TemplateMatch matchTemplateRotations(const TemplateBank &templateBank, const TemplateBank::Scale &scale,
+                                     int templateIndex, const PackedEdgeImage &patchEdges, int angleStep) {
+    TemplateMatch bestMatch;
+    const int numTemplateEdges = scale.numEdges[templateIndex];
+    const std::vector<PackedEdgeImage> &templateRotations = scale.rotations[templateIndex];
+
+    for (int countIndex = 0; countIndex < (int) templateRotations.size(); countIndex += angleStep) {
+        int rotationMatchCount = countMatchingEdges(templateRotations[countIndex], patchEdges);
+
+        //Find the percentage of matching edges for this rotation
+        double rotationMatchPercent = ((double) rotationMatchCount / (double) numTemplateEdges) * 100.0;
+
+        if (rotationMatchPercent > bestMatch.percent) {
+            //Save the highest percentage of matches
+            bestMatch.percent = rotationMatchPercent;
+            bestMatch.degrees = countIndex * templateBank.degreeIncrement();
+        }
+    }
+    return bestMatch;
+}
+
+
+/* matchTemplateRotationsReference
+ * Precondition: scale belongs to templateBank and patchEdges is a scale.size x scale.size edge image.
+ * Postcondition: Returns the same result as matchTemplateRotations, comparing one byte per pixel.
+ */
+TemplateMatch matchTemplateRotationsReference(const TemplateBank &templateBank, const TemplateBank::Scale &scale,
+                                              int templateIndex, const cv::Mat &patchEdges, int angleStep) {
+    TemplateMatch bestMatch;
+    const int numTemplateEdges = scale.numEdges[templateIndex];
+    const std::vector<PackedEdgeImage> &templateRotations = scale.rotations[templateIndex];
+    cv::Mat rotatedTemplate;
+
+    for (int countIndex = 0; countIndex < (int) templateRotations.size(); countIndex += angleStep) {
+        templateRotations[countIndex].unpack(rotatedTemplate);
+        int rotationMatchCount = countMatchingEdges(rotatedTemplate, patchEdges);
+
+        //Find the percentage of matching edges for this rotation
+        double rotationMatchPercent = ((double) rotationMatchCount / (double) numTemplateEdges) * 100.0;
+
+        if (rotationMatchPercent > bestMatch.percent) {
+            //Save the highest percentage of matches
+            bestMatch.percent = rotationMatchPercent;
+            bestMatch.degrees = countIndex * templateBank.degreeIncrement();
+        }
+    }
+    return bestMatch;
+}
+
+
+/* matchTemplates
+ * Precondition: scale belongs to templateBank and patch holds the forms of the patch edge image matcher needs.
+ * Postcondition: matches[t] is assigned the best rotation and percentage of matching edges for template t, or an
+ *                empty inexact match if t is not in templateMask. Returns the number of full size template x rotation
+ *                edge counts run.
+ */
+int matchTemplates(const TemplateBank &templateBank, const TemplateBank::Scale &scale, MatcherType matcher,
+                   const PatchEdges &patch, TemplateMatch matches[numberOfTemplates], int angleStep,
+                   int templatesRefined, unsigned int templateMask) {
+    if (matcher == MatcherType::coarseToFine) {
+        return matchCoarseToFine(templateBank, scale, patch, matches, angleStep, templatesRefined, templateMask);
+    }
+
+    int numMatched = 0;
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        // Coin types the size prior ruled out are never compared
+        if (!(templateMask & (1u << currentCoin))) {
+            matches[currentCoin] = TemplateMatch();
+            matches[currentCoin].exact = false;
+            continue;
+        }
+        numMatched++;
+
+        switch (matcher) {
+            case MatcherType::packed:
+            case MatcherType::batched:      // a single patch is matched like packed, see batchedClassifier.h
+                matches[currentCoin] = matchTemplateRotations(templateBank, scale, currentCoin, patch.packed,
+                                                              angleStep);
+                break;
+            case MatcherType::reference:
+                matches[currentCoin] = matchTemplateRotationsReference(templateBank, scale, currentCoin, patch.edges,
+                                                                       angleStep);
+                break;
+            case MatcherType::polar:
+                matches[currentCoin] = matchTemplatePolar(scale, currentCoin, patch.polarSpectrum, patch.edges);
+                break;
+            case MatcherType::chamfer:
+                // A bank built with templates larger than chamferStride has no edge points at those sizes
+                matches[currentCoin] = scale.edgePointStarts[currentCoin].empty()
+                                       ? matchTemplateRotations(templateBank, scale, currentCoin, patch.packed,
+                                                                angleStep)
+                                       : matchTemplateChamfer(templateBank, scale, currentCoin, patch.chamferWeights,
+                                                              angleStep);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // The polar matcher only counts edges at its peak angle and the two either side
+    int rotationsTried = (templateBank.numRotations() + angleStep - 1) / angleStep;
+    return numMatched * (matcher == MatcherType::polar ? 3 : rotationsTried);
+}
+
+
+/* coinThreshold
+ * Precondition: None
+ * Postcondition: Returns chamferMatchThreshold if matcher scores scale with the chamfer score, else
+ *                coinMatchThreshold.
+ */
+double coinThreshold(MatcherType matcher, const TemplateBank::Scale &scale) {
+    // Scales without edge points fall back to the exact count, see matchTemplates
+    return matcher == MatcherType::chamfer && scale.size <= chamferStride ? chamferMatchThreshold : coinMatchThreshold;
+}
+
+
+/* chooseBestTemplate
+ * Precondition: matches holds numberOfTemplates results for the patch of candidate.
+ * Postcondition: Steps 5 and 6 of findCoins. candidate takes the best template's rotation and percentage, and is a
+ *                coin if that is above threshold.
+ */
+void chooseBestTemplate(const TemplateMatch matches[numberOfTemplates], CoinDetection &candidate,
+                        double threshold) {
+
+    /*-----------------------Step 5: Determine which template gave the best match----------------------*/
+    //Find which coin type and orientation (heads/tails) gave the best match count
+    for (int voteIndex = 0; voteIndex < numberOfTemplates; voteIndex++) {
+        if (matches[voteIndex].percent > candidate.matchPercent) {
+            candidate.matchPercent = matches[voteIndex].percent;
+            candidate.rotationDegrees = matches[voteIndex].degrees;
+            candidate.templateIndex = voteIndex;
+        }
+    }
+
+    /*-------------------Step 6: Determine which type of Coin it is-------------------------*/
+    // if more than 38% of the edges match (or the chamfer score passes its own threshold), then its a coin
+    candidate.isCoin = candidate.matchPercent > threshold;
+}
+
+
+/* bestTemplate
+ * Precondition: matches holds numberOfTemplates results.
+ * Postcondition: Returns the index of the template with the highest percentage, the first one on ties.
+ */
+static int bestTemplate(const TemplateMatch matches[numberOfTemplates]) {
+    int best = 0;
+    for (int currentCoin = 1; currentCoin < numberOfTemplates; currentCoin++) {
+        if (matches[currentCoin].percent > matches[best].percent) {
+            best = currentCoin;
+        }
+    }
+    return best;
+}
+
+
+/* describeMatcherDifferences
+ * Precondition: selected and bruteForce each hold numberOfTemplates results for the same patch.
+ * Postcondition: Returns a line for every template and decision on which the two matchers disagree.
+ */
+std::string describeMatcherDifferences(const TemplateMatch selected[numberOfTemplates],
+                                       const TemplateMatch bruteForce[numberOfTemplates], int angleTolerance,
+                                       double selectedThreshold) {
+    std::stringstream report;
+
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        int angleDifference = std::abs(selected[currentCoin].degrees - bruteForce[currentCoin].degrees) % 360;
+        angleDifference = std::min(angleDifference, 360 - angleDifference);
+
+        bool differs = selected[currentCoin].exact && (angleDifference > angleTolerance ||
+                       (angleTolerance == 0 && selected[currentCoin].percent != bruteForce[currentCoin].percent));
+        if (differs) {
+            report << "  " << templateFileNames[currentCoin] << ": " << selected[currentCoin].percent << "% at "
+                   << selected[currentCoin].degrees << " deg, brute force " << bruteForce[currentCoin].percent
+                   << "% at " << bruteForce[currentCoin].degrees << " deg" << std::endl;
+        }
+    }
+
+    int selectedBest = bestTemplate(selected);
+    int bruteForceBest = bestTemplate(bruteForce);
+    if (selectedBest != bruteForceBest) {
+        report << "  best template " << templateFileNames[selectedBest] << ", brute force "
+               << templateFileNames[bruteForceBest] << std::endl;
+    }
+    if ((selected[selectedBest].percent > selectedThreshold) !=
+        (bruteForce[bruteForceBest].percent > coinMatchThreshold)) {
+        report << "  coin decision differs" << std::endl;
+    }
+    return report.str();
+}
@@ -0,0 +1,121 @@
+//==============================================================================
+// Template Matcher
+//------------------------------------------------------------------------------
+// Step 4.3 of findCoins: tries every stored rotation of one template against 
+// the edge image of a patch and keeps the rotation with the highest percentage
+// of template edges that land on patch edges. matchTemplates runs whichever 
+// matcher DetectionSettings selects over all 8 templates.
+//==============================================================================
+
+#ifndef TEMPLATE_MATCHER_H
+#define TEMPLATE_MATCHER_H
+
+#include <string>
+
+#include "opencv2/core.hpp"
+
+#include "coinDetection.h"
+#include "detectionSettings.h"
+#include "packedEdgeImage.h"
+#include "templateBank.h"
+
+
+// A patch is a coin if more than this percentage of the best template's edges match
+const double coinMatchThreshold{38.0};
+
+
+// Best rotation of one template against a patch
+struct TemplateMatch {
+    double percent{0.0};    // percentage of the template's edges that matched the patch, chamfer score for chamfer
+    int degrees{0};         // rotation of the template that gave percent
+    bool exact{true};       // false if the search gave up early and percent is only a lower bound
+};
+
+
+// A patch edge image in the forms the matchers work on
+struct PatchEdges {
+    cv::Mat edges;              // CV_8UC1 edge image, scale.size x scale.size
+    PackedEdgeImage packed;     // edges packed one bit per pixel
+    PackedEdgeImage coarse;     // edges downsampled 2x and packed, only needed by MatcherType::coarseToFine
+    cv::Mat polarSpectrum;      // polar spectrum around the coin centre, only needed by MatcherType::polar
+    cv::Mat chamferWeights;     // scale.size rows of chamferStride bytes, only needed by MatcherType::chamfer
+};
+
+
+/*--------------------------- matchTemplateRotations ---------------------------
+ * Precondition:  scale belongs to templateBank and patchEdges has been packed 
+ *                from a scale.size x scale.size edge image. angleStep > 0.
+ * Postcondition: Returns the highest percentage of matching edges over every 
+ *                angleStep-th rotation of template templateIndex, using the 
+ *                packed kernel.
+ */
+TemplateMatch matchTemplateRotations(const TemplateBank &templateBank, const TemplateBank::Scale &scale,
+                                     int templateIndex, const PackedEdgeImage &patchEdges, int angleStep = 1);
+
+
+/*----------------------- matchTemplateRotationsReference ----------------------
+ * Precondition:  scale belongs to templateBank and patchEdges is a 
+ *                scale.size x scale.size edge image.
+ * Postcondition: Same result as matchTemplateRotations, computed one byte per 
+ *                pixel. Kept as the reference the packed path is checked 
+ *                against.
+ */
+TemplateMatch matchTemplateRotationsReference(const TemplateBank &templateBank, const TemplateBank::Scale &scale,
+                                              int templateIndex, const cv::Mat &patchEdges, int angleStep = 1);
+
+
+
+/*------------------------------- matchTemplates -------------------------------
+ * Precondition:  scale belongs to templateBank and patch holds the forms of 
+ *                the patch edge image that matcher needs.
+ * Postcondition: matches[t] is assigned the best rotation and percentage of 
+ *                matching edges for template t, found by matcher. Returns 
+ *                the number of full size template x rotation edge counts the
+ *                matcher ran. angleStep and templatesRefined are the 
+ *                DetectionSettings of the same names; the polar matcher 
+ *                ignores both. Templates not in templateMask are skipped and
+ *                keep an empty, inexact match.
+ */
+int matchTemplates(const TemplateBank &templateBank, const TemplateBank::Scale &scale, MatcherType matcher,
+                   const PatchEdges &patch, TemplateMatch matches[numberOfTemplates], int angleStep = 1,
+                   int templatesRefined = 0, unsigned int templateMask = allTemplates);
+
+
+/*------------------------------- coinThreshold --------------------------------
+ * Precondition:  None
+ * Postcondition: Returns the percentage a patch's best match on scale with
+ *                matcher must be above to be a coin: chamferMatchThreshold 
+ *                for chamfer scores, which are only computed at scales with
+ *                edge points, and coinMatchThreshold for every exact count.
+ */
+double coinThreshold(MatcherType matcher, const TemplateBank::Scale &scale);
+
+
+/*----------------------------- chooseBestTemplate -----------------------------
+ * Precondition:  matches holds numberOfTemplates results for the patch of 
+ *                candidate, and candidate has not been classified yet.
+ *                threshold is coinThreshold for the matcher that made them.
+ * Postcondition: Steps 5 and 6 of findCoins. The candidate's templateIndex, 
+ *                matchPercent and rotationDegrees are those of the template 
+ *                with the highest percentage (the first one on ties), and 
+ *                isCoin is set if it is above threshold.
+ */
+void chooseBestTemplate(const TemplateMatch matches[numberOfTemplates], CoinDetection &candidate,
+                        double threshold = coinMatchThreshold);
+
+
+/*------------------------- describeMatcherDifferences -------------------------
+ * Precondition:  selected and bruteForce each hold numberOfTemplates results 
+ *                for the same patch, bruteForce exact counts. A selected 
+ *                match is a coin above selectedThreshold.
+ * Postcondition: Returns one line for every exact template whose best angle 
+ *                differs by more than angleTolerance degrees, or whose 
+ *                percentage differs when angleTolerance is 0, plus a line if the winning 
+ *                template or the coin decision changed. Returns an empty 
+ *                string when the matchers agree.
+ */
+std::string describeMatcherDifferences(const TemplateMatch selected[numberOfTemplates],
+                                       const TemplateMatch bruteForce[numberOfTemplates], int angleTolerance,
+                                       double selectedThreshold = coinMatchThreshold);
+
+#endif
@@ -0,0 +1,102 @@
+//==============================================================================
+// testCoinTracker
+//------------------------------------------------------------------------------
+// Feeds a CoinTracker twelve frames of made up candidates: two coins moving
+// across the frame, one lying still that drops out after three frames, one
+// that appears in the fifth frame, and one that appears where the dropped
+// coin was after the tracker has forgotten it. Checks that each coin keeps
+// its trackId, that a new coin gets a new one, that classification results
+// are reused between classifications, and that each coin is classified
+// again exactly every reclassifyInterval frames.
+//==============================================================================
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "coinTracker.h"
+#include "templateBank.h"
+#include "testSupport.h"
+#include "workerPool.h"
+
+
+struct TestCoin {
+    std::string name;
+    int firstFrame;             // first frame the coin is in
+    int endFrame;               // frame after the last one it is in
+    cv::Point2f start;          // centre in its first frame
+    cv::Point2f velocity;       // pixels moved per frame
+    float diameter;
+    int trackId;                // trackId the tracker should give it
+};
+
+
+int main() {
+    const int numFrames = 12;
+    TrackerSettings settings;
+    settings.maxMissedFrames = 2;
+    settings.reclassifyInterval = 3;
+
+    // Moving coins stay well inside positionTolerance diameters a frame
+    const std::vector<TestCoin> coins = {
+            {"moving A", 0, numFrames, {100, 100}, {5, 0}, 40, 0},
+            {"moving B", 0, numFrames, {300, 100}, {8, 2}, 60, 1},
+            {"dropped C", 0, 3, {500, 300}, {0, 0}, 50, 2},
+            {"new D", 4, numFrames, {700, 400}, {-3, 0}, 45, 3},
+            {"returning E", 10, numFrames, {500, 300}, {0, 0}, 50, 4}};
+
+    // Candidates classified in each frame: everything at first, then each coin every third frame after it appears
+    const int expectedClassified[numFrames] = {3, 0, 0, 2, 1, 0, 2, 1, 0, 2, 2, 0};
+    const std::map<int, int> expectedClassifications = {{0, 4}, {1, 4}, {2, 1}, {3, 3}, {4, 1}};
+
+    WorkerPool workerPool(2);
+    CoinTracker tracker(settings);
+    std::mutex classifiedMutex;
+    std::map<int, int> classifications;
+
+    for (int frame = 0; frame < numFrames; frame++) {
+        std::vector<CoinDetection> candidates;
+        std::vector<const TestCoin *> coinOfCandidate;
+        for (const TestCoin &coin : coins) {
+            if (frame < coin.firstFrame || frame >= coin.endFrame) {
+                continue;
+            }
+            CoinDetection candidate;
+            candidate.contourIndex = (int) candidates.size();
+            candidate.ellipse = cv::RotatedRect(coin.start + coin.velocity * (double) (frame - coin.firstFrame),
+                                                cv::Size2f(coin.diameter, coin.diameter), 0.0f);
+            candidates.push_back(candidate);
+            coinOfCandidate.push_back(&coin);
+        }
+
+        std::vector<CoinDetection> tracked = tracker.track(candidates, workerPool, [&](CoinDetection &candidate) {
+            // A classification every later frame of the coin should reuse until the next one
+            candidate.isCoin = true;
+            candidate.templateIndex = candidate.trackId % numberOfTemplates;
+            std::lock_guard<std::mutex> lock(classifiedMutex);
+            classifications[candidate.trackId]++;
+        });
+
+        std::string at = " in frame " + std::to_string(frame);
+        if (!expect(tracked.size() == candidates.size(), "candidates lost" + at)) {
+            continue;
+        }
+        for (size_t i = 0; i < tracked.size(); i++) {
+            const TestCoin &coin = *coinOfCandidate[i];
+            expect(tracked[i].trackId == coin.trackId, coin.name + " has trackId " +
+                                                       std::to_string(tracked[i].trackId) + at);
+            expect(tracked[i].isCoin && tracked[i].templateIndex == coin.trackId % numberOfTemplates,
+                   coin.name + " did not keep its classification" + at);
+        }
+        expect(tracker.classifiedLastFrame() == expectedClassified[frame],
+               std::to_string(tracker.classifiedLastFrame()) + " candidates classified" + at);
+        expect(tracker.reusedLastFrame() == (int) candidates.size() - expectedClassified[frame],
+               std::to_string(tracker.reusedLastFrame()) + " classifications reused" + at);
+    }
+
+    expect(classifications == expectedClassifications, "coins were not classified every reclassifyInterval frames");
+    return testResult("testCoinTracker");
+}
@@ -0,0 +1,100 @@
+//==============================================================================
+// testDetectionServer
+//------------------------------------------------------------------------------
+// Runs the detection server on a thread, listening on a socket in the temp
+// directory, and talks to it the way the client does: sends the bytes of a
+// test image, a malformed request and a statistics request over one
+// connection. Checks that the image is answered with its detection record,
+// the malformed request with an error that leaves the connection open, and
+// the statistics with both requests counted. Then stops the server and
+// checks that it returns 0 and removes its socket file. Skipped where Unix
+// domain sockets are not supported.
+//==============================================================================
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "coinDetector.h"
+#include "detectionServer.h"
+#include "socketMessage.h"
+#include "templateBank.h"
+#include "testSupport.h"
+#include "workerPool.h"
+
+
+/* sendRequest
+ * Precondition: socketFd is connected to the server.
+ * Postcondition: Returns the response to request, or an empty string after counting a failure if it could not be
+ *                sent or read.
+ */
+std::string sendRequest(int socketFd, const std::string &request, const std::string &what) {
+    std::string response;
+    expect(writeMessage(socketFd, request) && readMessage(socketFd, response), "no response to the " + what);
+    return response;
+}
+
+
+int main() {
+#ifdef _WIN32
+    std::cout << "testDetectionServer: Unix domain sockets are not supported here, skipped" << std::endl;
+    return 0;
+#else
+    const TemplateBank templateBank("Template Images/");
+    if (!expect(templateBank.loaded(), "could not load the templates")) {
+        return testResult("testDetectionServer");
+    }
+    std::ifstream imageFile("Test Images/coins2.jpg", std::ios::binary);
+    std::string imageBytes((std::istreambuf_iterator<char>(imageFile)), std::istreambuf_iterator<char>());
+    if (!expect(!imageBytes.empty(), "could not read Test Images/coins2.jpg")) {
+        return testResult("testDetectionServer");
+    }
+
+    WorkerPool workerPool;
+    const CoinDetector detector(templateBank, workerPool, DetectionSettings());
+    ServerSettings settings;
+    settings.socketPath = (std::filesystem::temp_directory_path() /
+                           ("testDetectionServer" + std::to_string(getpid()) + ".sock")).string();
+
+    int serverResult = -1;
+    std::thread server([&]() { serverResult = runDetectionServer(detector, settings); });
+
+    // The server starts listening on its own thread, give it up to five seconds
+    int socketFd = -1;
+    for (int attempt = 0; attempt < 100 && socketFd < 0; attempt++) {
+        socketFd = connectToServer(settings.socketPath);
+        if (socketFd < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+
+    if (expect(socketFd >= 0, "could not connect to " + settings.socketPath)) {
+        std::string record = sendRequest(socketFd, imageRequest + imageBytes, "image");
+        expect(record.find("\"error\"") == std::string::npos, "image answered with " + record);
+        expect(record.rfind("{\"image\":\"request\"", 0) == 0 && record.find("\"coins\":[") != std::string::npos,
+               "image not answered with its detection record: " + record);
+
+        std::string error = sendRequest(socketFd, "X", "malformed request");
+        expect(error.rfind("{\"error\":", 0) == 0, "malformed request answered with " + error);
+
+        std::string stats = sendRequest(socketFd, std::string(1, statsRequest), "statistics request");
+        expect(stats.find("\"requests\":2,\"failed\":1,") != std::string::npos,
+               "statistics do not count the two requests: " + stats);
+        closeSocket(socketFd);
+    }
+
+    stopDetectionServer();
+    server.join();
+    expect(serverResult == 0, "server returned " + std::to_string(serverResult));
+    expect(!std::filesystem::exists(settings.socketPath), "server left " + settings.socketPath + " behind");
+
+    return testResult("testDetectionServer");
+#endif
+}
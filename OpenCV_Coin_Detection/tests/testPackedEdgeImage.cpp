@@ -0,0 +1,139 @@
+//==============================================================================
+// testPackedEdgeImage
+//------------------------------------------------------------------------------
+// Packs random edge images and real ones (templates and test images through
+// createEdgeImage) and checks that every popcount kernel the CPU supports
+// counts the same matching edges as the byte-per-pixel countMatchingEdges,
+// over the whole image and over every row range whose ends lie on rowBlock
+// boundaries (or the last row).
+//==============================================================================
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include "imageUtilities.h"
+#include "packedEdgeImage.h"
+#include "templateBank.h"
+#include "testSupport.h"
+
+
+const PopcountKernel kernels[] = {PopcountKernel::scalar, PopcountKernel::avx2, PopcountKernel::avx512};
+const char *const kernelNames[] = {"scalar", "avx2", "avx512"};
+
+
+/* randomEdgeImage
+ * Precondition: rows and cols are greater than 0, 0 <= density <= 1.
+ * Postcondition: Returns a CV_8UC1 image of 0 and 255 with about density of its pixels 255.
+ */
+cv::Mat randomEdgeImage(cv::RNG &rng, int rows, int cols, double density) {
+    cv::Mat noise(rows, cols, CV_8UC1);
+    rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+    return noise < density * 256.0;
+}
+
+
+/* loadEdgeImage
+ * Precondition: None
+ * Postcondition: Returns the edge image of the image at path resized to size, or an empty image if it could not
+ *                be read.
+ */
+cv::Mat loadEdgeImage(const std::string &path, cv::Size size) {
+    cv::Mat colorImage = cv::imread(path);
+    cv::Mat edgeImage;
+    if (expect(!colorImage.empty(), "could not read " + path)) {
+        cv::resize(colorImage, colorImage, size, 0, 0, cv::INTER_AREA);
+        createEdgeImage(colorImage, edgeImage);
+    }
+    return edgeImage;
+}
+
+
+/* checkCounts
+ * Precondition: first and second are CV_8UC1 images of the same size.
+ * Postcondition: Every supported kernel has been checked against the byte count over the whole image and every
+ *                row range [firstRow, endRow) allowed by countMatchingEdges. Failures are reported under name.
+ */
+void checkCounts(const std::string &name, const cv::Mat &first, const cv::Mat &second) {
+    const int rowBlock = PackedEdgeImage::rowBlock;
+    const int numBlocks = (first.rows + rowBlock - 1) / rowBlock;
+
+    // Byte counts of the rows before each block boundary, so any range is a difference of two
+    std::vector<int> rowsBefore(numBlocks + 1, 0);
+    for (int block = 0; block < numBlocks; block++) {
+        int endRow = std::min(first.rows, (block + 1) * rowBlock);
+        rowsBefore[block + 1] = rowsBefore[block] + countMatchingEdges(first.rowRange(block * rowBlock, endRow),
+                                                                       second.rowRange(block * rowBlock, endRow));
+    }
+    expect(rowsBefore[numBlocks] == countMatchingEdges(first, second), name + ": block sums differ from the image");
+
+    PackedEdgeImage packedFirst(first);
+    PackedEdgeImage packedSecond(second);
+    PackedEdgeImage inPlaceFirst(first.rows, first.cols, packedFirst.data());
+    expect(countMatchingEdges(packedFirst, packedSecond) == rowsBefore[numBlocks], name + ": default kernel");
+    expect(countMatchingEdges(inPlaceFirst, packedSecond) == rowsBefore[numBlocks], name + ": words read in place");
+
+    for (int k = 0; k < (int) (sizeof(kernels) / sizeof(kernels[0])); k++) {
+        if (!popcountKernelSupported(kernels[k])) {
+            std::cout << name << ": " << kernelNames[k] << " kernel not supported, skipped" << std::endl;
+            continue;
+        }
+        int rangeFailures = 0;
+        for (int firstBlock = 0; firstBlock < numBlocks; firstBlock++) {
+            for (int endBlock = firstBlock + 1; endBlock <= numBlocks; endBlock++) {
+                int endRow = std::min(first.rows, endBlock * rowBlock);
+                int count = countMatchingEdges(packedFirst, packedSecond, firstBlock * rowBlock, endRow, kernels[k]);
+                if (count != rowsBefore[endBlock] - rowsBefore[firstBlock]) {
+                    rangeFailures++;
+                }
+            }
+        }
+        expect(rangeFailures == 0, name + ": " + kernelNames[k] + " kernel differs on " +
+                                   std::to_string(rangeFailures) + " row range(s)");
+    }
+}
+
+
+int main() {
+    cv::RNG rng(2024);
+
+    // Sizes either side of a word, of a rowBlock and of the 512 bit padding
+    const cv::Size randomSizes[] = {{1, 1}, {63, 7}, {64, 8}, {65, 9}, {128, 16}, {129, 17}, {100, 100},
+                                    {300, 257}, {511, 40}, {513, 33}};
+    const double densities[] = {0.0, 0.05, 0.5, 1.0};
+    for (const cv::Size &size : randomSizes) {
+        for (double density : densities) {
+            std::string name = "random " + std::to_string(size.width) + "x" + std::to_string(size.height) +
+                               " at " + std::to_string(density);
+            checkCounts(name, randomEdgeImage(rng, size.height, size.width, density),
+                        randomEdgeImage(rng, size.height, size.width, 0.3));
+        }
+    }
+
+    // Each template against the next, at template sizes that do and do not fill whole words
+    const int templateSizes[] = {57, 128, 201};
+    for (int templateSize : templateSizes) {
+        for (int t = 0; t < numberOfTemplates; t++) {
+            cv::Size size(templateSize, templateSize);
+            cv::Mat first = loadEdgeImage(std::string("Template Images/") + templateFileNames[t], size);
+            cv::Mat second = loadEdgeImage(std::string("Template Images/") +
+                                           templateFileNames[(t + 1) % numberOfTemplates], size);
+            if (!first.empty() && !second.empty()) {
+                checkCounts(std::string(templateFileNames[t]) + " at " + std::to_string(templateSize), first,
+                            second);
+            }
+        }
+    }
+
+    cv::Mat firstScene = loadEdgeImage("Test Images/coins2.jpg", cv::Size(640, 483));
+    cv::Mat secondScene = loadEdgeImage("Test Images/coins3.jpg", cv::Size(640, 483));
+    if (!firstScene.empty() && !secondScene.empty()) {
+        checkCounts("coins2.jpg against coins3.jpg", firstScene, secondScene);
+    }
+
+    return testResult("testPackedEdgeImage");
+}
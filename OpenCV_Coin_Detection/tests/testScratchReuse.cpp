@@ -0,0 +1,113 @@
+//==============================================================================
+// testScratchReuse
+//------------------------------------------------------------------------------
+// Classifies every candidate of every image under "Test Images/" twice on
+// one thread, with each matcher that works in the DetectionScratch buffers
+// (packed, coarse-to-fine and chamfer). The first pass grows the buffers to
+// the largest patch; the test fails if any buffer grows in the second pass.
+//
+// That is all it asserts. Classifying a candidate is not allocation free:
+// cv::resize, cv::Canny and cv::distanceTransform allocate temporaries of
+// their own. Global operator new is counted here so the test also prints the
+// heap allocations per candidate left in the second pass, for comparison
+// between runs.
+//==============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "detectionScratch.h"
+#include "findCoins.h"
+#include "imageDecoder.h"
+#include "imagePipeline.h"
+#include "imageUtilities.h"
+#include "templateBank.h"
+#include "testSupport.h"
+
+
+// Calls to operator new by any thread since the program started
+static std::atomic<long> heapAllocations(0);
+
+
+void *operator new(std::size_t size) {
+    heapAllocations++;
+    if (void *memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+
+void operator delete(void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+
+int main() {
+    const TemplateBank templateBank("Template Images/");
+    if (!expect(templateBank.loaded(), "could not load the templates")) {
+        return testResult("testScratchReuse");
+    }
+
+    // Decode and find the candidates once, only the classification is measured
+    std::vector<cv::Mat> images;
+    std::vector<std::vector<CoinDetection>> candidates;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator("Test Images")) {
+        std::string path = entry.path().string();
+        if (entry.is_directory() || !isInputImage(path)) {
+            continue;
+        }
+        cv::Mat image = decodeImage(path, maxSourceDimension);
+        if (!expect(!image.empty(), "could not read " + path)) {
+            continue;
+        }
+        resizeSourceImage(image, image, maxSourceDimension);
+        images.push_back(image);
+        candidates.push_back(findCandidates(image, DetectionSettings()));
+    }
+    expect(!images.empty(), "no images in Test Images/");
+
+    const MatcherType matchers[] = {MatcherType::packed, MatcherType::coarseToFine, MatcherType::chamfer};
+    const char *const matcherNames[] = {"packed", "coarse", "chamfer"};
+    for (int m = 0; m < (int) (sizeof(matchers) / sizeof(matchers[0])); m++) {
+        DetectionSettings settings;
+        settings.matcher = matchers[m];
+
+        long grownBefore = 0;
+        long allocationsBefore = 0;
+        int numClassified = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            grownBefore = DetectionScratch::buffersGrown();
+            allocationsBefore = heapAllocations;
+            numClassified = 0;
+            for (size_t imageIndex = 0; imageIndex < images.size(); imageIndex++) {
+                for (const CoinDetection &found : candidates[imageIndex]) {
+                    CoinDetection candidate = found;
+                    classifyCandidate(templateBank, settings, images[imageIndex], candidate);
+                    numClassified++;
+                }
+            }
+        }
+        long grown = DetectionScratch::buffersGrown() - grownBefore;
+        long allocations = heapAllocations - allocationsBefore;
+
+        std::cout << matcherNames[m] << ": " << numClassified << " candidates classified again, scratch buffers grew "
+                  << grown << " times, " << (double) allocations / std::max(numClassified, 1)
+                  << " heap allocations per candidate" << std::endl;
+        expect(grown == 0, std::string(matcherNames[m]) + ": scratch buffers grew in the second pass");
+    }
+
+    return testResult("testScratchReuse");
+}
@@ -0,0 +1,52 @@
+//==============================================================================
+// Test Support
+//------------------------------------------------------------------------------
+// The tests are plain programs run by CTest from OpenCV_Coin_Detection/, so
+// they find "Template Images/" and "Test Images/" the way the program does.
+// Each records its failed checks with expect and returns testResult from
+// main, which is 0 only if every check passed.
+//==============================================================================
+
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <iostream>
+#include <string>
+
+
+// Checks failed so far by this test program
+inline int &testFailures() {
+    static int failures{0};
+    return failures;
+}
+
+
+/*----------------------------------- expect -----------------------------------
+ * Precondition:  None
+ * Postcondition: If condition is false, what is printed and counted as a
+ *                failure. Returns condition.
+ */
+inline bool expect(bool condition, const std::string &what) {
+    if (!condition) {
+        std::cout << "FAILED: " << what << std::endl;
+        testFailures()++;
+    }
+    return condition;
+}
+
+
+/*--------------------------------- testResult ---------------------------------
+ * Precondition:  None
+ * Postcondition: Prints whether testName passed and returns the exit code for
+ *                main, 0 if no check failed and 1 otherwise.
+ */
+inline int testResult(const std::string &testName) {
+    if (testFailures() > 0) {
+        std::cout << testName << ": " << testFailures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << testName << ": passed" << std::endl;
+    return 0;
+}
+
+#endif
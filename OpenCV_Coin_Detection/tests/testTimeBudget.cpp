@@ -0,0 +1,107 @@
+//==============================================================================
+// testTimeBudget
+//------------------------------------------------------------------------------
+// Detects crowded synthetic scenes with a time budget and checks that the
+// budget is kept: 45 scenes of 4032 x 3024, each with 60 small coins, the
+// slowest case for every step. The first 5 warm up the cost estimates and
+// are not counted, and at least 95% of the other 40 must finish within the
+// budget. Prints the latency percentiles, the quality levels used and the
+// coins found.
+//
+// The budget is 200 ms, the interactive endpoint's, or the number of 
+// milliseconds given as the first argument. It has not been validated on any
+// machine yet: the test was written without an OpenCV build to run it on.
+// Record the machine it first passes on and the p95 it measured here, and 
+// give slower machines a larger budget. It passes or fails on wall time, so 
+// CTest only runs it when CMake is configured with -DCOIN_TIMING_TESTS=ON.
+//==============================================================================
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "adaptiveQuality.h"
+#include "coinDetector.h"
+#include "findCoins.h"
+#include "imageUtilities.h"
+#include "latencySummary.h"
+#include "syntheticScene.h"
+#include "templateBank.h"
+#include "testSupport.h"
+#include "workerPool.h"
+
+
+// Scenes detected before the latencies are counted, while the cost estimates settle
+const int warmUpScenes{5};
+const int countedScenes{40};
+const int coinsPerScene{60};
+
+
+int main(int argc, char *argv[]) {
+    DetectionSettings settings;
+    settings.timeBudgetMs = argc > 1 ? std::atof(argv[1]) : 200.0;
+    if (!expect(settings.timeBudgetMs > 0.0, "the budget must be a positive number of milliseconds")) {
+        return testResult("testTimeBudget");
+    }
+    const TemplateBank templateBank("Template Images/");
+    if (!expect(templateBank.loaded(), "could not load the templates")) {
+        return testResult("testTimeBudget");
+    }
+    WorkerPool workerPool;
+    const CoinDetector detector(templateBank, workerPool, settings);
+
+    // A 12 megapixel phone photo of a table covered in small coins
+    SceneSettings scene;
+    scene.size = cv::Size(4032, 3024);
+    scene.numCoins = coinsPerScene;
+    scene.minDiameter = 0.04f;
+    scene.maxDiameter = 0.08f;
+
+    std::vector<double> latenciesMs;
+    int levelCounts[numberOfQualityLevels] = {0};
+    long coinsPlaced = 0;
+    long coinsFound = 0;
+    for (int sceneIndex = 0; sceneIndex < warmUpScenes + countedScenes; sceneIndex++) {
+        scene.seed = (unsigned int) sceneIndex + 1;
+        std::vector<SyntheticCoin> coins;
+        cv::Mat image = renderSyntheticScene(templateBank, scene, coins);
+
+        // Detected at the same working size as the command line tool
+        cv::Mat sourceImg = image;
+        resizeSourceImage(image, sourceImg, maxSourceDimension);
+        DetectionQuality quality;
+        std::vector<CoinDetection> detections = detector.detect(sourceImg, quality);
+        if (sceneIndex < warmUpScenes) {
+            continue;
+        }
+
+        latenciesMs.push_back(quality.elapsedMs);
+        levelCounts[quality.level]++;
+        coinsPlaced += (long) coins.size();
+        coinsFound += std::count_if(detections.begin(), detections.end(),
+                                    [](const CoinDetection &candidate) { return candidate.isCoin; });
+    }
+
+    long withinBudget = std::count_if(latenciesMs.begin(), latenciesMs.end(),
+                                      [&](double ms) { return ms <= settings.timeBudgetMs; });
+    LatencySummary summary = summarizeLatencies(latenciesMs);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << summary.count << " scenes of " << coinsPerScene << " coins at " << scene.size.width << " x "
+              << scene.size.height << " with a budget of " << settings.timeBudgetMs << " ms" << std::endl
+              << "  latency mean " << summary.meanMs << " ms, p50 " << summary.p50Ms << ", p95 " << summary.p95Ms
+              << ", max " << summary.maxMs << ", " << withinBudget << " within budget" << std::endl
+              << "  coins found " << coinsFound << " of " << coinsPlaced << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    for (int level = 0; level < numberOfQualityLevels; level++) {
+        std::cout << "  quality " << qualityLevels[level].name << ": " << levelCounts[level] << " scenes" << std::endl;
+    }
+
+    expect(withinBudget * 100 >= (long) latenciesMs.size() * 95,
+           std::to_string(withinBudget) + " of " + std::to_string(latenciesMs.size()) + " scenes within budget");
+    return testResult("testTimeBudget");
+}
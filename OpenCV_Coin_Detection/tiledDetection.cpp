@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cmath>
+
+#include "tiledDetection.h"
+#include "findCoins.h"
+
+
+/* tileStarts
+ * Precondition: tileSize > tileOverlap >= 0
+ * Postcondition: Returns the first pixel of each tile along an image side of length length. The last tile ends on
+ *                the image border, and consecutive tiles overlap by at least tileOverlap pixels.
+ */
+static std::vector<int> tileStarts(int length, int tileSize, int tileOverlap) {
+    std::vector<int> starts;
+    const int step = tileSize - tileOverlap;
+    for (int start = 0;; start += step) {
+        if (start + tileSize >= length) {
+            starts.push_back(std::max(0, length - tileSize));
+            break;
+        }
+        starts.push_back(start);
+    }
+    return starts;
+}
+
+
+/* ellipseOverlap
+ * Precondition: None
+ * Postcondition: Returns the intersection over union of the two ellipses as circles of their mean radius.
+ */
+double ellipseOverlap(const cv::RotatedRect &a, const cv::RotatedRect &b) {
+    double radiusA = (a.size.width + a.size.height) / 4.0;
+    double radiusB = (b.size.width + b.size.height) / 4.0;
+    cv::Point2f offset = a.center - b.center;
+    double distance = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+
+    double areaA = CV_PI * radiusA * radiusA;
+    double areaB = CV_PI * radiusB * radiusB;
+    double intersection;
+    if (distance >= radiusA + radiusB) {
+        return 0.0;
+    } else if (distance <= std::abs(radiusA - radiusB)) {
+        intersection = std::min(areaA, areaB);
+    } else {
+        // Area of the lens where the two circles cross
+        double angleA = std::acos((distance * distance + radiusA * radiusA - radiusB * radiusB) /
+                                  (2.0 * distance * radiusA));
+        double angleB = std::acos((distance * distance + radiusB * radiusB - radiusA * radiusA) /
+                                  (2.0 * distance * radiusB));
+        intersection = radiusA * radiusA * (angleA - std::sin(2.0 * angleA) / 2.0) +
+                       radiusB * radiusB * (angleB - std::sin(2.0 * angleB) / 2.0);
+    }
+    return intersection / (areaA + areaB - intersection);
+}
+
+
+/* detectCoinsTiled
+ * Precondition: sourceImg is valid, settings.tileSize > settings.tileOverlap and templateBank has been loaded.
+ * Postcondition: Returns the merged detections of every tile in sourceImg coordinates.
+ */
+std::vector<CoinDetection> detectCoinsTiled(WorkerPool &workerPool, const TemplateBank &templateBank,
+                                            const DetectionSettings &settings, const cv::Mat &sourceImg) {
+
+    // A candidate this close to an inner tile side was cut by it
+    const int borderMargin{2};
+
+    // Ellipses overlapping more than this are the same coin found by two tiles
+    const double sameCoinOverlap{0.5};
+
+    std::vector<cv::Rect> tiles;
+    for (int y : tileStarts(sourceImg.rows, settings.tileSize, settings.tileOverlap)) {
+        for (int x : tileStarts(sourceImg.cols, settings.tileSize, settings.tileOverlap)) {
+            tiles.push_back(cv::Rect(x, y, std::min(settings.tileSize, sourceImg.cols - x),
+                                     std::min(settings.tileSize, sourceImg.rows - y)));
+        }
+    }
+
+    // Each tile is a view of sourceImg, searched and classified as its own task
+    std::vector<std::vector<CoinDetection>> tileDetections(tiles.size());
+    workerPool.parallelFor((int) tiles.size(), [&](int tileIndex) {
+        const cv::Rect &tile = tiles[tileIndex];
+        const cv::Mat tileImg = sourceImg(tile);
+        std::vector<CoinDetection> candidates = findCandidates(tileImg, settings);
+
+        // Drop candidates cut by a tile side that is not also an image border
+        std::vector<CoinDetection> &kept = tileDetections[tileIndex];
+        for (const CoinDetection &candidate : candidates) {
+            const cv::Rect &rect = candidate.boundingRect;
+            bool cut = (tile.x > 0 && rect.x < borderMargin) ||
+                       (tile.y > 0 && rect.y < borderMargin) ||
+                       (tile.x + tile.width < sourceImg.cols && rect.x + rect.width > tile.width - borderMargin) ||
+                       (tile.y + tile.height < sourceImg.rows && rect.y + rect.height > tile.height - borderMargin);
+            if (!cut) {
+                kept.push_back(candidate);
+            }
+        }
+
+        workerPool.parallelFor((int) kept.size(), [&](int candidateIndex) {
+            classifyCandidate(templateBank, settings, tileImg, kept[candidateIndex]);
+        });
+
+        // Move the detections into sourceImg coordinates
+        for (CoinDetection &candidate : kept) {
+            candidate.boundingRect.x += tile.x;
+            candidate.boundingRect.y += tile.y;
+            candidate.ellipse.center = candidate.ellipse.center + cv::Point2f((float) tile.x, (float) tile.y);
+        }
+    });
+
+    // Merge coins found by more than one tile, keeping the better classified one
+    std::vector<CoinDetection> detections;
+    for (const std::vector<CoinDetection> &tileCandidates : tileDetections) {
+        for (const CoinDetection &candidate : tileCandidates) {
+            auto duplicate = std::find_if(detections.begin(), detections.end(), [&](const CoinDetection &kept) {
+                return ellipseOverlap(kept.ellipse, candidate.ellipse) > sameCoinOverlap;
+            });
+
+            if (duplicate == detections.end()) {
+                detections.push_back(candidate);
+            } else if (std::make_pair(candidate.isCoin, candidate.matchPercent) >
+                       std::make_pair(duplicate->isCoin, duplicate->matchPercent)) {
+                *duplicate = candidate;
+            }
+        }
+    }
+
+    for (int detectionIndex = 0; detectionIndex < (int) detections.size(); detectionIndex++) {
+        detections[detectionIndex].contourIndex = detectionIndex;
+    }
+    return detections;
+}
@@ -0,0 +1,62 @@
+//==============================================================================
+// Tiled Detection
+//------------------------------------------------------------------------------
+// Detects coins in an image too large to downscale, such as a 12k x 9k 
+// flatbed tray scan, without losing the resolution small coins need. The 
+// image is cut into overlapping square tiles that are views of the source 
+// image (nothing is copied). Each tile is searched for candidates and 
+// classified as its own task, so the grayscale, blurred and edge images held 
+// at once are bounded by the tile size and the number of threads, not by the
+// image size.
+//
+// A candidate whose bounding rectangle touches a tile side that is not an 
+// image border was cut by the tile and is dropped; as long as the overlap is
+// larger than the biggest coin, the neighbouring tile holds it whole. Coins 
+// lying in the overlap are found by both tiles and merged by ellipse overlap.
+//
+// The tiles bound the working buffers, not the image itself: the pipeline 
+// still decodes every tiled scan whole, at full resolution, and holds it 
+// until detection ends (or until its previews and thumbnails are drawn, or 
+// the caller is done with it, if those need it). Each image in flight 
+// therefore costs rows x cols x 3 bytes, 324 MB for a 12k x 9k scan, plus 
+// its tile buffers; the annotated output is drawn at maxSourceDimension, 
+// never at full size. --max-in-flight caps how many such images are held at
+// once.
+//==============================================================================
+
+#ifndef TILED_DETECTION_H
+#define TILED_DETECTION_H
+
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "coinDetection.h"
+#include "detectionSettings.h"
+#include "templateBank.h"
+#include "workerPool.h"
+
+
+/*------------------------------ detectCoinsTiled ------------------------------
+ * Precondition:  A valid sourceImg is provided which has rows and cols greater 
+ *                than 0. settings.tileSize is greater than settings.tileOverlap
+ *                and templateBank has been loaded. May be called from a task 
+ *                of workerPool.
+ * Postcondition: Steps 2 to 6 of findCoins are run on every tile of sourceImg 
+ *                at full resolution, one task per tile. Returns the 
+ *                detections of all tiles in sourceImg coordinates, merged so 
+ *                each coin appears once, ordered by tile and then by contour,
+ *                with contourIndex renumbered in that order.
+ */
+std::vector<CoinDetection> detectCoinsTiled(WorkerPool &workerPool, const TemplateBank &templateBank,
+                                            const DetectionSettings &settings, const cv::Mat &sourceImg);
+
+
+/*------------------------------- ellipseOverlap -------------------------------
+ * Precondition:  None
+ * Postcondition: Returns the intersection over union, from 0 to 1, of the two
+ *                ellipses treated as circles of their mean radius.
+ */
+double ellipseOverlap(const cv::RotatedRect &a, const cv::RotatedRect &b);
+
+#endif
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include "featureClassifier.h"
+#include "imagePipeline.h"
+
+
+/* addSample
+ * Precondition: image is a BGR image of a coin, or candidate, filling it.
+ * Postcondition: The features of image are appended to features with label appended to labels.
+ */
+static void addSample(const cv::Mat &image, int label, cv::Mat &features, std::vector<int> &labels) {
+    cv::Mat row(1, coinFeatureLength, CV_32F);
+    computeCoinFeatures(image, row.ptr<float>(0));
+    features.push_back(row);
+    labels.push_back(label);
+}
+
+
+/* countCorrect
+ * Precondition: classifier is trained, and features and labels hold the samples listed in sampleIndices.
+ * Postcondition: Returns how many of those samples the classifier labels correctly, and adds the seconds it took
+ *                to seconds.
+ */
+static int countCorrect(const FeatureClassifier &classifier, const cv::Mat &features, const std::vector<int> &labels,
+                        const std::vector<int> &sampleIndices, double &seconds) {
+    cv::Mat heldOut((int) sampleIndices.size(), coinFeatureLength, CV_32F);
+    for (int row = 0; row < heldOut.rows; row++) {
+        cv::Mat heldOutRow = heldOut.row(row);
+        features.row(sampleIndices[row]).copyTo(heldOutRow);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    cv::Mat outputs;
+    classifier.predict(heldOut, outputs);
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int correct = 0;
+    for (int row = 0; row < heldOut.rows; row++) {
+        const float *scores = outputs.ptr<float>(row);
+        int best = (int) (std::max_element(scores, scores + numberOfLabels) - scores);
+        if (best == labels[sampleIndices[row]]) {
+            correct++;
+        }
+    }
+    return correct;
+}
+
+
+/* trainFeatureClassifier
+ * Precondition: templateDirectory holds the 8 template images.
+ * Postcondition: Trains a FeatureClassifier on augmented templates and the labelled crops, reports its held out 
+ *                accuracy, and saves it to modelPath.
+ */
+bool trainFeatureClassifier(const std::string &templateDirectory, const std::string &cropDirectory,
+                            const std::string &modelPath) {
+    const int rotationStep{10};
+    const double lightings[3][2] = {{1.0, 0.0}, {0.7, -20.0}, {1.3, 20.0}};     // contrast and brightness
+
+    cv::Mat features;
+    std::vector<int> labels;
+    int labelCounts[numberOfLabels] = {};
+
+    // Every template under every rotation and lighting, so a model can be trained before any crop is labelled
+    auto start = std::chrono::steady_clock::now();
+    cv::Mat rotated;
+    cv::Mat relit;
+    for (int currentCoin = 0; currentCoin < numberOfTemplates; currentCoin++) {
+        cv::Mat templateImg = cv::imread(templateDirectory + templateFileNames[currentCoin]);
+        if (templateImg.empty()) {
+            std::cout << "Could not read " << templateDirectory + templateFileNames[currentCoin] << std::endl;
+            return false;
+        }
+        cv::Point2f centre((templateImg.cols - 1) / 2.0f, (templateImg.rows - 1) / 2.0f);
+        for (int degrees = 0; degrees < 360; degrees += rotationStep) {
+            cv::warpAffine(templateImg, rotated, cv::getRotationMatrix2D(centre, degrees, 1.0), templateImg.size());
+            for (const double *lighting : lightings) {
+                rotated.convertTo(relit, -1, lighting[0], lighting[1]);
+                addSample(relit, currentCoin, features, labels);
+                labelCounts[currentCoin]++;
+            }
+        }
+    }
+
+    // Crops checked by hand, in one directory per label
+    for (int label = 0; label < numberOfLabels; label++) {
+        std::string labelDirectory = cropDirectory + cropLabelName(label);
+        if (!std::filesystem::is_directory(labelDirectory)) {
+            continue;
+        }
+        for (const auto &entry : std::filesystem::directory_iterator(labelDirectory)) {
+            if (entry.is_directory() || !isInputImage(entry.path().string())) {
+                continue;
+            }
+            cv::Mat crop = cv::imread(entry.path().string());
+            if (crop.empty()) {
+                std::cout << "Could not read " << entry.path().string() << std::endl;
+                continue;
+            }
+            addSample(crop, label, features, labels);
+            labelCounts[label]++;
+        }
+    }
+    std::chrono::duration<double> featureSeconds = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Training samples:";
+    for (int label = 0; label < numberOfLabels; label++) {
+        std::cout << " " << cropLabelName(label) << " " << labelCounts[label];
+    }
+    std::cout << std::endl;
+    if (labelCounts[notCoinLabel] == 0) {
+        std::cout << "No crops in " << cropDirectory << cropLabelName(notCoinLabel) << ", so every candidate will be "
+                  << "called a coin. Write some with --export-crops and sort them by hand." << std::endl;
+    }
+
+    // Hold out every fifth sample of a fixed shuffle to measure accuracy, then train on everything
+    std::vector<int> order(labels.size());
+    std::iota(order.begin(), order.end(), 0);
+    cv::RNG random(487);
+    for (int i = (int) order.size() - 1; i > 0; i--) {
+        std::swap(order[i], order[random.uniform(0, i + 1)]);
+    }
+    std::vector<int> trainIndices;
+    std::vector<int> heldOutIndices;
+    for (size_t i = 0; i < order.size(); i++) {
+        (i % 5 == 0 ? heldOutIndices : trainIndices).push_back(order[i]);
+    }
+
+    cv::Mat trainFeatures((int) trainIndices.size(), coinFeatureLength, CV_32F);
+    std::vector<int> trainLabels;
+    for (int row = 0; row < trainFeatures.rows; row++) {
+        cv::Mat trainRow = trainFeatures.row(row);
+        features.row(trainIndices[row]).copyTo(trainRow);
+        trainLabels.push_back(labels[trainIndices[row]]);
+    }
+
+    FeatureClassifier classifier;
+    classifier.train(trainFeatures, trainLabels);
+    double predictSeconds = 0.0;
+    int correct = countCorrect(classifier, features, labels, heldOutIndices, predictSeconds);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Held out accuracy: " << 100.0 * correct / std::max((int) heldOutIndices.size(), 1) << "% of "
+              << heldOutIndices.size() << " samples" << std::endl
+              << "Per sample: " << featureSeconds.count() * 1e6 / std::max((int) labels.size(), 1)
+              << " us features, " << predictSeconds * 1e6 / std::max((int) heldOutIndices.size(), 1)
+              << " us network" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+
+    classifier.train(features, labels);
+    if (!classifier.save(modelPath)) {
+        std::cout << "Could not write " << modelPath << std::endl;
+        return false;
+    }
+    std::cout << "Wrote " << modelPath << std::endl;
+    return true;
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "opencv2/videoio.hpp"
+
+#include "videoStream.h"
+#include "findCoins.h"
+#include "imageUtilities.h"
+#include "latencySummary.h"
+
+
+/* openCapture
+ * Precondition: None
+ * Postcondition: Opens source as a camera if it is a whole number, otherwise as a video file. Returns false if it 
+ *                could not be opened.
+ */
+static bool openCapture(const std::string &source, cv::VideoCapture &capture) {
+    if (!source.empty() && source.find_first_not_of("0123456789") == std::string::npos) {
+        return capture.open(std::stoi(source));
+    }
+    return capture.open(source);
+}
+
+
+/* printStreamSummary
+ * Precondition: latenciesMs holds the latency of each of the frames processed in elapsedSeconds.
+ * Postcondition: Prints the number of frames, the mean, median, 95th percentile and worst latency, the sustained 
+ *                frames per second and how many candidates were classified or reused.
+ */
+static void printStreamSummary(const std::vector<double> &latenciesMs, double elapsedSeconds, long classified,
+                               long reused) {
+    if (latenciesMs.empty()) {
+        std::cout << "No frames processed" << std::endl;
+        return;
+    }
+    LatencySummary latency = summarizeLatencies(latenciesMs);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Frames: " << latency.count
+              << "  Sustained FPS: " << latency.count / std::max(elapsedSeconds, 1e-9) << std::endl
+              << "Latency ms  mean: " << latency.meanMs << "  p50: " << latency.p50Ms
+              << "  p95: " << latency.p95Ms << "  max: " << latency.maxMs << std::endl
+              << "Candidates classified: " << classified << "  reused from tracking: " << reused << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+
+/* runVideoStream
+ * Precondition: source is a video file or a camera index. Must not be called from a task of workerPool.
+ * Postcondition: Every frame is detected and handed to onFrame until the source ends or onFrame returns false. 
+ *                Returns the number of frames processed, or -1 if source could not be opened.
+ */
+int runVideoStream(const std::string &source, WorkerPool &workerPool, const TemplateBank &templateBank,
+                   const DetectionSettings &detection, const StreamSettings &settings,
+                   const std::function<bool(StreamFrame &)> &onFrame) {
+
+    cv::VideoCapture capture;
+    if (!openCapture(source, capture)) {
+        std::cout << "Could not open video " << source << std::endl;
+        return -1;
+    }
+
+    // Cameras and some containers do not report a frame rate
+    double framesPerSecond = capture.get(cv::CAP_PROP_FPS);
+    if (framesPerSecond <= 0.0) {
+        framesPerSecond = 30.0;
+    }
+
+    cv::VideoWriter writer;
+    CoinTracker tracker(settings.tracker);
+    std::vector<double> latenciesMs;
+    long classified = 0;
+    long reused = 0;
+
+    auto streamStart = std::chrono::steady_clock::now();
+    StreamFrame current;
+    cv::Mat captured;
+    while (capture.read(captured)) {
+        auto frameStart = std::chrono::steady_clock::now();
+
+        current.frame = captured;
+        resizeSourceImage(captured, current.frame, maxSourceDimension);
+        current.detections = tracker.update(workerPool, templateBank, detection, current.frame);
+        current.classified = tracker.classifiedLastFrame();
+        current.reused = tracker.reusedLastFrame();
+
+        if (settings.annotate || !settings.outputPath.empty()) {
+            current.output = current.frame.clone();
+            annotateCoins(current.detections, current.output);
+        }
+
+        current.latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                                      frameStart).count();
+        latenciesMs.push_back(current.latencyMs);
+        classified += current.classified;
+        reused += current.reused;
+
+        if (!settings.outputPath.empty()) {
+            if (!writer.isOpened()) {
+                writer = cv::VideoWriter(settings.outputPath, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                                         framesPerSecond, current.output.size());
+            }
+            writer.write(current.output);
+        }
+
+        if (onFrame && !onFrame(current)) {
+            break;
+        }
+        current.index++;
+    }
+
+    double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - streamStart).count();
+    printStreamSummary(latenciesMs, elapsedSeconds, classified, reused);
+    return (int) latenciesMs.size();
+}
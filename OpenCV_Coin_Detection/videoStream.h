@@ -0,0 +1,64 @@
+//==============================================================================
+// VideoStream
+//------------------------------------------------------------------------------
+// Runs the coin detection on every frame of a cv::VideoCapture source (a 
+// video file or a camera) instead of a folder of stills. A CoinTracker 
+// carries each coin's classification from frame to frame, so the template 
+// matcher only runs on coins that are new or have changed. The latency of 
+// every frame is measured from the moment it has been read until it is 
+// annotated, and a summary with the sustained frames per second is printed 
+// when the stream ends.
+//==============================================================================
+
+#ifndef VIDEO_STREAM_H
+#define VIDEO_STREAM_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "coinDetection.h"
+#include "coinTracker.h"
+#include "detectionSettings.h"
+#include "templateBank.h"
+#include "workerPool.h"
+
+
+struct StreamSettings {
+    std::string outputPath;         // annotated video to write, none if empty
+    bool annotate{true};            // draw the output frame, needed for display and outputPath
+    TrackerSettings tracker;
+};
+
+
+// One frame as it is handed to the caller
+struct StreamFrame {
+    int index{0};                           // frame number, from 0
+    cv::Mat frame;                          // frame after it has been resized for detection
+    cv::Mat output;                         // annotated frame, empty unless annotate is set
+    std::vector<CoinDetection> detections;
+    double latencyMs{0.0};                  // from the frame being read to it being annotated
+    int classified{0};                      // candidates classifyCandidate ran on
+    int reused{0};                          // candidates that reused a tracked classification
+};
+
+
+/*-------------------------------- runVideoStream ------------------------------
+ * Precondition:  source is a video file, or a camera index such as "0". 
+ *                templateBank has been loaded. Must not be called from a task
+ *                of workerPool.
+ * Postcondition: Every frame of source is read, resized like a still image, 
+ *                passed to a CoinTracker and handed to onFrame on the calling 
+ *                thread, until the source ends or onFrame returns false. If 
+ *                settings.outputPath is set the annotated frames are written 
+ *                to it. Prints the number of frames, their latency and the 
+ *                sustained frames per second, and returns the number of 
+ *                frames processed, or -1 if source could not be opened.
+ */
+int runVideoStream(const std::string &source, WorkerPool &workerPool, const TemplateBank &templateBank,
+                   const DetectionSettings &detection, const StreamSettings &settings,
+                   const std::function<bool(StreamFrame &)> &onFrame);
+
+#endif
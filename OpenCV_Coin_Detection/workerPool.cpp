@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <exception>
+
+#include "workerPool.h"
+#include "stageTrace.h"
+
+
+// Pool and index of the worker running on this thread, if any
+static thread_local const WorkerPool *currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+
+/* TaskGroup
+ * Precondition: None
+ * Postcondition: Creates a group with no pending tasks.
+ */
+WorkerPool::TaskGroup::TaskGroup() : pending(0) {}
+
+
+/* WorkerPool
+ * Precondition: None
+ * Postcondition: Starts numThreads workers, or one per hardware thread when numThreads is 0.
+ */
+WorkerPool::WorkerPool(unsigned int numThreads) : queuedTasks(0), stopping(false) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 0; i <= numThreads; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned int i = 0; i < numThreads; i++) {
+        workers.emplace_back(&WorkerPool::workerLoop, this, (int) i);
+    }
+}
+
+
+/* ~WorkerPool
+ * Precondition: No TaskGroup is still being waited on.
+ * Postcondition: Runs every queued task, then joins the workers.
+ */
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+
+/* numThreads
+ * Precondition: None
+ * Postcondition: Returns the number of worker threads.
+ */
+int WorkerPool::numThreads() const {
+    return (int) workers.size();
+}
+
+
+/* run
+ * Precondition: group outlives the task.
+ * Postcondition: task is queued on this worker's own queue, or on the shared queue from outside the pool.
+ */
+void WorkerPool::run(TaskGroup &group, std::function<void()> task) {
+    group.pending++;
+
+    int workerIndex = currentWorkerIndex();
+    WorkQueue &queue = *queues[workerIndex >= 0 ? workerIndex : numThreads()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{std::move(task), &group});
+    }
+    queuedTasks++;
+
+    // Taking the lock orders the count update before any sleeping worker re-checks it. Every sleeper is 
+    // woken because threads waiting on a group share the condition variable with idle workers.
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wakeUp.notify_all();
+}
+
+
+/* wait
+ * Precondition: None
+ * Postcondition: Returns once every task in group has finished, running queued tasks meanwhile on a worker, then
+ *                rethrows the first exception a task threw.
+ */
+void WorkerPool::wait(TaskGroup &group) {
+    int workerIndex = currentWorkerIndex();
+
+    while (group.pending > 0) {
+        Task task;
+        if (workerIndex >= 0 && takeTask(workerIndex, task)) {
+            runTask(task);
+            continue;
+        }
+
+        // Nothing left to help with, the remaining tasks are running on other threads. runTask notifies under
+        // sleepMutex after the last of them finishes, and run after queueing a task this worker could help with.
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [&] { return group.pending == 0 || (workerIndex >= 0 && queuedTasks > 0); });
+    }
+
+    std::exception_ptr failure;
+    {
+        std::lock_guard<std::mutex> lock(group.failureMutex);
+        std::swap(failure, group.failure);
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+
+/* parallelFor
+ * Precondition: None
+ * Postcondition: body(i) has been called once for every i in [0, count).
+ */
+void WorkerPool::parallelFor(int count, const std::function<void(int)> &body) {
+    TaskGroup group;
+    for (int i = 0; i < count; i++) {
+        run(group, [&body, i] { body(i); });
+    }
+    wait(group);
+}
+
+
+/* takeTask
+ * Precondition: 0 <= workerIndex < numThreads()
+ * Postcondition: Takes the newest task from the worker's own queue, or else the oldest task from the shared queue
+ *                or another worker's queue. Returns false if every queue is empty.
+ */
+bool WorkerPool::takeTask(int workerIndex, Task &task) {
+    if (queuedTasks == 0) {
+        return false;
+    }
+
+    {
+        WorkQueue &own = *queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queuedTasks--;
+            return true;
+        }
+    }
+
+    // Steal the oldest task, first from the shared queue and then from the workers after this one
+    for (int offset = 0; offset < numThreads(); offset++) {
+        int victim = offset == 0 ? numThreads() : (workerIndex + offset) % numThreads();
+
+        WorkQueue &queue = *queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queuedTasks--;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/* runTask
+ * Precondition: task was taken from a queue.
+ * Postcondition: task has run and its group has one fewer pending task. If it threw and no earlier task of the
+ *                group did, the group keeps the exception.
+ */
+void WorkerPool::runTask(Task &task) {
+    TRACE_STAGE(taskTimer, TraceStage::task);
+    try {
+        task.function();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(task.group->failureMutex);
+        if (!task.group->failure) {
+            task.group->failure = std::current_exception();
+        }
+    }
+
+    if (--task.group->pending == 0) {
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wakeUp.notify_all();
+    }
+}
+
+
+/* workerLoop
+ * Precondition: 0 <= workerIndex < numThreads()
+ * Postcondition: Runs tasks until the pool is stopping and every queue is empty.
+ */
+void WorkerPool::workerLoop(int workerIndex) {
+    currentPool = this;
+    currentWorker = workerIndex;
+    TRACE_THREAD_NAME("worker " + std::to_string(workerIndex));
+
+    while (true) {
+        Task task;
+        if (takeTask(workerIndex, task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [&] { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks == 0) {
+            return;
+        }
+    }
+}
+
+
+/* currentWorkerIndex
+ * Precondition: None
+ * Postcondition: Returns the index of the calling worker, or -1 if the caller is not a worker of this pool.
+ */
+int WorkerPool::currentWorkerIndex() const {
+    return currentPool == this ? currentWorker : -1;
+}
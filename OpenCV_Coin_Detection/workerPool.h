@@ -0,0 +1,119 @@
+//==============================================================================
+// WorkerPool
+//------------------------------------------------------------------------------
+// A fixed number of worker threads, each with its own double ended task queue.
+// A worker takes its newest task from the back of its own queue and, when that
+// is empty, steals the oldest task from the front of another worker's queue or
+// from the shared queue that threads outside the pool submit to.
+//
+// Tasks are submitted as part of a TaskGroup and wait() blocks until every task
+// in the group has finished. A worker that waits keeps running queued tasks in
+// the meantime, so a task can split itself into smaller tasks (for example 
+// one image into one task per contour) without tying up its thread.
+//==============================================================================
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class WorkerPool {
+public:
+
+    // Tasks submitted together so they can be waited on together
+    class TaskGroup {
+    public:
+        TaskGroup();
+    private:
+        friend class WorkerPool;
+        std::atomic<int> pending;
+        std::mutex failureMutex;
+        std::exception_ptr failure;     // first exception thrown by a task, until wait() rethrows it
+    };
+
+    /*-------------------------------- WorkerPool ------------------------------
+     * Precondition:  None
+     * Postcondition: Starts numThreads worker threads, or one per hardware 
+     *                thread when numThreads is 0.
+     */
+    explicit WorkerPool(unsigned int numThreads = 0);
+
+    /*------------------------------- ~WorkerPool ------------------------------
+     * Precondition:  No TaskGroup is still being waited on.
+     * Postcondition: Runs every queued task, then joins the worker threads.
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /*-------------------------------- numThreads ------------------------------
+     * Precondition:  None
+     * Postcondition: Returns the number of worker threads.
+     */
+    int numThreads() const;
+
+    /*------------------------------------ run ---------------------------------
+     * Precondition:  group outlives the task.
+     * Postcondition: task is queued as part of group. Called from a worker it 
+     *                goes on that worker's own queue, otherwise on the shared 
+     *                queue. An exception thrown by task does not stop the pool 
+     *                or the other tasks of group, the first one is kept for 
+     *                wait() to rethrow.
+     */
+    void run(TaskGroup &group, std::function<void()> task);
+
+    /*----------------------------------- wait ---------------------------------
+     * Precondition:  None
+     * Postcondition: Returns once every task run in group has finished. When 
+     *                called from a worker, the worker runs queued tasks while it
+     *                waits. If any of the tasks threw, the first exception is 
+     *                rethrown once they have all finished, and group can be 
+     *                used again.
+     */
+    void wait(TaskGroup &group);
+
+    /*-------------------------------- parallelFor -----------------------------
+     * Precondition:  None
+     * Postcondition: body(i) has been called once for every i in [0, count), 
+     *                each as its own task. The first exception thrown by body
+     *                is rethrown once every call has finished.
+     */
+    void parallelFor(int count, const std::function<void(int)> &body);
+
+private:
+    struct Task {
+        std::function<void()> function;
+        TaskGroup *group;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool takeTask(int workerIndex, Task &task);
+    void runTask(Task &task);
+    void workerLoop(int workerIndex);
+    int currentWorkerIndex() const;
+
+    // queues[i] belongs to worker i, the last queue is shared by outside threads
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<int> queuedTasks;
+    bool stopping;
+};
+
+#endif